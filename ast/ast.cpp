@@ -42,9 +42,74 @@ TypeSpec TypeSpec::fromString(const std::string &s)
     throw std::invalid_argument("Unknown type specifier: " + s);
 }
 
-void CompUnit::addUnit(std::unique_ptr<ASTNode> u)
+/* -------------------------------- Operators ------------------------------- */
+const char *getOpSpelling(BinaryOp op)
 {
-    units.push_back(std::move(u));
+    switch (op)
+    {
+    case BinaryOp::Add:
+        return "+";
+    case BinaryOp::Sub:
+        return "-";
+    case BinaryOp::Mul:
+        return "*";
+    case BinaryOp::Div:
+        return "/";
+    case BinaryOp::Mod:
+        return "%";
+    case BinaryOp::Lt:
+        return "<";
+    case BinaryOp::Gt:
+        return ">";
+    case BinaryOp::Le:
+        return "<=";
+    case BinaryOp::Ge:
+        return ">=";
+    case BinaryOp::Eq:
+        return "==";
+    case BinaryOp::Ne:
+        return "!=";
+    case BinaryOp::BitAnd:
+        return "&";
+    case BinaryOp::BitOr:
+        return "|";
+    case BinaryOp::BitXor:
+        return "^";
+    case BinaryOp::Shl:
+        return "<<";
+    case BinaryOp::Shr:
+        return ">>";
+    case BinaryOp::LogicalAnd:
+        return "&&";
+    case BinaryOp::LogicalOr:
+        return "||";
+    }
+    return "?";
+}
+
+const char *getOpSpelling(UnaryOp op)
+{
+    switch (op)
+    {
+    case UnaryOp::Plus:
+        return "+";
+    case UnaryOp::Minus:
+        return "-";
+    case UnaryOp::LogicalNot:
+        return "!";
+    case UnaryOp::BitNot:
+        return "~";
+    case UnaryOp::PreInc:
+        return "++";
+    case UnaryOp::PreDec:
+        return "--";
+    }
+    return "?";
+}
+
+void CompUnit::addUnit(ASTNode *u)
+{
+    units.push_back(*context, u);
 }
 
 void CompUnit::dump(int indent) const
@@ -58,7 +123,7 @@ void CompUnit::dump(int indent) const
 void IdentifierExpr::dump(int indent) const
 {
     printIndent(indent);
-    std::cout << "Identifier(" << name << ")\n";
+    std::cout << "Identifier(" << name.str() << ")\n";
 }
 
 void NumberExpr::dump(int indent) const
@@ -79,6 +144,11 @@ void StringExpr::dump(int indent) const
     std::cout << "String(\"" << value << "\")\n";
 }
 
+void InitListExpr::setItem(size_t i, Expr *e)
+{
+    items.set(i, e);
+}
+
 void InitListExpr::dump(int indent) const
 {
     printIndent(indent);
@@ -87,34 +157,69 @@ void InitListExpr::dump(int indent) const
         item->dump(indent + 1);
 }
 
-void LValExpr::addIndex(std::unique_ptr<Expr> e)
+void LValExpr::addIndex(ASTContext &context, Expr *e)
+{
+    indices.push_back(context, e);
+}
+
+void LValExpr::setIndex(size_t i, Expr *e)
 {
-    indices.push_back(std::move(e));
+    indices.set(i, e);
 }
 
 void LValExpr::dump(int indent) const
 {
     printIndent(indent);
-    std::cout << "LVal(" << name << ")\n";
+    std::cout << "LVal(" << name.str() << ")\n";
     for (const auto &idx : indices)
         idx->dump(indent + 1);
 }
 
+void UnaryExpr::setRhs(Expr *e)
+{
+    rhs = e;
+}
+
 void UnaryExpr::dump(int indent) const
 {
     printIndent(indent);
-    std::cout << "Unary(" << op << ")\n";
+    std::cout << "Unary(" << getOpSpelling(op) << ")\n";
     rhs->dump(indent + 1);
 }
 
+void BinaryExpr::setLhs(Expr *e)
+{
+    lhs = e;
+}
+
+void BinaryExpr::setRhs(Expr *e)
+{
+    rhs = e;
+}
+
 void BinaryExpr::dump(int indent) const
 {
     printIndent(indent);
-    std::cout << "Binary(" << op << ")\n";
+    std::cout << "Binary(" << getOpSpelling(op) << ")\n";
     lhs->dump(indent + 1);
     rhs->dump(indent + 1);
 }
 
+void TernaryExpr::setCond(Expr *e)
+{
+    cond = e;
+}
+
+void TernaryExpr::setTrueExpr(Expr *e)
+{
+    expr1 = e;
+}
+
+void TernaryExpr::setFalseExpr(Expr *e)
+{
+    expr2 = e;
+}
+
 void TernaryExpr::dump(int indent) const
 {
     printIndent(indent);
@@ -130,19 +235,29 @@ void TernaryExpr::dump(int indent) const
     expr2->dump(indent + 2);
 }
 
-void FuncCallExpr::addArg(std::unique_ptr<Expr> e)
+void FuncCallExpr::addArg(ASTContext &context, Expr *e)
+{
+    args.push_back(context, e);
+}
+
+void FuncCallExpr::setArg(size_t i, Expr *e)
 {
-    args.push_back(std::move(e));
+    args.set(i, e);
 }
 
 void FuncCallExpr::dump(int indent) const
 {
     printIndent(indent);
-    std::cout << "FuncCall(" << name << ")\n";
+    std::cout << "FuncCall(" << name.str() << ")\n";
     for (const auto &arg : args)
         arg->dump(indent + 1);
 }
 
+void ExprStmt::setExpr(Expr *e)
+{
+    expr = e;
+}
+
 void ExprStmt::dump(int indent) const
 {
     printIndent(indent);
@@ -150,6 +265,11 @@ void ExprStmt::dump(int indent) const
     expr->dump(indent + 1);
 }
 
+void AssignStmt::setRhs(Expr *e)
+{
+    rhs = e;
+}
+
 void AssignStmt::dump(int indent) const
 {
     printIndent(indent);
@@ -158,9 +278,9 @@ void AssignStmt::dump(int indent) const
     rhs->dump(indent + 1);
 }
 
-void BlockStmt::addItem(std::unique_ptr<ASTNode> item)
+void BlockStmt::addItem(ASTContext &context, ASTNode *item)
 {
-    items.push_back(std::move(item));
+    items.push_back(context, item);
 }
 
 void BlockStmt::dump(int indent) const
@@ -171,6 +291,11 @@ void BlockStmt::dump(int indent) const
         item->dump(indent + 1);
 }
 
+void IfStmt::setCond(Expr *e)
+{
+    cond = e;
+}
+
 void IfStmt::dump(int indent) const
 {
     printIndent(indent);
@@ -189,6 +314,11 @@ void IfStmt::dump(int indent) const
     }
 }
 
+void WhileStmt::setCond(Expr *e)
+{
+    cond = e;
+}
+
 void WhileStmt::dump(int indent) const
 {
     printIndent(indent);
@@ -201,6 +331,11 @@ void WhileStmt::dump(int indent) const
     body->dump(indent + 2);
 }
 
+void ForStmt::setCond(Expr *e)
+{
+    cond = e;
+}
+
 void ForStmt::dump(int indent) const
 {
     printIndent(indent);
@@ -238,6 +373,11 @@ void ContinueStmt::dump(int indent) const
     std::cout << "ContinueStmt\n";
 }
 
+void ReturnStmt::setValue(Expr *e)
+{
+    value = e;
+}
+
 void ReturnStmt::dump(int indent) const
 {
     printIndent(indent);
@@ -246,20 +386,25 @@ void ReturnStmt::dump(int indent) const
         value->dump(indent + 1);
 }
 
-void VarDef::addDim(std::unique_ptr<Expr> e)
+void VarDef::addDim(ASTContext &context, Expr *e)
+{
+    dims.push_back(context, e);
+}
+
+void VarDef::setInit(Expr *e)
 {
-    dims.push_back(std::move(e));
+    init = e;
 }
 
-void VarDef::setInit(std::unique_ptr<Expr> e)
+void VarDef::setDim(size_t i, Expr *e)
 {
-    init = std::move(e);
+    dims.set(i, e);
 }
 
 void VarDef::dump(int indent) const
 {
     printIndent(indent);
-    std::cout << "VarDef(" << name << ")\n";
+    std::cout << "VarDef(" << name.str() << ")\n";
     for (const auto &d : dims)
         d->dump(indent + 1);
     if (init)
@@ -270,9 +415,9 @@ void VarDef::dump(int indent) const
     }
 }
 
-void VarDecl::addVar(std::unique_ptr<VarDef> v)
+void VarDecl::addVar(ASTContext &context, VarDef *v)
 {
-    vars.push_back(std::move(v));
+    vars.push_back(context, v);
 }
 
 void VarDecl::dump(int indent) const
@@ -288,33 +433,38 @@ void FuncParam::setArray()
     isArray = true;
 }
 
-void FuncParam::addDim(std::unique_ptr<Expr> e)
+void FuncParam::addDim(ASTContext &context, Expr *e)
+{
+    dims.push_back(context, e);
+}
+
+void FuncParam::setDim(size_t i, Expr *e)
 {
-    dims.push_back(std::move(e));
+    dims.set(i, e);
 }
 
 void FuncParam::dump(int indent) const
 {
     printIndent(indent);
-    std::cout << "FuncParam(" << type.toString() << " " << name << ")\n";
+    std::cout << "FuncParam(" << type.toString() << " " << name.str() << ")\n";
     for (const auto &d : dims)
         d->dump(indent + 1);
 }
 
-void FuncDef::addParam(std::unique_ptr<FuncParam> p)
+void FuncDef::addParam(ASTContext &context, FuncParam *p)
 {
-    params.push_back(std::move(p));
+    params.push_back(context, p);
 }
 
-void FuncDef::setBody(std::unique_ptr<BlockStmt> b)
+void FuncDef::setBody(BlockStmt *b)
 {
-    body = std::move(b);
+    body = b;
 }
 
 void FuncDef::dump(int indent) const
 {
     printIndent(indent);
-    std::cout << "FuncDef(" << returnType.toString() << " " << name << ")\n";
+    std::cout << "FuncDef(" << returnType.toString() << " " << name.str() << ")\n";
     printIndent(indent + 1);
     std::cout << "Params:\n";
     for (const auto &param : params)
@@ -0,0 +1,20 @@
+#include "ast_context.h"
+
+void *ASTContext::allocateSlow(size_t size, size_t align)
+{
+    // 超过半块的大对象单独分配，避免浪费当前块的剩余空间
+    size_t padded = size + align - 1;
+    if (padded > SLAB_SIZE / 2)
+    {
+        slabs.emplace_back(new char[padded]);
+        uintptr_t p = (reinterpret_cast<uintptr_t>(slabs.back().get()) + align - 1) & ~(uintptr_t)(align - 1);
+        bytesAllocated += size;
+        return reinterpret_cast<void *>(p);
+    }
+
+    // 新开一块并从其起始处分配
+    slabs.emplace_back(new char[SLAB_SIZE]);
+    cursor = slabs.back().get();
+    slabEnd = cursor + SLAB_SIZE;
+    return allocate(size, align);
+}
@@ -0,0 +1,376 @@
+#include "const_fold.h"
+
+/* -------------------------------------------------------------------------- */
+/*                                   Scope                                    */
+/* -------------------------------------------------------------------------- */
+
+std::optional<ConstantFolder::ConstValue> ConstantFolder::lookup(Identifier name) const
+{
+    for (auto it = scopes.rbegin(); it != scopes.rend(); ++it)
+    {
+        auto found = it->find(name);
+        if (found != it->end())
+            return found->second;
+    }
+    return std::nullopt;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                Expressions                                 */
+/* -------------------------------------------------------------------------- */
+
+bool ConstantFolder::getLiteralValue(const Expr *expr, int32_t &value)
+{
+    if (auto *num = dyn_cast_or_null<NumberExpr>(expr))
+    {
+        value = num->getValue();
+        return true;
+    }
+    if (auto *ch = dyn_cast_or_null<CharExpr>(expr))
+    {
+        value = static_cast<signed char>(ch->getValue());
+        return true;
+    }
+    return false;
+}
+
+Expr *ConstantFolder::makeNumber(int32_t value)
+{
+    foldCount++;
+    return context.create<NumberExpr>(value);
+}
+
+void ConstantFolder::foldIndices(LValExpr *lval)
+{
+    const auto &indices = lval->getIndices();
+    for (size_t i = 0; i < indices.size(); ++i)
+    {
+        lval->setIndex(i, foldExpr(indices[i]));
+    }
+}
+
+Expr *ConstantFolder::foldExpr(Expr *expr)
+{
+    if (!expr)
+        return nullptr;
+
+    switch (expr->getKind())
+    {
+    case NodeKind::InitListExpr:
+    {
+        auto *list = cast<InitListExpr>(expr);
+        const auto &items = list->getItems();
+        for (size_t i = 0; i < items.size(); ++i)
+        {
+            list->setItem(i, foldExpr(items[i]));
+        }
+        return list;
+    }
+    case NodeKind::LValExpr:
+    {
+        auto *lval = cast<LValExpr>(expr);
+        if (!lval->getIndices().empty())
+        {
+            foldIndices(lval);
+            return lval;
+        }
+
+        // 常量传播：const 标量替换为字面量
+        std::optional<ConstValue> constant = lookup(lval->getIdentifier());
+        if (!constant)
+            return lval;
+        if (constant->isChar)
+        {
+            foldCount++;
+            return context.create<CharExpr>(static_cast<char>(constant->value));
+        }
+        return makeNumber(constant->value);
+    }
+    case NodeKind::UnaryExpr:
+        return foldUnary(cast<UnaryExpr>(expr));
+    case NodeKind::BinaryExpr:
+        return foldBinary(cast<BinaryExpr>(expr));
+    case NodeKind::TernaryExpr:
+        return foldTernary(cast<TernaryExpr>(expr));
+    case NodeKind::FuncCallExpr:
+    {
+        auto *call = cast<FuncCallExpr>(expr);
+        const auto &args = call->getArgs();
+        for (size_t i = 0; i < args.size(); ++i)
+        {
+            call->setArg(i, foldExpr(args[i]));
+        }
+        return call;
+    }
+    default:
+        return expr;
+    }
+}
+
+Expr *ConstantFolder::foldUnary(UnaryExpr *expr)
+{
+    Expr *rhs = const_cast<Expr *>(expr->getRhs());
+
+    // ++/-- 的操作数是左值，只折叠其下标
+    if (expr->getOp() == UnaryOp::PreInc || expr->getOp() == UnaryOp::PreDec)
+    {
+        if (auto *lval = dyn_cast_or_null<LValExpr>(rhs))
+            foldIndices(lval);
+        return expr;
+    }
+
+    rhs = foldExpr(rhs);
+    expr->setRhs(rhs);
+
+    int32_t v;
+    if (!getLiteralValue(rhs, v))
+        return expr;
+
+    switch (expr->getOp())
+    {
+    case UnaryOp::Plus:
+        return makeNumber(v);
+    case UnaryOp::Minus:
+        return makeNumber(static_cast<int32_t>(0u - static_cast<uint32_t>(v)));
+    case UnaryOp::LogicalNot:
+        return makeNumber(!v);
+    case UnaryOp::BitNot:
+        return makeNumber(~v);
+    default:
+        return expr;
+    }
+}
+
+Expr *ConstantFolder::foldBinary(BinaryExpr *expr)
+{
+    Expr *lhs = foldExpr(const_cast<Expr *>(expr->getLhs()));
+    expr->setLhs(lhs);
+
+    int32_t l, r;
+    bool lhsConst = getLiteralValue(lhs, l);
+
+    // 短路：右侧不会求值，可以直接确定结果
+    if (lhsConst && expr->getOp() == BinaryOp::LogicalAnd && l == 0)
+        return makeNumber(0);
+    if (lhsConst && expr->getOp() == BinaryOp::LogicalOr && l != 0)
+        return makeNumber(1);
+
+    Expr *rhs = foldExpr(const_cast<Expr *>(expr->getRhs()));
+    expr->setRhs(rhs);
+
+    if (!lhsConst || !getLiteralValue(rhs, r))
+        return expr;
+
+    uint32_t ul = static_cast<uint32_t>(l), ur = static_cast<uint32_t>(r);
+    switch (expr->getOp())
+    {
+    case BinaryOp::Add:
+        return makeNumber(static_cast<int32_t>(ul + ur));
+    case BinaryOp::Sub:
+        return makeNumber(static_cast<int32_t>(ul - ur));
+    case BinaryOp::Mul:
+        return makeNumber(static_cast<int32_t>(ul * ur));
+    case BinaryOp::Div:
+    case BinaryOp::Mod:
+        if (r == 0 || (l == INT32_MIN && r == -1))
+            return expr;
+        return makeNumber(expr->getOp() == BinaryOp::Div ? l / r : l % r);
+    case BinaryOp::Lt:
+        return makeNumber(l < r);
+    case BinaryOp::Gt:
+        return makeNumber(l > r);
+    case BinaryOp::Le:
+        return makeNumber(l <= r);
+    case BinaryOp::Ge:
+        return makeNumber(l >= r);
+    case BinaryOp::Eq:
+        return makeNumber(l == r);
+    case BinaryOp::Ne:
+        return makeNumber(l != r);
+    case BinaryOp::BitAnd:
+        return makeNumber(l & r);
+    case BinaryOp::BitOr:
+        return makeNumber(l | r);
+    case BinaryOp::BitXor:
+        return makeNumber(l ^ r);
+    case BinaryOp::Shl:
+    case BinaryOp::Shr:
+        // 各后端对越界移位的处理不同，不折叠
+        if (r < 0 || r > 31)
+            return expr;
+        return makeNumber(expr->getOp() == BinaryOp::Shl ? static_cast<int32_t>(ul << r) : l >> r);
+    case BinaryOp::LogicalAnd:
+        return makeNumber(l && r);
+    case BinaryOp::LogicalOr:
+        return makeNumber(l || r);
+    }
+    return expr;
+}
+
+Expr *ConstantFolder::foldTernary(TernaryExpr *expr)
+{
+    Expr *cond = foldExpr(const_cast<Expr *>(expr->getCond()));
+    expr->setCond(cond);
+
+    // 条件为常量时只保留被选中的分支
+    int32_t c;
+    if (getLiteralValue(cond, c))
+    {
+        foldCount++;
+        return foldExpr(const_cast<Expr *>(c ? expr->getTrueExpr() : expr->getFalseExpr()));
+    }
+
+    expr->setTrueExpr(foldExpr(const_cast<Expr *>(expr->getTrueExpr())));
+    expr->setFalseExpr(foldExpr(const_cast<Expr *>(expr->getFalseExpr())));
+    return expr;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                            Statements / Decls                              */
+/* -------------------------------------------------------------------------- */
+
+void ConstantFolder::foldNode(ASTNode *node)
+{
+    if (!node)
+        return;
+
+    if (auto *decl = dyn_cast<VarDecl>(node))
+        foldVarDecl(decl);
+    else if (auto *stmt = dyn_cast<Stmt>(node))
+        foldStmt(stmt);
+    else if (auto *funcDef = dyn_cast<FuncDef>(node))
+        foldFuncDef(funcDef);
+}
+
+void ConstantFolder::foldStmt(Stmt *stmt)
+{
+    switch (stmt->getKind())
+    {
+    case NodeKind::ExprStmt:
+    {
+        auto *exprStmt = cast<ExprStmt>(stmt);
+        exprStmt->setExpr(foldExpr(const_cast<Expr *>(exprStmt->getExpr())));
+        break;
+    }
+    case NodeKind::AssignStmt:
+    {
+        auto *assign = cast<AssignStmt>(stmt);
+        if (assign->getLhs())
+            foldIndices(const_cast<LValExpr *>(assign->getLhs()));
+        assign->setRhs(foldExpr(const_cast<Expr *>(assign->getRhs())));
+        break;
+    }
+    case NodeKind::BlockStmt:
+    {
+        enterScope();
+        for (const auto &item : cast<BlockStmt>(stmt)->getItems())
+        {
+            foldNode(item);
+        }
+        exitScope();
+        break;
+    }
+    case NodeKind::IfStmt:
+    {
+        auto *ifStmt = cast<IfStmt>(stmt);
+        ifStmt->setCond(foldExpr(const_cast<Expr *>(ifStmt->getCond())));
+        foldNode(const_cast<Stmt *>(ifStmt->getThenStmt()));
+        foldNode(const_cast<Stmt *>(ifStmt->getElseStmt()));
+        break;
+    }
+    case NodeKind::WhileStmt:
+    {
+        auto *whileStmt = cast<WhileStmt>(stmt);
+        whileStmt->setCond(foldExpr(const_cast<Expr *>(whileStmt->getCond())));
+        foldNode(const_cast<Stmt *>(whileStmt->getBody()));
+        break;
+    }
+    case NodeKind::ForStmt:
+    {
+        // for 的初始化声明只在循环内可见
+        auto *forStmt = cast<ForStmt>(stmt);
+        enterScope();
+        foldNode(const_cast<ASTNode *>(forStmt->getInit()));
+        forStmt->setCond(foldExpr(const_cast<Expr *>(forStmt->getCond())));
+        foldNode(const_cast<ASTNode *>(forStmt->getStep()));
+        foldNode(const_cast<Stmt *>(forStmt->getBody()));
+        exitScope();
+        break;
+    }
+    case NodeKind::ReturnStmt:
+    {
+        auto *ret = cast<ReturnStmt>(stmt);
+        ret->setValue(foldExpr(const_cast<Expr *>(ret->getValue())));
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void ConstantFolder::foldVarDecl(VarDecl *decl)
+{
+    const TypeSpec &type = decl->getType();
+
+    for (const auto &varDef : decl->getVars())
+    {
+        const auto &dims = varDef->getDims();
+        for (size_t i = 0; i < dims.size(); ++i)
+        {
+            varDef->setDim(i, foldExpr(dims[i]));
+        }
+
+        Expr *init = foldExpr(const_cast<Expr *>(varDef->getInit()));
+        if (init)
+            varDef->setInit(init);
+
+        // 声明在初始化之后才可见（int x = x; 中的 x 指外层变量）
+        int32_t value;
+        if (type.isConst && dims.empty() && getLiteralValue(init, value))
+        {
+            if (type.kind == TypeSpec::CHAR)
+                declare(varDef->getIdentifier(), ConstValue{static_cast<signed char>(value), true});
+            else
+                declare(varDef->getIdentifier(), ConstValue{value, false});
+        }
+        else
+        {
+            declare(varDef->getIdentifier(), std::nullopt);
+        }
+    }
+}
+
+void ConstantFolder::foldFuncDef(FuncDef *funcDef)
+{
+    // 参数的数组维度在外层作用域中求值
+    for (const auto &param : funcDef->getParams())
+    {
+        const auto &dims = param->getDims();
+        for (size_t i = 0; i < dims.size(); ++i)
+        {
+            if (dims[i])
+                param->setDim(i, foldExpr(dims[i]));
+        }
+    }
+
+    enterScope();
+    for (const auto &param : funcDef->getParams())
+    {
+        declare(param->getIdentifier(), std::nullopt);
+    }
+    foldNode(const_cast<BlockStmt *>(funcDef->getBody()));
+    exitScope();
+}
+
+void ConstantFolder::fold(CompUnit *compUnit)
+{
+    scopes.clear();
+    enterScope(); // 全局作用域
+
+    for (const auto &unit : compUnit->getUnits())
+    {
+        foldNode(unit);
+    }
+
+    exitScope();
+}
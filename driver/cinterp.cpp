@@ -0,0 +1,496 @@
+#include "compile_cache.h"
+#include "phase_timer.h"
+#include "tiered.h"
+#include "bytecode.h"
+#include "parser.h"
+#include "lexer.h"
+#include <charconv>
+#include <iostream>
+
+/* -------------------------------------------------------------------------- */
+/*                                   Options                                  */
+/* -------------------------------------------------------------------------- */
+
+namespace
+{
+    // 在哪个阶段之后停止
+    enum class Action
+    {
+        Lex,        // -lex：只做词法分析
+        Parse,      // -parse：语法分析到 AST
+        EmitLLVM,   // -emit-llvm：输出 LLVM IR（与 -c 同用时输出 bitcode）
+        EmitObject, // -c：输出本机目标文件
+        Link,       // -o 且未指定阶段：链接为可执行文件
+        Run,        // -run（默认）：执行 main，退出码为其返回值
+    };
+
+    // -run 使用的执行引擎
+    enum class Engine
+    {
+        VM,     // 字节码虚拟机
+        JIT,    // 整个模块由 LLJIT 编译为本地代码
+        Tiered, // 先解释执行，热点函数切换到本地代码
+    };
+
+    struct Options
+    {
+        std::string input;
+        std::string output;
+        Action action = Action::Run;
+        bool actionSet = false;
+        bool emitBitcode = false; // -emit-llvm -c
+        Engine engine = Engine::Tiered;
+
+        bool hasOptLevel = false;
+        OptLevel optLevel = OptLevel::O0;
+        std::string pipeline;     // -passes，优先于 -O 级别
+        bool printStats = false;  // 输出各 pass 的统计
+        std::string cpu;
+        unsigned numThreads = 1;
+
+        bool tokenBuffer = false; // 先整体切分 token，再由语法分析器遍历
+        bool dump = false;        // 打印 token / AST
+        bool verbose = false;     // 打印 main 的返回值与输出文件
+        bool timePhases = false;  // 输出各阶段耗时与内存
+
+        bool useCache = false;
+        std::string cacheDir;
+    };
+
+    void printUsage(const char *program)
+    {
+        std::cout << "Usage: " << program << " [options] <source_file>\n"
+                  << "\nPhases (default: -run):\n"
+                  << "  -lex                Stop after lexing\n"
+                  << "  -parse              Stop after parsing\n"
+                  << "  -emit-llvm          Write LLVM IR (.ll); with -c write bitcode (.bc)\n"
+                  << "  -c                  Write a native object file (.o)\n"
+                  << "  -run                Execute main(); the exit code is its return value\n"
+                  << "  -o <file>           Output file ('-' for stdout); without a phase, link an executable\n"
+                  << "\nOptions:\n"
+                  << "  -engine=<vm|jit|tiered>  Execution engine for -run (default: tiered)\n"
+                  << "  -O0 .. -O3          Optimization level\n"
+                  << "  -passes=<pipeline>  Run a custom pass pipeline instead of -O\n"
+                  << "  -stats              Report per-pass statistics after optimization\n"
+                  << "  -mcpu=<cpu|native>  Target CPU for native code\n"
+                  << "  -j<threads>         Generate function bodies (and with -token-buffer, lex) in parallel\n"
+                  << "  -token-buffer       Tokenize the whole file before parsing\n"
+                  << "  -cache              Use the on-disk compile cache\n"
+                  << "  -cache-dir=<dir>    Use the compile cache in <dir>\n"
+                  << "  -dump               Print tokens (-lex) or the AST (-parse)\n"
+                  << "  -time-phases        Report wall/CPU time and peak memory per phase\n"
+                  << "  -v                  Print the result of main(), cache hits and written files\n";
+    }
+
+    bool setAction(Options &opts, Action action)
+    {
+        // -emit-llvm 与 -c 可以组合（输出 bitcode），其余阶段互斥
+        if (opts.actionSet && opts.action != action)
+        {
+            bool emitPair = (opts.action == Action::EmitLLVM && action == Action::EmitObject) ||
+                            (opts.action == Action::EmitObject && action == Action::EmitLLVM);
+            if (!emitPair)
+            {
+                std::cerr << "Error: Conflicting phase options" << std::endl;
+                return false;
+            }
+            opts.emitBitcode = true;
+            action = Action::EmitLLVM;
+        }
+        opts.action = action;
+        opts.actionSet = true;
+        return true;
+    }
+
+    bool parseArgs(int argc, char *argv[], Options &opts)
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            std::string arg = argv[i];
+            bool ok = true;
+            if (arg == "-lex")
+                ok = setAction(opts, Action::Lex);
+            else if (arg == "-parse")
+                ok = setAction(opts, Action::Parse);
+            else if (arg == "-emit-llvm")
+                ok = setAction(opts, Action::EmitLLVM);
+            else if (arg == "-c")
+                ok = setAction(opts, Action::EmitObject);
+            else if (arg == "-run")
+                ok = setAction(opts, Action::Run);
+            else if (arg == "-o" && i + 1 < argc)
+                opts.output = argv[++i];
+            else if (arg == "-engine=vm")
+                opts.engine = Engine::VM;
+            else if (arg == "-engine=jit")
+                opts.engine = Engine::JIT;
+            else if (arg == "-engine=tiered")
+                opts.engine = Engine::Tiered;
+            else if (arg.size() == 3 && arg[0] == '-' && arg[1] == 'O' && arg[2] >= '0' && arg[2] <= '3')
+            {
+                opts.hasOptLevel = true;
+                opts.optLevel = static_cast<OptLevel>(arg[2] - '0');
+            }
+            else if (arg.rfind("-passes=", 0) == 0)
+                opts.pipeline = arg.substr(8);
+            else if (arg == "-stats")
+                opts.printStats = true;
+            else if (arg.rfind("-mcpu=", 0) == 0)
+                opts.cpu = arg.substr(6);
+            else if (arg.rfind("-j", 0) == 0 && arg.size() > 2)
+            {
+                const char *end = arg.data() + arg.size();
+                auto [next, status] = std::from_chars(arg.data() + 2, end, opts.numThreads);
+                if (status != std::errc() || next != end || opts.numThreads == 0)
+                {
+                    std::cerr << "Error: Invalid thread count '" << arg << "'" << std::endl;
+                    return false;
+                }
+            }
+            else if (arg == "-token-buffer")
+                opts.tokenBuffer = true;
+            else if (arg == "-cache")
+                opts.useCache = true;
+            else if (arg.rfind("-cache-dir=", 0) == 0)
+            {
+                opts.useCache = true;
+                opts.cacheDir = arg.substr(11);
+            }
+            else if (arg == "-dump")
+                opts.dump = true;
+            else if (arg == "-time-phases")
+                opts.timePhases = true;
+            else if (arg == "-v")
+                opts.verbose = true;
+            else if (arg[0] != '-' && opts.input.empty())
+                opts.input = arg;
+            else
+            {
+                std::cerr << "Error: Unknown option '" << arg << "'" << std::endl;
+                return false;
+            }
+
+            if (!ok)
+                return false;
+        }
+
+        if (opts.input.empty())
+        {
+            std::cerr << "Error: No input file" << std::endl;
+            return false;
+        }
+
+        // 未指定阶段但给出了 -o：链接为可执行文件
+        if (!opts.actionSet && !opts.output.empty())
+            opts.action = Action::Link;
+        return true;
+    }
+
+    // 默认输出文件：输入文件名去掉扩展名后加上 extension
+    std::string defaultOutput(const std::string &input, const std::string &extension)
+    {
+        size_t slash = input.find_last_of('/');
+        size_t dot = input.find_last_of('.');
+        size_t stemEnd = (dot != std::string::npos && (slash == std::string::npos || dot > slash)) ? dot : input.size();
+        size_t stemBegin = slash == std::string::npos ? 0 : slash + 1;
+        return input.substr(stemBegin, stemEnd - stemBegin) + extension;
+    }
+
+    // 语义、字节码、VM 与 JIT 的错误在发生时已输出到 std::cerr，只有语法错误需要在这里输出
+    void printParseErrors(const std::vector<std::string> &errors)
+    {
+        for (const auto &error : errors)
+        {
+            std::cerr << error << std::endl;
+        }
+    }
+
+    /* ---------------------------------------------------------------------- */
+    /*                                 Driver                                 */
+    /* ---------------------------------------------------------------------- */
+
+    // -token-buffer：整体切分，-j 大于 1 时多线程切分
+    TokenBuffer tokenizeAll(const Options &opts, Lexer &lexer)
+    {
+        return opts.numThreads == 1 ? lexer.tokenize() : lexer.tokenizeParallel(opts.numThreads);
+    }
+
+    int finishRun(const Options &opts, int result)
+    {
+        if (opts.verbose)
+            std::cout << "main() returned " << result << std::endl;
+        return result;
+    }
+
+    int runDriver(const Options &opts, PhaseTimer &timer)
+    {
+        // 源文件以只读方式映射，Lexer 与 token 直接引用映射的内容
+        SourceManager sources;
+        const SourceBuffer *buffer;
+        {
+            auto phase = timer.start("read");
+            buffer = sources.load(opts.input);
+            if (!buffer)
+            {
+                std::cerr << "Error: " << sources.getError() << std::endl;
+                return 1;
+            }
+        }
+
+        if (opts.action == Action::Lex)
+        {
+            auto phase = timer.start("lex");
+            Lexer lexer(*buffer);
+            auto dumpToken = [&](const Token &token)
+            {
+                PresumedLocation loc = lexer.resolveLocation(token.location);
+                std::cout << loc.line << ":" << loc.column << "\t" << lexer.getSpelling(token) << "\n";
+            };
+
+            if (opts.tokenBuffer)
+            {
+                TokenBuffer tokens = tokenizeAll(opts, lexer);
+                for (size_t i = 0; opts.dump && tokens.kind(i) != TokenType::TOK_EOF; i++)
+                    dumpToken(tokens.get(i));
+            }
+            else
+            {
+                for (Token token = lexer.nextToken(); token.isNot(TokenType::TOK_EOF); token = lexer.nextToken())
+                {
+                    if (opts.dump)
+                        dumpToken(token);
+                }
+            }
+            return lexer.hasErrors() ? 1 : 0;
+        }
+
+        bool needsModule = opts.action == Action::EmitLLVM || opts.action == Action::EmitObject ||
+                           opts.action == Action::Link || (opts.action == Action::Run && opts.engine == Engine::JIT);
+        bool emitNative = opts.action == Action::EmitObject || opts.action == Action::Link;
+
+        // 编译缓存只用于生成 LLVM 模块的阶段；键由源码与影响输出的选项组成
+        std::unique_ptr<CompileCache> cache;
+        std::string cacheKey;
+        if (opts.useCache && needsModule)
+        {
+            cache = std::make_unique<CompileCache>(opts.cacheDir);
+            CompileCache::KeyOptions keyOptions;
+            keyOptions.optLevel = opts.hasOptLevel ? static_cast<int>(opts.optLevel) : -1;
+            keyOptions.pipeline = opts.pipeline;
+            keyOptions.native = emitNative;
+            keyOptions.cpu = opts.cpu;
+            cacheKey = CompileCache::computeKey(buffer->text(), keyOptions);
+        }
+
+        auto codegen = std::make_unique<CodeGenerator>(opts.input);
+        bool cacheHit = false;
+        if (cache && cache->contains(cacheKey, ".bc"))
+        {
+            auto phase = timer.start("cache-load");
+            cacheHit = codegen->loadBitcodeFile(cache->getPath(cacheKey, ".bc"));
+            if (cacheHit && opts.verbose)
+            {
+                std::cout << "Compile cache hit " << cacheKey << std::endl;
+            }
+            else if (!cacheHit)
+            {
+                std::cerr << "Warning: " << codegen->getErrors().back() << std::endl;
+                codegen = std::make_unique<CodeGenerator>(opts.input);
+            }
+        }
+
+        if (!cacheHit)
+        {
+            // 默认由语法分析器按需驱动词法分析，两者计入同一阶段；-token-buffer 时单独计时
+            std::unique_ptr<CompUnit> ast;
+            {
+                Lexer lexer(*buffer);
+                TokenBuffer tokens;
+                if (opts.tokenBuffer)
+                {
+                    auto phase = timer.start("lex");
+                    tokens = tokenizeAll(opts, lexer);
+                }
+
+                auto phase = timer.start("parse");
+                Parser parser(lexer, opts.tokenBuffer ? &tokens : nullptr);
+                ast = parser.parse();
+                if (parser.hasErrors())
+                {
+                    printParseErrors(parser.getErrors());
+                    return 1;
+                }
+            }
+
+            if (opts.action == Action::Parse)
+            {
+                if (opts.dump && ast)
+                    ast->dump(0);
+                return 0;
+            }
+
+            // 解释执行与分层执行从字节码开始
+            if (opts.action == Action::Run && opts.engine != Engine::JIT)
+            {
+                BytecodeCompiler compiler;
+                {
+                    auto phase = timer.start("bytecode");
+                    if (!compiler.compile(ast.get()))
+                    {
+                        return 1;
+                    }
+                }
+
+                auto phase = timer.start("run");
+                int result = 0;
+                if (opts.engine == Engine::VM)
+                {
+                    VM vm(compiler.getProgram());
+                    if (!vm.run(result))
+                    {
+                        return 1;
+                    }
+                }
+                else
+                {
+                    TieredRunner runner(ast.get(), compiler.getProgram());
+                    if (!runner.run(result))
+                    {
+                        return 1;
+                    }
+                }
+                return finishRun(opts, result);
+            }
+
+            {
+                auto phase = timer.start("codegen");
+                if (emitNative && !codegen->initializeTarget(opts.cpu))
+                {
+                    return 1;
+                }
+
+                bool generated = opts.numThreads == 1 ? codegen->generate(ast.get())
+                                                      : codegen->generateParallel(ast.get(), opts.numThreads);
+                if (!generated)
+                {
+                    return 1;
+                }
+            }
+
+            if (opts.hasOptLevel || !opts.pipeline.empty())
+            {
+                auto phase = timer.start("optimize");
+                bool optimized = opts.pipeline.empty() ? codegen->optimize(opts.optLevel)
+                                                       : codegen->runPasses(opts.pipeline);
+                if (!optimized)
+                {
+                    return 1;
+                }
+
+                // 与计时报告一样写到 stderr
+                if (opts.printStats)
+                    codegen->printOptimizationStats(std::cerr);
+            }
+
+            if (cache && !cache->store(cacheKey, ".bc", [&](const std::string &path)
+                                       { return codegen->writeBitcodeToFile(path); }))
+            {
+                std::cerr << "Warning: Cannot write compile cache in " << cache->getDirectory() << std::endl;
+            }
+        }
+
+        if (opts.action == Action::Run)
+        {
+            JitRunner runner;
+            int result = 0;
+            {
+                auto phase = timer.start("jit");
+                if (!runner.addModule(*codegen))
+                {
+                    return 1;
+                }
+            }
+
+            auto phase = timer.start("run");
+            if (!runner.run(result))
+            {
+                return 1;
+            }
+            return finishRun(opts, result);
+        }
+
+        auto phase = timer.start(opts.action == Action::Link ? "link" : "emit");
+        bool ok = true;
+        std::string output = opts.output;
+        if (opts.action == Action::EmitLLVM)
+        {
+            if (output.empty())
+                output = defaultOutput(opts.input, opts.emitBitcode ? ".bc" : ".ll");
+
+            // "-" 表示标准输出
+            ok = opts.emitBitcode ? codegen->writeBitcodeToFile(output) : codegen->writeIRToFile(output);
+        }
+        else
+        {
+            if (output.empty())
+                output = opts.action == Action::EmitObject ? defaultOutput(opts.input, ".o") : "a.out";
+
+            // 启用缓存时目标文件先写入缓存，-c 与链接都使用缓存中的目标文件
+            if (cache && !cache->contains(cacheKey, ".o"))
+            {
+                if (cacheHit && !codegen->initializeTarget(opts.cpu))
+                {
+                    return 1;
+                }
+                cache->store(cacheKey, ".o", [&](const std::string &path)
+                             { return codegen->emitObjectFile(path); });
+            }
+
+            if (cache && cache->contains(cacheKey, ".o"))
+            {
+                ok = opts.action == Action::EmitObject ? cache->copyTo(cacheKey, ".o", output)
+                                                       : codegen->linkExecutable(cache->getPath(cacheKey, ".o"), output);
+            }
+            else
+            {
+                ok = opts.action == Action::EmitObject ? codegen->emitObjectFile(output)
+                                                       : codegen->emitExecutable(output);
+            }
+        }
+
+        if (!ok)
+        {
+            std::cerr << "Error: Cannot write '" << output << "'" << std::endl;
+            return 1;
+        }
+        if (opts.verbose)
+            std::cout << "Wrote " << output << std::endl;
+        return 0;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (std::string(argv[1]) == "-help" || std::string(argv[1]) == "--help")
+    {
+        printUsage(argv[0]);
+        return 0;
+    }
+
+    Options opts;
+    if (!parseArgs(argc, argv, opts))
+        return 1;
+
+    PhaseTimer timer;
+    int status = runDriver(opts, timer);
+
+    // 报告写到 stderr，不与 -emit-llvm -o - 的输出混在一起
+    if (opts.timePhases)
+        timer.print(std::cerr);
+    return status;
+}
@@ -0,0 +1,79 @@
+#include "phase_timer.h"
+#include <algorithm>
+#include <iomanip>
+#include <sys/resource.h>
+
+namespace
+{
+    struct Usage
+    {
+        double cpuMs;
+        long peakRssKB;
+    };
+
+    Usage getUsage()
+    {
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+
+        auto toMs = [](const timeval &tv)
+        { return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0; };
+
+        // Linux 上 ru_maxrss 以 KB 为单位，macOS 上以字节为单位
+#ifdef __APPLE__
+        long peakRssKB = usage.ru_maxrss / 1024;
+#else
+        long peakRssKB = usage.ru_maxrss;
+#endif
+        return {toMs(usage.ru_utime) + toMs(usage.ru_stime), peakRssKB};
+    }
+}
+
+PhaseTimer::Phase::Phase(PhaseTimer &timer, std::string name)
+    : timer(timer), name(std::move(name)), wallStart(std::chrono::steady_clock::now()),
+      cpuStart(getUsage().cpuMs)
+{
+}
+
+PhaseTimer::Phase::~Phase()
+{
+    double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wallStart).count();
+    Usage usage = getUsage();
+    timer.records.push_back({std::move(name), wallMs, usage.cpuMs - cpuStart, usage.peakRssKB});
+}
+
+void PhaseTimer::print(std::ostream &os) const
+{
+    std::ios::fmtflags flags = os.flags();
+    std::streamsize precision = os.precision();
+
+    os << "===-------------------------------------------------------------------===\n";
+    os << "                          Phase timing report\n";
+    os << "===-------------------------------------------------------------------===\n";
+    os << std::left << std::setw(14) << "Phase" << std::right << std::setw(12) << "Wall (ms)"
+       << std::setw(12) << "CPU (ms)" << std::setw(16) << "Peak RSS (MB)" << std::setw(14) << "Delta (MB)"
+       << "\n";
+
+    double totalWall = 0, totalCpu = 0;
+    long previousRss = 0, peakRss = 0;
+    os << std::fixed;
+    for (const PhaseRecord &record : records)
+    {
+        totalWall += record.wallMs;
+        totalCpu += record.cpuMs;
+        long delta = previousRss ? record.peakRssKB - previousRss : 0;
+        previousRss = record.peakRssKB;
+        peakRss = std::max(peakRss, record.peakRssKB);
+
+        os << std::left << std::setw(14) << record.name << std::right << std::setprecision(3)
+           << std::setw(12) << record.wallMs << std::setw(12) << record.cpuMs << std::setprecision(1)
+           << std::setw(16) << record.peakRssKB / 1024.0 << std::setw(14) << delta / 1024.0 << "\n";
+    }
+
+    os << std::left << std::setw(14) << "Total" << std::right << std::setprecision(3) << std::setw(12)
+       << totalWall << std::setw(12) << totalCpu << std::setprecision(1) << std::setw(16) << peakRss / 1024.0
+       << "\n";
+
+    os.flags(flags);
+    os.precision(precision);
+}
@@ -1,13 +1,15 @@
 #ifndef AST_H
 #define AST_H
 
+#include "ast_context.h"
+#include "identifier.h"
+#include <cassert>
+#include <cstdint>
 #include <memory>
 #include <vector>
 #include <string>
 #include <iostream>
 
-static void printIndent(int indent);
-
 struct TypeSpec
 {
     enum Kind
@@ -28,27 +30,192 @@ struct TypeSpec
     static TypeSpec fromString(const std::string &s);
 };
 
+/* -------------------------------------------------------------------------- */
+/*                                  Operators                                 */
+/* -------------------------------------------------------------------------- */
+
+// 二元运算符（由语法分析器从 TokenType 直接转换）
+enum class BinaryOp : uint8_t
+{
+    Add,        // +
+    Sub,        // -
+    Mul,        // *
+    Div,        // /
+    Mod,        // %
+    Lt,         // <
+    Gt,         // >
+    Le,         // <=
+    Ge,         // >=
+    Eq,         // ==
+    Ne,         // !=
+    BitAnd,     // &
+    BitOr,      // |
+    BitXor,     // ^
+    Shl,        // <<
+    Shr,        // >>
+    LogicalAnd, // &&
+    LogicalOr   // ||
+};
+
+// 一元运算符
+enum class UnaryOp : uint8_t
+{
+    Plus,       // +
+    Minus,      // -
+    LogicalNot, // !
+    BitNot,     // ~
+    PreInc,     // ++
+    PreDec      // --
+};
+
+// 运算符的源码拼写（用于输出与错误信息）
+const char *getOpSpelling(BinaryOp op);
+const char *getOpSpelling(UnaryOp op);
+
 /* -------------------------------------------------------------------------- */
 /*                               AST base class                               */
 /* -------------------------------------------------------------------------- */
+/**
+ * 节点种类
+ * 每个节点在构造时记录自己的种类，isa/cast/dyn_cast 与 ASTVisitor
+ * 据此分派，不依赖 RTTI。同一基类的种类连续排列，基类按区间判断。
+ */
+enum class NodeKind : uint8_t
+{
+    CompUnit,
+
+    // Expr
+    IdentifierExpr,
+    NumberExpr,
+    CharExpr,
+    StringExpr,
+    InitListExpr,
+    LValExpr,
+    UnaryExpr,
+    BinaryExpr,
+    TernaryExpr,
+    FuncCallExpr,
+
+    // Stmt
+    ExprStmt,
+    AssignStmt,
+    BlockStmt,
+    IfStmt,
+    WhileStmt,
+    ForStmt,
+    BreakStmt,
+    ContinueStmt,
+    ReturnStmt,
+
+    // Decl
+    VarDecl,
+
+    VarDef,
+    FuncParam,
+    FuncDef,
+
+    FirstExpr = IdentifierExpr,
+    LastExpr = FuncCallExpr,
+    FirstStmt = ExprStmt,
+    LastStmt = ReturnStmt,
+    FirstDecl = VarDecl,
+    LastDecl = VarDecl
+};
+
+/**
+ * 节点由 ASTContext 分配并随其整体释放，从不单独 delete，
+ * 因此析构函数是非虚且平凡的
+ */
 class ASTNode
 {
+private:
+    const NodeKind kind;
+
+protected:
+    explicit ASTNode(NodeKind k) : kind(k) {}
+    ~ASTNode() = default;
+
 public:
-    virtual ~ASTNode() = default;
+    NodeKind getKind() const { return kind; }
     virtual void dump(int indent = 0) const = 0;
 };
 
+/* -------------------------------------------------------------------------- */
+/*                              isa / cast / dyn_cast                         */
+/* -------------------------------------------------------------------------- */
+
+// 与 LLVM 的同名模板一致：依赖各节点类的 static classof(const ASTNode *)
+template <typename To, typename From>
+inline bool isa(const From *node)
+{
+    assert(node && "isa<> used on a null pointer");
+    return To::classof(node);
+}
+
+template <typename To, typename From>
+inline bool isa_and_nonnull(const From *node)
+{
+    return node && To::classof(node);
+}
+
+template <typename To, typename From>
+inline To *cast(From *node)
+{
+    assert(isa<To>(node) && "cast<Ty>() argument of incompatible type!");
+    return static_cast<To *>(node);
+}
+
+template <typename To, typename From>
+inline const To *cast(const From *node)
+{
+    assert(isa<To>(node) && "cast<Ty>() argument of incompatible type!");
+    return static_cast<const To *>(node);
+}
+
+template <typename To, typename From>
+inline To *dyn_cast(From *node)
+{
+    return isa<To>(node) ? static_cast<To *>(node) : nullptr;
+}
+
+template <typename To, typename From>
+inline const To *dyn_cast(const From *node)
+{
+    return isa<To>(node) ? static_cast<const To *>(node) : nullptr;
+}
+
+template <typename To, typename From>
+inline To *dyn_cast_or_null(From *node)
+{
+    return isa_and_nonnull<To>(node) ? static_cast<To *>(node) : nullptr;
+}
+
+template <typename To, typename From>
+inline const To *dyn_cast_or_null(const From *node)
+{
+    return isa_and_nonnull<To>(node) ? static_cast<const To *>(node) : nullptr;
+}
+
 /* -------------------------------------------------------------------------- */
 /*                         Top-level compilation unit                         */
 /* -------------------------------------------------------------------------- */
-class CompUnit : public ASTNode
+/**
+ * 编译单元是整棵树的根，本身不在 arena 中：
+ * 它持有 ASTContext，释放编译单元即一次性释放所有节点
+ */
+class CompUnit final : public ASTNode
 {
 private:
-    std::vector<std::unique_ptr<ASTNode>> units;
+    std::unique_ptr<ASTContext> context;
+    ASTList<ASTNode *> units;
 
 public:
-    const std::vector<std::unique_ptr<ASTNode>> &getUnits() const { return units; }
-    void addUnit(std::unique_ptr<ASTNode> u);
+    static bool classof(const ASTNode *node) { return node->getKind() == NodeKind::CompUnit; }
+    explicit CompUnit(std::unique_ptr<ASTContext> ctx) : ASTNode(NodeKind::CompUnit), context(std::move(ctx)) {}
+    ASTContext &getContext() const { return *context; }
+    const ASTList<ASTNode *> &getUnits() const { return units; }
+    const std::shared_ptr<IdentifierTable> &getIdentifierTable() const { return context->getIdentifierTable(); }
+    void addUnit(ASTNode *u);
     void dump(int indent) const override;
 };
 
@@ -57,17 +224,27 @@ public:
 /* -------------------------------------------------------------------------- */
 class Expr : public ASTNode
 {
+protected:
+    explicit Expr(NodeKind k) : ASTNode(k) {}
+
+public:
+    static bool classof(const ASTNode *node)
+    {
+        return node->getKind() >= NodeKind::FirstExpr && node->getKind() <= NodeKind::LastExpr;
+    }
 };
 
 /* ------------------------------- Identifier ------------------------------- */
 class IdentifierExpr : public Expr
 {
 private:
-    std::string name;
+    Identifier name;
 
 public:
-    IdentifierExpr(std::string n) : name(std::move(n)) {}
-    const std::string &getName() const { return name; }
+    static bool classof(const ASTNode *node) { return node->getKind() == NodeKind::IdentifierExpr; }
+    IdentifierExpr(Identifier n) : Expr(NodeKind::IdentifierExpr), name(n) {}
+    const std::string &getName() const { return name.str(); }
+    Identifier getIdentifier() const { return name; }
     void dump(int indent) const override;
 };
 
@@ -78,7 +255,8 @@ private:
     int value;
 
 public:
-    NumberExpr(int v) : value(v) {}
+    static bool classof(const ASTNode *node) { return node->getKind() == NodeKind::NumberExpr; }
+    NumberExpr(int v) : Expr(NodeKind::NumberExpr), value(v) {}
     int getValue() const { return value; }
     void dump(int indent) const override;
 };
@@ -90,7 +268,8 @@ private:
     char value;
 
 public:
-    CharExpr(char v) : value(v) {}
+    static bool classof(const ASTNode *node) { return node->getKind() == NodeKind::CharExpr; }
+    CharExpr(char v) : Expr(NodeKind::CharExpr), value(v) {}
     char getValue() const { return value; }
     void dump(int indent) const override;
 };
@@ -99,11 +278,12 @@ public:
 class StringExpr : public Expr
 {
 private:
-    std::string value;
+    const std::string *value; // 保存在 ASTContext 中
 
 public:
-    StringExpr(std::string v) : value(std::move(v)) {}
-    const std::string &getValue() const { return value; }
+    static bool classof(const ASTNode *node) { return node->getKind() == NodeKind::StringExpr; }
+    StringExpr(const std::string &v) : Expr(NodeKind::StringExpr), value(&v) {}
+    const std::string &getValue() const { return *value; }
     void dump(int indent) const override;
 };
 
@@ -111,11 +291,14 @@ public:
 class InitListExpr : public Expr
 {
 private:
-    std::vector<std::unique_ptr<Expr>> items;
+    ASTList<Expr *> items;
 
 public:
-    void addItem(std::unique_ptr<Expr> e) { items.push_back(std::move(e)); }
-    const std::vector<std::unique_ptr<Expr>> &getItems() const { return items; }
+    static bool classof(const ASTNode *node) { return node->getKind() == NodeKind::InitListExpr; }
+    InitListExpr() : Expr(NodeKind::InitListExpr) {}
+    void addItem(ASTContext &context, Expr *e) { items.push_back(context, e); }
+    const ASTList<Expr *> &getItems() const { return items; }
+    void setItem(size_t i, Expr *e);
     void dump(int indent) const override;
 };
 
@@ -123,18 +306,21 @@ public:
 class LValExpr : public Expr
 {
 private:
-    std::string name;
+    Identifier name;
     /**
      * 数组下标列表
      * 将[]中的表达式依次存入该列表
      */
-    std::vector<std::unique_ptr<Expr>> indices;
+    ASTList<Expr *> indices;
 
 public:
-    LValExpr(std::string n) : name(std::move(n)) {}
-    const std::string &getName() const { return name; }
-    const std::vector<std::unique_ptr<Expr>> &getIndices() const { return indices; }
-    void addIndex(std::unique_ptr<Expr> e);
+    static bool classof(const ASTNode *node) { return node->getKind() == NodeKind::LValExpr; }
+    LValExpr(Identifier n) : Expr(NodeKind::LValExpr), name(n) {}
+    const std::string &getName() const { return name.str(); }
+    Identifier getIdentifier() const { return name; }
+    const ASTList<Expr *> &getIndices() const { return indices; }
+    void addIndex(ASTContext &context, Expr *e);
+    void setIndex(size_t i, Expr *e);
     void dump(int indent) const override;
 };
 
@@ -142,14 +328,16 @@ public:
 class UnaryExpr : public Expr
 {
 private:
-    std::string op;
-    std::unique_ptr<Expr> rhs;
+    UnaryOp op;
+    Expr *rhs = nullptr;
 
 public:
-    UnaryExpr(std::string o, std::unique_ptr<Expr> r)
-        : op(std::move(o)), rhs(std::move(r)) {}
-    const std::string &getOp() const { return op; }
-    const Expr *getRhs() const { return rhs.get(); }
+    static bool classof(const ASTNode *node) { return node->getKind() == NodeKind::UnaryExpr; }
+    UnaryExpr(UnaryOp o, Expr *r)
+        : Expr(NodeKind::UnaryExpr), op(o), rhs(r) {}
+    UnaryOp getOp() const { return op; }
+    const Expr *getRhs() const { return rhs; }
+    void setRhs(Expr *e);
     void dump(int indent) const override;
 };
 
@@ -157,17 +345,19 @@ public:
 class BinaryExpr : public Expr
 {
 private:
-    std::string op;
-    std::unique_ptr<Expr> lhs;
-    std::unique_ptr<Expr> rhs;
+    BinaryOp op;
+    Expr *lhs = nullptr;
+    Expr *rhs = nullptr;
 
 public:
-    BinaryExpr(std::unique_ptr<Expr> l, std::string o,
-               std::unique_ptr<Expr> r)
-        : op(std::move(o)), lhs(std::move(l)), rhs(std::move(r)) {}
-    const std::string &getOp() const { return op; }
-    const Expr *getLhs() const { return lhs.get(); }
-    const Expr *getRhs() const { return rhs.get(); }
+    static bool classof(const ASTNode *node) { return node->getKind() == NodeKind::BinaryExpr; }
+    BinaryExpr(Expr *l, BinaryOp o, Expr *r)
+        : Expr(NodeKind::BinaryExpr), op(o), lhs(l), rhs(r) {}
+    BinaryOp getOp() const { return op; }
+    const Expr *getLhs() const { return lhs; }
+    const Expr *getRhs() const { return rhs; }
+    void setLhs(Expr *e);
+    void setRhs(Expr *e);
     void dump(int indent) const override;
 };
 
@@ -175,17 +365,20 @@ public:
 class TernaryExpr : public Expr // 实现三元表达式: cond ? expr1 : expr2
 {
 private:
-    std::unique_ptr<Expr> cond;
-    std::unique_ptr<Expr> expr1;
-    std::unique_ptr<Expr> expr2;
+    Expr *cond = nullptr;
+    Expr *expr1 = nullptr;
+    Expr *expr2 = nullptr;
 
 public:
-    TernaryExpr(std::unique_ptr<Expr> c, std::unique_ptr<Expr> e1,
-                std::unique_ptr<Expr> e2)
-        : cond(std::move(c)), expr1(std::move(e1)), expr2(std::move(e2)) {}
-    const Expr *getCond() const { return cond.get(); }
-    const Expr *getTrueExpr() const { return expr1.get(); }
-    const Expr *getFalseExpr() const { return expr2.get(); }
+    static bool classof(const ASTNode *node) { return node->getKind() == NodeKind::TernaryExpr; }
+    TernaryExpr(Expr *c, Expr *e1, Expr *e2)
+        : Expr(NodeKind::TernaryExpr), cond(c), expr1(e1), expr2(e2) {}
+    const Expr *getCond() const { return cond; }
+    const Expr *getTrueExpr() const { return expr1; }
+    const Expr *getFalseExpr() const { return expr2; }
+    void setCond(Expr *e);
+    void setTrueExpr(Expr *e);
+    void setFalseExpr(Expr *e);
     void dump(int indent) const override;
 };
 
@@ -193,18 +386,21 @@ public:
 class FuncCallExpr : public Expr
 {
 private:
-    std::string name;
+    Identifier name;
     /**
      * 函数调用参数列表
      * 将函数调用中的实参依次存入args列表中
      */
-    std::vector<std::unique_ptr<Expr>> args;
+    ASTList<Expr *> args;
 
 public:
-    FuncCallExpr(std::string n) : name(std::move(n)) {}
-    const std::string &getName() const { return name; }
-    const std::vector<std::unique_ptr<Expr>> &getArgs() const { return args; }
-    void addArg(std::unique_ptr<Expr> e);
+    static bool classof(const ASTNode *node) { return node->getKind() == NodeKind::FuncCallExpr; }
+    FuncCallExpr(Identifier n) : Expr(NodeKind::FuncCallExpr), name(n) {}
+    const std::string &getName() const { return name.str(); }
+    Identifier getIdentifier() const { return name; }
+    const ASTList<Expr *> &getArgs() const { return args; }
+    void addArg(ASTContext &context, Expr *e);
+    void setArg(size_t i, Expr *e);
     void dump(int indent) const override;
 };
 
@@ -213,17 +409,27 @@ public:
 /* -------------------------------------------------------------------------- */
 class Stmt : public ASTNode
 {
+protected:
+    explicit Stmt(NodeKind k) : ASTNode(k) {}
+
+public:
+    static bool classof(const ASTNode *node)
+    {
+        return node->getKind() >= NodeKind::FirstStmt && node->getKind() <= NodeKind::LastStmt;
+    }
 };
 
 /* -------------------------- Expression statement -------------------------- */
 class ExprStmt : public Stmt
 {
 private:
-    std::unique_ptr<Expr> expr;
+    Expr *expr = nullptr;
 
 public:
-    ExprStmt(std::unique_ptr<Expr> e) : expr(std::move(e)) {}
-    const Expr *getExpr() const { return expr.get(); }
+    static bool classof(const ASTNode *node) { return node->getKind() == NodeKind::ExprStmt; }
+    ExprStmt(Expr *e) : Stmt(NodeKind::ExprStmt), expr(e) {}
+    const Expr *getExpr() const { return expr; }
+    void setExpr(Expr *e);
     void dump(int indent) const override;
 };
 
@@ -231,14 +437,16 @@ public:
 class AssignStmt : public Stmt
 {
 private:
-    std::unique_ptr<LValExpr> lhs;
-    std::unique_ptr<Expr> rhs;
+    LValExpr *lhs = nullptr;
+    Expr *rhs = nullptr;
 
 public:
-    AssignStmt(std::unique_ptr<LValExpr> l, std::unique_ptr<Expr> r)
-        : lhs(std::move(l)), rhs(std::move(r)) {}
-    const LValExpr *getLhs() const { return lhs.get(); }
-    const Expr *getRhs() const { return rhs.get(); }
+    static bool classof(const ASTNode *node) { return node->getKind() == NodeKind::AssignStmt; }
+    AssignStmt(LValExpr *l, Expr *r)
+        : Stmt(NodeKind::AssignStmt), lhs(l), rhs(r) {}
+    const LValExpr *getLhs() const { return lhs; }
+    const Expr *getRhs() const { return rhs; }
+    void setRhs(Expr *e);
     void dump(int indent) const override;
 };
 
@@ -246,11 +454,13 @@ public:
 class BlockStmt : public Stmt
 {
 private:
-    std::vector<std::unique_ptr<ASTNode>> items; // Decl 或 Stmtc
+    ASTList<ASTNode *> items; // Decl 或 Stmtc
 
 public:
-    const std::vector<std::unique_ptr<ASTNode>> &getItems() const { return items; }
-    void addItem(std::unique_ptr<ASTNode> item);
+    static bool classof(const ASTNode *node) { return node->getKind() == NodeKind::BlockStmt; }
+    BlockStmt() : Stmt(NodeKind::BlockStmt) {}
+    const ASTList<ASTNode *> &getItems() const { return items; }
+    void addItem(ASTContext &context, ASTNode *item);
     void dump(int indent) const override;
 };
 
@@ -258,16 +468,18 @@ public:
 class IfStmt : public Stmt
 {
 private:
-    std::unique_ptr<Expr> cond;
-    std::unique_ptr<Stmt> thenStmt;
-    std::unique_ptr<Stmt> elseStmt; // else 语句可选
+    Expr *cond = nullptr;
+    Stmt *thenStmt = nullptr;
+    Stmt *elseStmt = nullptr; // else 语句可选
 
 public:
-    IfStmt(std::unique_ptr<Expr> c, std::unique_ptr<Stmt> t, std::unique_ptr<Stmt> e = nullptr)
-        : cond(std::move(c)), thenStmt(std::move(t)), elseStmt(std::move(e)) {}
-    const Expr *getCond() const { return cond.get(); }
-    const Stmt *getThenStmt() const { return thenStmt.get(); }
-    const Stmt *getElseStmt() const { return elseStmt.get(); }
+    static bool classof(const ASTNode *node) { return node->getKind() == NodeKind::IfStmt; }
+    IfStmt(Expr *c, Stmt *t, Stmt *e = nullptr)
+        : Stmt(NodeKind::IfStmt), cond(c), thenStmt(t), elseStmt(e) {}
+    const Expr *getCond() const { return cond; }
+    const Stmt *getThenStmt() const { return thenStmt; }
+    const Stmt *getElseStmt() const { return elseStmt; }
+    void setCond(Expr *e);
     void dump(int indent) const override;
 };
 
@@ -275,15 +487,17 @@ public:
 class WhileStmt : public Stmt
 {
 private:
-    std::unique_ptr<Expr> cond;
-    std::unique_ptr<Stmt> body;
+    Expr *cond = nullptr;
+    Stmt *body = nullptr;
 
 public:
-    WhileStmt() {}
-    WhileStmt(std::unique_ptr<Expr> c, std::unique_ptr<Stmt> b)
-        : cond(std::move(c)), body(std::move(b)) {}
-    const Expr *getCond() const { return cond.get(); }
-    const Stmt *getBody() const { return body.get(); }
+    static bool classof(const ASTNode *node) { return node->getKind() == NodeKind::WhileStmt; }
+    WhileStmt() : Stmt(NodeKind::WhileStmt) {}
+    WhileStmt(Expr *c, Stmt *b)
+        : Stmt(NodeKind::WhileStmt), cond(c), body(b) {}
+    const Expr *getCond() const { return cond; }
+    const Stmt *getBody() const { return body; }
+    void setCond(Expr *e);
     void dump(int indent) const override;
 };
 
@@ -291,19 +505,21 @@ public:
 class ForStmt : public Stmt
 {
 private:
-    std::unique_ptr<ASTNode> init; // 可能是 Decl 或 Stmt (ExprStmt/AssignStmt)
-    std::unique_ptr<Expr> cond;
-    std::unique_ptr<ASTNode> step; // 可能是 Stmt (ExprStmt/AssignStmt)
-    std::unique_ptr<Stmt> body;
+    ASTNode *init = nullptr; // 可能是 Decl 或 Stmt (ExprStmt/AssignStmt)
+    Expr *cond = nullptr;
+    ASTNode *step = nullptr; // 可能是 Stmt (ExprStmt/AssignStmt)
+    Stmt *body = nullptr;
 
 public:
-    ForStmt() {}
-    ForStmt(std::unique_ptr<ASTNode> i, std::unique_ptr<Expr> c, std::unique_ptr<ASTNode> s, std::unique_ptr<Stmt> b)
-        : init(std::move(i)), cond(std::move(c)), step(std::move(s)), body(std::move(b)) {}
-    const ASTNode *getInit() const { return init.get(); }
-    const Expr *getCond() const { return cond.get(); }
-    const ASTNode *getStep() const { return step.get(); }
-    const Stmt *getBody() const { return body.get(); }
+    static bool classof(const ASTNode *node) { return node->getKind() == NodeKind::ForStmt; }
+    ForStmt() : Stmt(NodeKind::ForStmt) {}
+    ForStmt(ASTNode *i, Expr *c, ASTNode *s, Stmt *b)
+        : Stmt(NodeKind::ForStmt), init(i), cond(c), step(s), body(b) {}
+    const ASTNode *getInit() const { return init; }
+    const Expr *getCond() const { return cond; }
+    const ASTNode *getStep() const { return step; }
+    const Stmt *getBody() const { return body; }
+    void setCond(Expr *e);
     void dump(int indent) const override;
 };
 
@@ -311,6 +527,8 @@ public:
 class BreakStmt : public Stmt
 {
 public:
+    static bool classof(const ASTNode *node) { return node->getKind() == NodeKind::BreakStmt; }
+    BreakStmt() : Stmt(NodeKind::BreakStmt) {}
     void dump(int indent) const override;
 };
 
@@ -318,6 +536,8 @@ public:
 class ContinueStmt : public Stmt
 {
 public:
+    static bool classof(const ASTNode *node) { return node->getKind() == NodeKind::ContinueStmt; }
+    ContinueStmt() : Stmt(NodeKind::ContinueStmt) {}
     void dump(int indent) const override;
 };
 
@@ -325,11 +545,13 @@ public:
 class ReturnStmt : public Stmt
 {
 private:
-    std::unique_ptr<Expr> value;
+    Expr *value = nullptr;
 
 public:
-    ReturnStmt(std::unique_ptr<Expr> v) : value(std::move(v)) {}
-    const Expr *getValue() const { return value.get(); }
+    static bool classof(const ASTNode *node) { return node->getKind() == NodeKind::ReturnStmt; }
+    ReturnStmt(Expr *v) : Stmt(NodeKind::ReturnStmt), value(v) {}
+    const Expr *getValue() const { return value; }
+    void setValue(Expr *e);
     void dump(int indent) const override;
 };
 /* -------------------------------------------------------------------------- */
@@ -337,27 +559,38 @@ public:
 /* -------------------------------------------------------------------------- */
 class Decl : public ASTNode
 {
+protected:
+    explicit Decl(NodeKind k) : ASTNode(k) {}
+
+public:
+    static bool classof(const ASTNode *node)
+    {
+        return node->getKind() >= NodeKind::FirstDecl && node->getKind() <= NodeKind::LastDecl;
+    }
 };
 
 /* ------------------------------- Var define ------------------------------- */
 class VarDef : public ASTNode
 {
 private:
-    std::string name;
+    Identifier name;
     /**
      * 数组维度表达式列表
      * 将变量定义中的每个维度表达式依次存入dims列表中
      */
-    std::vector<std::unique_ptr<Expr>> dims;
-    std::unique_ptr<Expr> init; // 可选的初始化表达式
+    ASTList<Expr *> dims;
+    Expr *init = nullptr; // 可选的初始化表达式
 
 public:
-    VarDef(std::string n) : name(std::move(n)) {}
-    const std::string &getName() const { return name; }
-    const std::vector<std::unique_ptr<Expr>> &getDims() const { return dims; }
-    const Expr *getInit() const { return init.get(); }
-    void addDim(std::unique_ptr<Expr> e);
-    void setInit(std::unique_ptr<Expr> e);
+    static bool classof(const ASTNode *node) { return node->getKind() == NodeKind::VarDef; }
+    VarDef(Identifier n) : ASTNode(NodeKind::VarDef), name(n) {}
+    const std::string &getName() const { return name.str(); }
+    Identifier getIdentifier() const { return name; }
+    const ASTList<Expr *> &getDims() const { return dims; }
+    const Expr *getInit() const { return init; }
+    void addDim(ASTContext &context, Expr *e);
+    void setInit(Expr *e);
+    void setDim(size_t i, Expr *e);
     void dump(int indent) const override;
 };
 
@@ -370,13 +603,14 @@ private:
      * 变量定义列表
      * 将变量声明中的每个变量定义依次存入vars列表中
      */
-    std::vector<std::unique_ptr<VarDef>> vars;
+    ASTList<VarDef *> vars;
 
 public:
-    VarDecl(TypeSpec t) : type(std::move(t)) {}
+    static bool classof(const ASTNode *node) { return node->getKind() == NodeKind::VarDecl; }
+    VarDecl(TypeSpec t) : Decl(NodeKind::VarDecl), type(std::move(t)) {}
     const TypeSpec &getType() const { return type; }
-    const std::vector<std::unique_ptr<VarDef>> &getVars() const { return vars; }
-    void addVar(std::unique_ptr<VarDef> v);
+    const ASTList<VarDef *> &getVars() const { return vars; }
+    void addVar(ASTContext &context, VarDef *v);
     void dump(int indent) const override;
 };
 
@@ -389,18 +623,21 @@ class FuncParam : public ASTNode
 {
 private:
     TypeSpec type;
-    std::string name;
-    bool isArray = false;                    // 是否为数组参数
-    std::vector<std::unique_ptr<Expr>> dims; // 数组维度表达式列表
+    Identifier name;
+    bool isArray = false; // 是否为数组参数
+    ASTList<Expr *> dims; // 数组维度表达式列表
 public:
-    FuncParam(TypeSpec t, std::string n)
-        : type(std::move(t)), name(std::move(n)) {}
+    static bool classof(const ASTNode *node) { return node->getKind() == NodeKind::FuncParam; }
+    FuncParam(TypeSpec t, Identifier n)
+        : ASTNode(NodeKind::FuncParam), type(std::move(t)), name(n) {}
     const TypeSpec &getType() const { return type; }
-    const std::string &getName() const { return name; }
+    const std::string &getName() const { return name.str(); }
+    Identifier getIdentifier() const { return name; }
     bool getIsArray() const { return isArray; }
-    const std::vector<std::unique_ptr<Expr>> &getDims() const { return dims; }
+    const ASTList<Expr *> &getDims() const { return dims; }
     void setArray();
-    void addDim(std::unique_ptr<Expr> e);
+    void addDim(ASTContext &context, Expr *e);
+    void setDim(size_t i, Expr *e);
     void dump(int indent) const override;
 };
 
@@ -409,23 +646,25 @@ class FuncDef : public ASTNode
 {
 private:
     TypeSpec returnType;
-    std::string name;
+    Identifier name;
     /**
      * 函数参数列表
      * 将函数定义中的每个参数依次存入params列表中
      */
-    std::vector<std::unique_ptr<FuncParam>> params;
-    std::unique_ptr<BlockStmt> body;
+    ASTList<FuncParam *> params;
+    BlockStmt *body = nullptr;
 
 public:
-    FuncDef(TypeSpec retType, std::string n)
-        : returnType(std::move(retType)), name(std::move(n)) {}
+    static bool classof(const ASTNode *node) { return node->getKind() == NodeKind::FuncDef; }
+    FuncDef(TypeSpec retType, Identifier n)
+        : ASTNode(NodeKind::FuncDef), returnType(std::move(retType)), name(n) {}
     const TypeSpec &getReturnType() const { return returnType; }
-    const std::string &getName() const { return name; }
-    const std::vector<std::unique_ptr<FuncParam>> &getParams() const { return params; }
-    const BlockStmt *getBody() const { return body.get(); }
-    void addParam(std::unique_ptr<FuncParam> p);
-    void setBody(std::unique_ptr<BlockStmt> b);
+    const std::string &getName() const { return name.str(); }
+    Identifier getIdentifier() const { return name; }
+    const ASTList<FuncParam *> &getParams() const { return params; }
+    const BlockStmt *getBody() const { return body; }
+    void addParam(ASTContext &context, FuncParam *p);
+    void setBody(BlockStmt *b);
     void dump(int indent) const override;
 };
 
@@ -0,0 +1,140 @@
+#ifndef AST_CONTEXT_H
+#define AST_CONTEXT_H
+
+#include "identifier.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+class ASTContext;
+
+/* -------------------------------------------------------------------------- */
+/*                                  AST List                                  */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * 存放在 ASTContext 中的变长数组（子节点列表）
+ * 扩容时在 arena 中重新分配并拷贝，旧空间随 arena 一起释放；
+ * 本身平凡可析构，因此可以作为 arena 节点的成员。
+ */
+template <typename T>
+class ASTList
+{
+    static_assert(std::is_trivially_copyable<T>::value, "ASTList only holds trivially copyable values");
+
+private:
+    T *data_ = nullptr;
+    uint32_t size_ = 0;
+    uint32_t capacity_ = 0;
+
+public:
+    using value_type = T;
+    using const_iterator = const T *;
+    using const_reverse_iterator = std::reverse_iterator<const T *>;
+
+    void push_back(ASTContext &context, T value);
+    void set(size_t i, T value) { data_[i] = value; } // 替换已有元素（供 AST 变换使用）
+
+    const T *begin() const { return data_; }
+    const T *end() const { return data_ + size_; }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+    const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    const T &operator[](size_t i) const { return data_[i]; }
+    const T &front() const { return data_[0]; }
+    const T &back() const { return data_[size_ - 1]; }
+};
+
+/* -------------------------------------------------------------------------- */
+/*                                 AST Context                                */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * AST 内存池
+ * 所有 AST 节点由 bump pointer 在大块内存中顺序分配，节点从不单独析构，
+ * 整棵树随 ASTContext 一次释放（只需释放各内存块）。
+ * 因此节点必须平凡可析构：子节点用裸指针、列表用 ASTList、
+ * 字符串通过 saveString 存放在上下文中。
+ */
+class ASTContext
+{
+private:
+    static constexpr size_t SLAB_SIZE = 64 * 1024;
+
+    std::vector<std::unique_ptr<char[]>> slabs;
+    char *cursor = nullptr;
+    char *slabEnd = nullptr;
+    size_t bytesAllocated = 0;
+
+    std::deque<std::string> strings;              // 字符串字面量等
+    std::shared_ptr<IdentifierTable> identifiers; // AST 中 Identifier 的来源
+
+    void *allocateSlow(size_t size, size_t align);
+
+public:
+    ASTContext() = default;
+    ASTContext(const ASTContext &) = delete;
+    ASTContext &operator=(const ASTContext &) = delete;
+
+    void *allocate(size_t size, size_t align)
+    {
+        uintptr_t p = (reinterpret_cast<uintptr_t>(cursor) + align - 1) & ~(uintptr_t)(align - 1);
+        if (cursor && p + size <= reinterpret_cast<uintptr_t>(slabEnd))
+        {
+            cursor = reinterpret_cast<char *>(p + size);
+            bytesAllocated += size;
+            return reinterpret_cast<void *>(p);
+        }
+        return allocateSlow(size, align);
+    }
+
+    // 在 arena 中构造节点
+    template <typename T, typename... Args>
+    T *create(Args &&...args)
+    {
+        static_assert(std::is_trivially_destructible<T>::value,
+                      "AST nodes are released with the arena and must be trivially destructible");
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    // 保存字符串，返回的引用在上下文生命周期内有效
+    const std::string &saveString(std::string s)
+    {
+        strings.push_back(std::move(s));
+        return strings.back();
+    }
+
+    void setIdentifierTable(std::shared_ptr<IdentifierTable> table) { identifiers = std::move(table); }
+    const std::shared_ptr<IdentifierTable> &getIdentifierTable() const { return identifiers; }
+
+    // 统计信息
+    size_t getBytesAllocated() const { return bytesAllocated; }
+    size_t getSlabCount() const { return slabs.size(); }
+};
+
+template <typename T>
+void ASTList<T>::push_back(ASTContext &context, T value)
+{
+    if (size_ == capacity_)
+    {
+        uint32_t newCapacity = capacity_ ? capacity_ * 2 : 4;
+        T *newData = static_cast<T *>(context.allocate(sizeof(T) * newCapacity, alignof(T)));
+        if (size_)
+            std::memcpy(newData, data_, sizeof(T) * size_);
+        data_ = newData;
+        capacity_ = newCapacity;
+    }
+    data_[size_++] = value;
+}
+
+#endif // AST_CONTEXT_H
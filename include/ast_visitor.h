@@ -0,0 +1,102 @@
+#ifndef AST_VISITOR_H
+#define AST_VISITOR_H
+
+#include "ast.h"
+
+/* -------------------------------------------------------------------------- */
+/*                                 AST Visitor                                */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * CRTP 访问者
+ * visit() 按节点种类做一次 switch 分派到派生类的 visitXxx，无虚调用与 RTTI。
+ * 派生类只需实现关心的节点：未实现的 visitXxx 依次退回到
+ * visitExpr / visitStmt / visitDecl，最终到 visitNode（返回 RetTy()）。
+ *
+ *   struct CallCounter : ASTVisitor<CallCounter, int>
+ *   {
+ *       int visitFuncCallExpr(const FuncCallExpr *call) { ... }
+ *   };
+ */
+template <typename Derived, typename RetTy = void>
+class ASTVisitor
+{
+protected:
+    Derived &derived() { return *static_cast<Derived *>(this); }
+
+public:
+#define AST_DISPATCH(NAME) \
+    case NodeKind::NAME:   \
+        return derived().visit##NAME(cast<NAME>(node));
+
+    RetTy visit(const ASTNode *node)
+    {
+        switch (node->getKind())
+        {
+            AST_DISPATCH(CompUnit)
+            AST_DISPATCH(IdentifierExpr)
+            AST_DISPATCH(NumberExpr)
+            AST_DISPATCH(CharExpr)
+            AST_DISPATCH(StringExpr)
+            AST_DISPATCH(InitListExpr)
+            AST_DISPATCH(LValExpr)
+            AST_DISPATCH(UnaryExpr)
+            AST_DISPATCH(BinaryExpr)
+            AST_DISPATCH(TernaryExpr)
+            AST_DISPATCH(FuncCallExpr)
+            AST_DISPATCH(ExprStmt)
+            AST_DISPATCH(AssignStmt)
+            AST_DISPATCH(BlockStmt)
+            AST_DISPATCH(IfStmt)
+            AST_DISPATCH(WhileStmt)
+            AST_DISPATCH(ForStmt)
+            AST_DISPATCH(BreakStmt)
+            AST_DISPATCH(ContinueStmt)
+            AST_DISPATCH(ReturnStmt)
+            AST_DISPATCH(VarDecl)
+            AST_DISPATCH(VarDef)
+            AST_DISPATCH(FuncParam)
+            AST_DISPATCH(FuncDef)
+        }
+        return RetTy();
+    }
+
+#undef AST_DISPATCH
+
+    /* ------------------------------ Default visits ---------------------------- */
+    RetTy visitNode(const ASTNode *) { return RetTy(); }
+    RetTy visitExpr(const Expr *node) { return derived().visitNode(node); }
+    RetTy visitStmt(const Stmt *node) { return derived().visitNode(node); }
+    RetTy visitDecl(const Decl *node) { return derived().visitNode(node); }
+
+    RetTy visitCompUnit(const CompUnit *node) { return derived().visitNode(node); }
+
+    RetTy visitIdentifierExpr(const IdentifierExpr *node) { return derived().visitExpr(node); }
+    RetTy visitNumberExpr(const NumberExpr *node) { return derived().visitExpr(node); }
+    RetTy visitCharExpr(const CharExpr *node) { return derived().visitExpr(node); }
+    RetTy visitStringExpr(const StringExpr *node) { return derived().visitExpr(node); }
+    RetTy visitInitListExpr(const InitListExpr *node) { return derived().visitExpr(node); }
+    RetTy visitLValExpr(const LValExpr *node) { return derived().visitExpr(node); }
+    RetTy visitUnaryExpr(const UnaryExpr *node) { return derived().visitExpr(node); }
+    RetTy visitBinaryExpr(const BinaryExpr *node) { return derived().visitExpr(node); }
+    RetTy visitTernaryExpr(const TernaryExpr *node) { return derived().visitExpr(node); }
+    RetTy visitFuncCallExpr(const FuncCallExpr *node) { return derived().visitExpr(node); }
+
+    RetTy visitExprStmt(const ExprStmt *node) { return derived().visitStmt(node); }
+    RetTy visitAssignStmt(const AssignStmt *node) { return derived().visitStmt(node); }
+    RetTy visitBlockStmt(const BlockStmt *node) { return derived().visitStmt(node); }
+    RetTy visitIfStmt(const IfStmt *node) { return derived().visitStmt(node); }
+    RetTy visitWhileStmt(const WhileStmt *node) { return derived().visitStmt(node); }
+    RetTy visitForStmt(const ForStmt *node) { return derived().visitStmt(node); }
+    RetTy visitBreakStmt(const BreakStmt *node) { return derived().visitStmt(node); }
+    RetTy visitContinueStmt(const ContinueStmt *node) { return derived().visitStmt(node); }
+    RetTy visitReturnStmt(const ReturnStmt *node) { return derived().visitStmt(node); }
+
+    RetTy visitVarDecl(const VarDecl *node) { return derived().visitDecl(node); }
+
+    RetTy visitVarDef(const VarDef *node) { return derived().visitNode(node); }
+    RetTy visitFuncParam(const FuncParam *node) { return derived().visitNode(node); }
+    RetTy visitFuncDef(const FuncDef *node) { return derived().visitNode(node); }
+};
+
+#endif // AST_VISITOR_H
@@ -0,0 +1,233 @@
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include "ast.h"
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+/* -------------------------------------------------------------------------- */
+/*                              Instruction set                               */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * 基于寄存器的字节码指令集
+ * R[x] 为当前栈帧的第 x 个寄存器，M[x] 为 VM 线性内存的第 x 个单元（32 位），
+ * 数组（全局/局部/字符串常量）均存放在线性内存中，寄存器中保存其基地址。
+ * imm 为 b、c 拼接而成的 32 位立即数，sc 为 c 解释为有符号 16 位数。
+ */
+enum class OpCode : uint16_t
+{
+    MOV,   // R[a] = R[b]
+    LOADI, // R[a] = imm
+    GETG,  // R[a] = M[imm]
+    SETG,  // M[imm] = R[a]
+    LEA,   // R[a] = 当前栈帧数组区基址 + imm
+    LOAD,  // R[a] = M[R[b] + R[c]]
+    STORE, // M[R[b] + R[c]] = R[a]
+    FILL,  // M[R[a] .. R[a] + R[c]) = R[b]
+
+    // 算术与位运算：R[a] = R[b] op R[c]
+    ADD,
+    SUB,
+    MUL,
+    DIV,
+    MOD,
+    AND,
+    OR,
+    XOR,
+    SHL,
+    SHR,
+    ADDI, // R[a] = R[b] + sc
+
+    // 比较：R[a] = (R[b] op R[c]) ? 1 : 0
+    EQ,
+    NE,
+    LT,
+    LE,
+    GT,
+    GE,
+
+    // 一元运算：R[a] = op R[b]
+    NEG,
+    NOT,   // 逻辑非
+    BNOT,  // 按位取反
+    BOOL,  // R[a] = R[b] != 0
+    SEXT8, // 截断为 char 并符号扩展
+
+    // 控制流：跳转偏移 imm 相对于下一条指令
+    JMP,
+    JMPF, // if (R[a] == 0) 跳转
+    JMPT, // if (R[a] != 0) 跳转
+    CALL, // R[a] = 函数 c(R[b], R[b+1], ...)，被调者寄存器窗口从 R[b] 开始
+    RET,  // 返回 R[a]
+    RETV, // 无返回值
+
+    NUM_OPCODES
+};
+
+// 定长 8 字节指令
+struct Instruction
+{
+    OpCode op;
+    uint16_t a;
+    uint16_t b;
+    uint16_t c;
+
+    Instruction(OpCode o, uint16_t ra = 0, uint16_t rb = 0, uint16_t rc = 0)
+        : op(o), a(ra), b(rb), c(rc) {}
+
+    int32_t imm() const { return static_cast<int32_t>(static_cast<uint32_t>(b) | (static_cast<uint32_t>(c) << 16)); }
+    int16_t sc() const { return static_cast<int16_t>(c); }
+    void setImm(int32_t v)
+    {
+        b = static_cast<uint16_t>(static_cast<uint32_t>(v) & 0xFFFF);
+        c = static_cast<uint16_t>(static_cast<uint32_t>(v) >> 16);
+    }
+};
+
+const char *opcodeName(OpCode op);
+
+/* -------------------------------------------------------------------------- */
+/*                                  Program                                   */
+/* -------------------------------------------------------------------------- */
+
+struct BytecodeFunction
+{
+    std::string name;
+    int numParams;   // 参数个数（参数位于 R[0..numParams)）
+    int numRegs;     // 栈帧所需寄存器数
+    int frameSize;   // 栈帧内局部数组所需的内存单元数
+    bool returnsVoid;
+    const FuncDef *source; // 对应的 AST 节点
+    std::vector<Instruction> code;
+
+    BytecodeFunction()
+        : numParams(0), numRegs(0), frameSize(0), returnsVoid(false), source(nullptr) {}
+};
+
+// 全局变量在全局内存中的位置
+struct GlobalSymbol
+{
+    std::string name;
+    int address; // 首个单元的地址
+    int size;    // 占用的单元数
+    bool isChar; // 元素类型为 char（每个字符仍占一个 32 位单元）
+};
+
+struct Program
+{
+    std::vector<BytecodeFunction> functions;
+    std::vector<int32_t> globals; // 全局内存的初始映像（全局变量与字符串常量）
+    std::vector<GlobalSymbol> globalSymbols;
+
+    int findFunction(const std::string &name) const;
+    std::string disassemble() const;
+};
+
+/* -------------------------------------------------------------------------- */
+/*                             Bytecode Compiler                              */
+/* -------------------------------------------------------------------------- */
+
+class BytecodeCompiler
+{
+private:
+    // 变量信息
+    struct VarInfo
+    {
+        enum Storage
+        {
+            REGISTER, // 局部标量/数组基址/数组参数保存在寄存器中
+            GLOBAL    // 全局变量位于全局内存
+        } storage;
+        int location;          // 寄存器编号或全局地址
+        bool isArray;          // 数组或数组参数
+        bool isChar;           // 元素类型为 char
+        bool isConst;
+        std::vector<int> dims; // 数组维度（数组参数第一维为 0）
+    };
+
+    // 循环上下文，用于回填 break/continue
+    struct LoopInfo
+    {
+        std::vector<size_t> breakJumps;
+        std::vector<size_t> continueJumps;
+    };
+
+    Program program;
+    std::map<std::string, int> functionIndex;
+    std::vector<std::map<std::string, VarInfo>> scopes;
+    std::vector<LoopInfo> loops;
+    std::map<std::string, int> stringLiterals; // 字符串常量 -> 全局地址
+
+    BytecodeFunction *current; // 正在编译的函数
+    int freeReg;               // 第一个空闲寄存器（寄存器按栈方式分配）
+    int frameTop;              // 当前栈帧数组区已用大小
+
+    std::vector<std::string> errors;
+    bool hasErrors;
+
+    /* ---------------------------- Scope management ---------------------------- */
+    void enterScope();
+    void exitScope();
+    bool declare(const std::string &name, const VarInfo &info);
+    const VarInfo *lookup(const std::string &name) const;
+
+    /* ---------------------------- Emit auxiliaries ---------------------------- */
+    size_t emit(OpCode op, int a = 0, int b = 0, int c = 0);
+    size_t emitImm(OpCode op, int a, int32_t imm);
+    size_t emitJump(OpCode op, int a = 0);
+    void patchJump(size_t at, size_t target);
+    void emitJumpTo(OpCode op, int a, size_t target);
+    int allocReg();
+    int addString(const std::string &value);
+
+    /* ---------------------------- Declarations ---------------------------- */
+    void declareFunctions(CompUnit *compUnit);
+    void compileGlobalDecl(const VarDecl *decl);
+    void compileLocalDecl(const VarDecl *decl);
+    std::vector<int> evalDims(const ASTList<Expr *> &dims, const std::string &name);
+    void compileFuncDef(FuncDef *funcDef);
+
+    /* ------------------------------ Statements ------------------------------ */
+    void compileStmt(const Stmt *stmt);
+    void compileBlock(const BlockStmt *block);
+    void compileAssign(const AssignStmt *stmt);
+    void compileIf(const IfStmt *stmt);
+    void compileWhile(const WhileStmt *stmt);
+    void compileFor(const ForStmt *stmt);
+    void compileReturn(const ReturnStmt *stmt);
+    void finishLoop(size_t continueTarget);
+
+    /* ------------------------------ Expressions ------------------------------ */
+    int compileExprAny(const Expr *expr);            // 返回保存结果的寄存器（可能是变量本身）
+    void compileExprTo(const Expr *expr, int dst);   // 将结果写入指定寄存器
+    void compileLVal(const LValExpr *lval, int dst);
+    void compileBinary(const BinaryExpr *expr, int dst);
+    void compileUnary(const UnaryExpr *expr, int dst);
+    void compileCall(const FuncCallExpr *expr, int dst);
+    int compileArrayBase(const VarInfo &var);
+    int compileElementOffset(const LValExpr *lval, const VarInfo &var);
+    void compileArrayInit(const VarInfo &var, int baseReg, const Expr *init);
+
+    /* ----------------------------- Error handling ----------------------------- */
+    void error(const std::string &message);
+
+public:
+    BytecodeCompiler();
+
+    // 将完整编译单元编译为字节码程序
+    bool compile(CompUnit *compUnit);
+
+    // 取得编译结果
+    Program &getProgram() { return program; }
+    std::unique_ptr<Program> takeProgram() { return std::make_unique<Program>(std::move(program)); }
+
+    // 错误信息
+    bool hasError() const { return hasErrors; }
+    const std::vector<std::string> &getErrors() const { return errors; }
+};
+
+#endif // BYTECODE_H
@@ -0,0 +1,58 @@
+#ifndef CHAR_SCAN_H
+#define CHAR_SCAN_H
+
+// 由构建选项 LEXER_SIMD 控制；非 x86 或编译器不支持时只有标量实现
+#ifndef LEXER_USE_SIMD
+#define LEXER_USE_SIMD 0
+#endif
+
+/* -------------------------------------------------------------------------- */
+/*                               Character Scan                               */
+/* -------------------------------------------------------------------------- */
+
+// 扫描内核的指令集级别
+enum class ScanLevel
+{
+    Scalar,
+    SSE2,
+    AVX2,
+};
+
+const char *scanLevelName(ScanLevel level);
+
+/**
+ * 词法分析器的批量扫描内核
+ * 输入必须以 '\0' 结尾（与 Lexer 的哨兵要求相同），各函数遇到 '\0' 即停止并返回其位置。
+ * SIMD 实现每次处理 16（SSE2）或 32（AVX2）字节：从 p 所在的对齐块开始读取，
+ * 因此既会读取 p 之前的字节，也会越过 '\0' 读取到块尾。对齐读取不会跨越页边界，
+ * 这些字节不会访问未映射的内存，但可能位于缓冲区之外；多读的字节不影响结果，
+ * 内核不受 AddressSanitizer 检查。
+ */
+struct ScanKernels
+{
+    ScanLevel level;
+
+    // 第一个不是 空格 \t \n \v \f \r 的字节
+    const char *(*skipBlanks)(const char *p);
+
+    // 第一个 '\n' 或 '\0'，用于单行注释与构建行表
+    const char *(*findLineEnd)(const char *p);
+
+    // 多行注释的结束符 "*/" 中 '*' 的位置，未闭合时为 '\0' 的位置
+    const char *(*findCommentEnd)(const char *p);
+
+    // 第一个不属于 [A-Za-z0-9_] 的字节
+    const char *(*skipIdentifier)(const char *p);
+
+    // 第一个可能开始字面量或注释的字节 '"' '\'' '/'，或 '\0'（并行切分的预扫描）
+    const char *(*findLiteralStart)(const char *p);
+};
+
+// 当前 CPU 支持的最高级别内核，首次调用时检测
+// 环境变量 CINTERP_LEXER_SCAN=scalar|sse2|avx2 可指定更低的级别（用于测试与对比）
+const ScanKernels &getScanKernels();
+
+// 指定级别的内核；未编译或 CPU 不支持时返回 nullptr
+const ScanKernels *getScanKernels(ScanLevel level);
+
+#endif // CHAR_SCAN_H
@@ -0,0 +1,60 @@
+#ifndef COMPILE_CACHE_H
+#define COMPILE_CACHE_H
+
+#include <functional>
+#include <string>
+#include <string_view>
+
+/* -------------------------------------------------------------------------- */
+/*                                Compile Cache                               */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * 磁盘编译缓存
+ * 以 源码文本 + 编译选项 的哈希为键，保存优化后的 bitcode（.bc）与本机目标文件（.o）。
+ * 命中时直接载入缓存产物，跳过词法分析、语法分析、IR 生成与优化。
+ *
+ * 键中还包含缓存格式版本、LLVM 版本、主机三元组与 CPU，升级编译器或换机器后
+ * 旧条目自然失效。条目先写入缓存目录中的临时文件再重命名，多个进程同时写入
+ * 同一条目也不会读到不完整的文件。缓存不做淘汰，可随时整个删除。
+ */
+class CompileCache
+{
+private:
+    std::string directory;
+
+public:
+    // directory 为空时使用 getDefaultDirectory()
+    explicit CompileCache(const std::string &directory = "");
+
+    // $CINTERP_CACHE_DIR，否则为用户缓存目录下的 cinterp（$XDG_CACHE_HOME 或 ~/.cache）
+    static std::string getDefaultDirectory();
+
+    // 影响编译产物的选项；线程数等不改变输出的选项不计入
+    struct KeyOptions
+    {
+        int optLevel = -1;    // -O 级别，-1 表示未优化
+        std::string pipeline; // -passes 指定的流水线
+        bool native = false;  // 是否生成本机代码
+        std::string cpu;      // 生成本机代码时的目标 CPU
+    };
+
+    // 计算缓存键（40 位十六进制 SHA-1）
+    static std::string computeKey(std::string_view source, const KeyOptions &options);
+
+    const std::string &getDirectory() const { return directory; }
+
+    // 条目路径：<目录>/<键><扩展名>，扩展名如 ".bc"、".o"
+    std::string getPath(const std::string &key, const std::string &extension) const;
+
+    bool contains(const std::string &key, const std::string &extension) const;
+
+    // 由 write 将产物写入给定的临时路径，成功后原子地替换为缓存条目
+    bool store(const std::string &key, const std::string &extension,
+               const std::function<bool(const std::string &)> &write);
+
+    // 将缓存条目复制到 destination
+    bool copyTo(const std::string &key, const std::string &extension, const std::string &destination) const;
+};
+
+#endif // COMPILE_CACHE_H
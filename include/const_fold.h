@@ -0,0 +1,78 @@
+#ifndef CONST_FOLD_H
+#define CONST_FOLD_H
+
+#include "ast.h"
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+/* -------------------------------------------------------------------------- */
+/*                              Constant Folding                              */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * AST 常量折叠与常量传播
+ * 在代码生成之前原地改写 AST：常量子表达式折叠为字面量，
+ * 用常量初始化的 const 标量在其作用域内的使用被替换为字面量。
+ * 折叠后数组维度、全局初始化与循环边界都是字面量，后端可直接使用。
+ *
+ * 运算按 32 位补码回绕，与 VM 和 LLVM 后端一致；除零、INT_MIN / -1
+ * 以及越界移位不折叠，保留给运行时。同一棵树重复折叠不会再有变化。
+ */
+class ConstantFolder
+{
+private:
+    struct ConstValue
+    {
+        int32_t value;
+        bool isChar; // char 常量替换为 CharExpr，保持原有类型
+    };
+
+    ASTContext &context;
+
+    // 每层作用域的声明；值为空表示非常量声明（遮蔽外层同名常量）
+    std::vector<std::unordered_map<Identifier, std::optional<ConstValue>>> scopes;
+
+    size_t foldCount = 0; // 改写的表达式个数
+
+    /* ------------------------------- Scope ------------------------------ */
+    void enterScope() { scopes.emplace_back(); }
+    void exitScope() { scopes.pop_back(); }
+    void declare(Identifier name, std::optional<ConstValue> value) { scopes.back()[name] = value; }
+    std::optional<ConstValue> lookup(Identifier name) const;
+
+    /* ----------------------------- Expressions -------------------------- */
+    Expr *foldExpr(Expr *expr);
+    Expr *foldUnary(UnaryExpr *expr);
+    Expr *foldBinary(BinaryExpr *expr);
+    Expr *foldTernary(TernaryExpr *expr);
+    void foldIndices(LValExpr *lval);
+    Expr *makeNumber(int32_t value);
+
+    /* ------------------------- Statements / Decls ----------------------- */
+    void foldNode(ASTNode *node);
+    void foldStmt(Stmt *stmt);
+    void foldVarDecl(VarDecl *decl);
+    void foldFuncDef(FuncDef *funcDef);
+
+public:
+    explicit ConstantFolder(ASTContext &context) : context(context) {}
+
+    void fold(CompUnit *compUnit);
+
+    size_t getFoldCount() const { return foldCount; }
+
+    // 读取字面量的值（NumberExpr / CharExpr）
+    static bool getLiteralValue(const Expr *expr, int32_t &value);
+};
+
+// 便捷入口：折叠整个编译单元
+inline size_t foldConstants(CompUnit *compUnit)
+{
+    ConstantFolder folder(compUnit->getContext());
+    folder.fold(compUnit);
+    return folder.getFoldCount();
+}
+
+#endif // CONST_FOLD_H
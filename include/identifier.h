@@ -0,0 +1,137 @@
+#ifndef IDENTIFIER_H
+#define IDENTIFIER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/* -------------------------------------------------------------------------- */
+/*                                 Identifier                                 */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * 驻留后的标识符
+ * 同名标识符指向 IdentifierTable 中的同一份字符串，比较与哈希只需比较指针
+ */
+class Identifier
+{
+private:
+    const std::string *text;
+
+    // 静态成员而非函数内静态变量：每个 token 默认构造 Identifier 时不必检查初始化守卫
+    static inline const std::string emptyText{};
+
+public:
+    Identifier() : text(&emptyText) {}
+    explicit Identifier(const std::string *t) : text(t) {}
+
+    const std::string &str() const { return *text; }
+    bool empty() const { return text->empty(); }
+
+    bool operator==(Identifier other) const { return text == other.text; }
+    bool operator!=(Identifier other) const { return text != other.text; }
+
+    // 供哈希表使用
+    const void *key() const { return text; }
+};
+
+namespace std
+{
+    template <>
+    struct hash<Identifier>
+    {
+        size_t operator()(Identifier id) const noexcept { return hash<const void *>()(id.key()); }
+    };
+}
+
+/* -------------------------------------------------------------------------- */
+/*                              Identifier Table                              */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * 标识符驻留表
+ * 词法分析器把每个标识符驻留一次，语法分析器与 AST 只保存 Identifier，
+ * 因此表必须比 AST 存活更久（CompUnit 持有其共享所有权）。
+ *
+ * 每个标识符 token 都要查表一次：用开放寻址（线性探测）代替 unordered_map，
+ * 槽位中保存哈希值，探测时先比较哈希，只在哈希相同时比较字符串。
+ */
+class IdentifierTable
+{
+private:
+    struct Slot
+    {
+        size_t hash;
+        const std::string *text; // 空指针表示空槽
+    };
+
+    static constexpr size_t INITIAL_CAPACITY = 256; // 2 的幂
+
+    std::deque<std::string> storage; // deque 追加元素不会移动已有字符串
+    std::vector<Slot> slots;
+
+    // FNV-1a
+    static size_t hashName(std::string_view name)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        for (char c : name)
+        {
+            hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+        }
+        return static_cast<size_t>(hash);
+    }
+
+    // 容量翻倍并按保存的哈希值重新放置
+    void grow()
+    {
+        std::vector<Slot> old(slots.size() * 2, Slot{0, nullptr});
+        old.swap(slots);
+        size_t mask = slots.size() - 1;
+        for (const Slot &slot : old)
+        {
+            if (!slot.text)
+                continue;
+            size_t i = slot.hash & mask;
+            while (slots[i].text)
+                i = (i + 1) & mask;
+            slots[i] = slot;
+        }
+    }
+
+public:
+    IdentifierTable() : slots(INITIAL_CAPACITY, Slot{0, nullptr}) {}
+    IdentifierTable(const IdentifierTable &) = delete;
+    IdentifierTable &operator=(const IdentifierTable &) = delete;
+
+    Identifier intern(std::string_view name)
+    {
+        // 装载因子不超过 3/4
+        if ((storage.size() + 1) * 4 > slots.size() * 3)
+            grow();
+
+        size_t hash = hashName(name);
+        size_t mask = slots.size() - 1;
+        for (size_t i = hash & mask;; i = (i + 1) & mask)
+        {
+            Slot &slot = slots[i];
+            if (!slot.text)
+            {
+                slot = {hash, &storage.emplace_back(name)};
+                return Identifier(slot.text);
+            }
+            if (slot.hash == hash && *slot.text == name)
+                return Identifier(slot.text);
+        }
+    }
+
+    size_t size() const { return storage.size(); }
+
+    // 按驻留顺序排列的全部名字
+    const std::deque<std::string> &getNames() const { return storage; }
+};
+
+#endif // IDENTIFIER_H
@@ -0,0 +1,62 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include "semantic.h"
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+/* -------------------------------------------------------------------------- */
+/*                                 JIT Runner                                 */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * 进程内 JIT 执行器
+ * 基于 ORC LLJIT 直接编译 CodeGenerator 生成的模块并运行入口函数，
+ * 省去写出 .ll 文件再调用 lli/clang 的进程启动与 IR 重新解析开销
+ */
+class JitRunner
+{
+private:
+    std::unique_ptr<llvm::orc::LLJIT> jit;
+
+    std::map<std::string, bool> entryReturnsVoid; // 可作为入口的无参函数 -> 是否返回 void
+
+    double compileTimeMs; // 模块加入 + 符号物化（实际编译）耗时
+    double runTimeMs;     // 入口函数执行耗时
+
+    std::vector<std::string> errors;
+    bool hasErrors;
+
+    void error(const std::string &message);
+
+public:
+    JitRunner();
+    ~JitRunner();
+
+    // 加入模块（取得模块与上下文的所有权）
+    bool addModule(std::unique_ptr<llvm::Module> module,
+                   std::unique_ptr<llvm::LLVMContext> context);
+    bool addModule(CodeGenerator &codegen);
+
+    // 解析并执行入口函数（默认 main），result 为其返回值（void 函数为 0）
+    bool run(int &result, const std::string &entry = "main");
+
+    // 将外部声明的符号绑定到宿主进程中的已有地址（如解释器管理的全局内存）
+    bool defineSymbol(const std::string &name, void *address);
+
+    // 解析符号地址（触发其所在模块的编译），失败返回 nullptr
+    void *lookup(const std::string &name);
+
+    // 计时信息（毫秒）
+    double getCompileTime() const { return compileTimeMs; }
+    double getRunTime() const { return runTimeMs; }
+
+    // 错误信息
+    bool hasError() const { return hasErrors; }
+    const std::vector<std::string> &getErrors() const { return errors; }
+};
+
+#endif // JIT_H
@@ -1,12 +1,18 @@
 #ifndef LEXER_H
 #define LEXER_H
 
+#include "char_scan.h"
+#include "identifier.h"
+#include "source_manager.h"
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 #include <memory>
 
-// Token 类型枚举
-enum class TokenType
+// Token 类型枚举（单字节，便于 TokenBuffer 紧凑存放）
+enum class TokenType : uint8_t
 {
     // 文件结束
     TOK_EOF,
@@ -21,6 +27,8 @@ enum class TokenType
     TOK_WHILE,
     TOK_FOR,
     TOK_RETURN,
+    TOK_BREAK,
+    TOK_CONTINUE,
 
     // 标识符和字面量
     TOK_IDENTIFIER,
@@ -70,23 +78,53 @@ enum class TokenType
     TOK_ERROR
 };
 
-// 源代码位置信息
+// 源代码位置：只记录文件内的字节偏移与文件编号
+// 行号与列号不在词法分析时维护，需要时由 Lexer::resolveLocation 通过 LineTable 计算
 struct SourceLocation
 {
+    uint32_t offset;
+    uint16_t fileId;
+
+    SourceLocation(uint32_t off = 0, uint16_t file = 0)
+        : offset(off), fileId(file) {}
+};
+
+// 解析后的位置（文件名指向 Lexer 持有的字符串，不复制），只在输出诊断时构造
+struct PresumedLocation
+{
+    std::string_view filename;
     int line;
     int column;
-    std::string filename;
+};
+
+/**
+ * 行首偏移表
+ * 一次扫描记录每一行行首的字节偏移，之后按偏移二分查找行号。
+ * 构造时才扫描换行（使用批量扫描内核），Lexer 只在第一次需要行列号时构造它。
+ */
+class LineTable
+{
+public:
+    explicit LineTable(std::string_view source);
+
+    // 行号与列号均从 1 开始，列号按字节计
+    int getLine(uint32_t offset) const;
+    int getColumn(uint32_t offset) const;
+    size_t getLineCount() const { return lineStarts_.size(); }
 
-    SourceLocation(const std::string &file = "", int ln = 1, int col = 1)
-        : line(ln), column(col), filename(file) {}
+private:
+    std::vector<uint32_t> lineStarts_; // 第 i 行（从 0 计）行首的偏移，lineStarts_[0] == 0
 };
 
 // Token 结构
+// 原始拼写（字符串/字符字面量包含引号）不随 token 保存，由 location.offset 与 length
+// 指回源码缓冲区，通过 lexeme(source) 或 Lexer::getSpelling 取得；token 保持 32 字节
 struct Token
 {
     TokenType type;
-    std::string lexeme;
+    uint32_t length; // 拼写的字节数
     SourceLocation location;
+    Identifier identifier; // 标识符的驻留结果（仅 TOK_IDENTIFIER 有效）
 
     // 用于存储数值
     union
@@ -95,23 +133,91 @@ struct Token
         double floatValue;
     } value;
 
-    Token(TokenType t, const std::string &lex, const SourceLocation &loc)
-        : type(t), lexeme(lex), location(loc)
+    Token(TokenType t = TokenType::TOK_EOF, uint32_t len = 0, const SourceLocation &loc = SourceLocation())
+        : type(t), length(len), location(loc)
     {
         value.intValue = 0;
     }
 
+    // source 为 token 所在文件的完整源码
+    std::string_view lexeme(std::string_view source) const { return source.substr(location.offset, length); }
+
     // 辅助函数
     bool is(TokenType t) const { return type == t; }
     bool isNot(TokenType t) const { return type != t; }
     std::string toString() const;
 };
 
+/**
+ * 批量词法分析的结果：token 按结构数组（SoA）存放
+ * 各数组按 token 下标对齐，lexeme 由偏移与长度指回源码，不复制字符串；
+ * 数值字面量的值与标识符的驻留结果共用一个 8 字节的槽位。
+ * 最后一个 token 总是 TOK_EOF，越过末尾的下标都视为该 token，因此可以任意前瞻；
+ * 空缓冲区（默认构造）同样读作位于偏移 0 的 TOK_EOF。
+ */
+class TokenBuffer
+{
+public:
+    explicit TokenBuffer(std::string_view source = {}, uint16_t fileId = 0)
+        : source_(source), fileId_(fileId) {}
+
+    void push(const Token &token);
+    void reserve(size_t count);
+
+    size_t size() const { return kinds_.size(); }
+    bool empty() const { return kinds_.empty(); }
+
+    // 按下标读取单个字段，不构造 Token；末尾的 TOK_EOF 长度与值均为 0
+    TokenType kind(size_t i) const { return i < kinds_.size() ? kinds_[i] : TokenType::TOK_EOF; }
+    uint32_t offset(size_t i) const { return i < offsets_.size() ? offsets_[i] : endOffset(); }
+    uint32_t length(size_t i) const { return i < lengths_.size() ? lengths_[i] : 0; }
+    long long intValue(size_t i) const { return i < payloads_.size() ? payloads_[i].intValue : 0; }
+    SourceLocation location(size_t i) const { return SourceLocation(offset(i), fileId_); }
+    std::string_view lexeme(size_t i) const { return source_.substr(offset(i), length(i)); }
+    Identifier identifier(size_t i) const
+    {
+        return kind(i) == TokenType::TOK_IDENTIFIER ? Identifier(payloads_[i].identifier) : Identifier();
+    }
+
+    // 还原第 i 个 token
+    Token get(size_t i) const;
+
+private:
+    friend class Lexer; // 并行切分时直接拼接各块的数组
+    union Payload
+    {
+        long long intValue;            // TOK_NUMBER / TOK_CHAR_LITERAL
+        const std::string *identifier; // TOK_IDENTIFIER
+    };
+
+    std::string_view source_;
+    uint16_t fileId_;
+    std::vector<TokenType> kinds_;
+    std::vector<uint32_t> offsets_;
+    std::vector<uint32_t> lengths_;
+    std::vector<Payload> payloads_;
+
+    uint32_t endOffset() const { return offsets_.empty() ? 0 : offsets_.back(); }
+};
+
+// 将字符串字面量的原始拼写（含引号）解码为字符串值
+std::string decodeStringLiteral(std::string_view spelling);
+
 // 词法分析器类
+// 不复制源码：source 必须在 Lexer 及其产生的 token 使用期间保持有效
+// source 之后必须紧跟一个 '\0'（std::string 保证 data()[size()] == '\0'）：
+// 扫描循环以它为哨兵结束，不对每个字节做越界检查；源码中间的 '\0' 同样视为文件结束
 class Lexer
 {
 public:
-    explicit Lexer(const std::string &filename, const std::string &source);
+    explicit Lexer(const std::string &filename, std::string_view source,
+                   std::shared_ptr<IdentifierTable> identifiers = nullptr, uint16_t fileId = 0);
+    Lexer(const std::string &filename, std::string &&source,
+          std::shared_ptr<IdentifierTable> identifiers = nullptr, uint16_t fileId = 0) = delete; // 禁止引用临时字符串
+
+    // 直接引用 SourceManager 载入的文件内容，文件名与文件编号取自 buffer
+    explicit Lexer(const SourceBuffer &buffer, std::shared_ptr<IdentifierTable> identifiers = nullptr)
+        : Lexer(buffer.getFilename(), buffer.text(), std::move(identifiers), buffer.getFileId()) {}
 
     // 获取下一个 token
     Token nextToken();
@@ -119,31 +225,57 @@ public:
     // 查看下一个 token（不消费）
     Token peekToken();
 
+    // 把剩余的源码一次性切分为 token，结果以 TOK_EOF 结尾
+    TokenBuffer tokenize();
+
+    // 多线程切分整个源码，结果（包括错误信息及其顺序）与 tokenize() 相同
+    // 必须在读取任何 token 之前调用；numThreads 为 0 时使用硬件线程数，源码较小时退化为 tokenize()
+    TokenBuffer tokenizeParallel(unsigned numThreads = 0);
+
     // 获取当前位置
     SourceLocation getCurrentLocation() const
     {
-        return SourceLocation(filename_, line_, column_);
+        return SourceLocation(static_cast<uint32_t>(cur_ - source_.data()), fileId_);
     }
 
+    // 计算位置的行号与列号（首次调用时构建行表）
+    PresumedLocation resolveLocation(SourceLocation loc) const;
+
+    // 由本词法分析器产生的 token 的原始拼写
+    std::string_view getSpelling(const Token &token) const { return token.lexeme(source_); }
+
+    const std::string &getFilename() const { return filename_; }
+    uint16_t getFileId() const { return fileId_; }
+
     // 错误报告
     void reportError(const std::string &message);
+    void reportError(SourceLocation loc, const std::string &message);
     bool hasErrors() const { return hasErrors_; }
+    const std::vector<std::string> &getErrors() const { return errorMessages_; }
+
+    // 标识符驻留表（与语法分析器、AST 共享）
+    const std::shared_ptr<IdentifierTable> &getIdentifierTable() const { return identifiers_; }
 
 private:
     std::string filename_;
-    std::string source_;
-    size_t position_;
-    int line_;
-    int column_;
+    std::string_view source_;
+    std::shared_ptr<IdentifierTable> identifiers_;
+    const ScanKernels *scan_; // 按 CPU 选择的批量扫描内核
+    const char *cur_;         // 当前扫描位置
+    uint16_t fileId_;
     bool hasErrors_;
+    bool hasPeeked_; // peeked_ 是否保存着 peekToken 读出的 token
+    Token peeked_;
+    bool deferErrors_; // 只记录错误的位置与信息，由 tokenizeParallel 按源码顺序统一报告
+    std::vector<std::pair<SourceLocation, std::string>> deferredErrors_;
+    mutable std::unique_ptr<LineTable> lineTable_; // 按需构建
     std::vector<std::string> errorMessages_;
 
     // 辅助函数
-    char currentChar() const;
-    char peekChar(int offset = 1) const;
-    void advance();
-    void skipWhitespace();
-    void skipComment();
+    void skipWhitespaceAndComments();
+    Token scanToken();
+    Token lexToken();
+    void tokenizeUntil(const char *end, TokenBuffer &tokens);
 
     // Token 识别
     Token readIdentifierOrKeyword();
@@ -153,14 +285,7 @@ private:
     Token readOperator();
 
     // 关键字检查
-    TokenType getKeywordType(const std::string &identifier);
-
-    // 字符分类
-    bool isAlpha(char c) const;
-    bool isDigit(char c) const;
-    bool isAlnum(char c) const;
-    bool isHexDigit(char c) const;
-    bool isOctalDigit(char c) const;
+    TokenType getKeywordType(std::string_view identifier);
 };
 
 #endif // LEXER_H
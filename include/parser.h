@@ -3,6 +3,7 @@
 
 #include "lexer.h"
 #include "ast.h"
+#include <deque>
 #include <memory>
 #include <vector>
 #include <stdexcept>
@@ -10,11 +11,13 @@
 /**
  * 递归下降语法分析器
  * 实现 C 语言子集的语法分析，生成抽象语法树
+ * 默认按需从 Lexer 逐个读取 token；给出 tokens（由 Lexer::tokenize 生成）时改为按下标遍历该缓冲区，
+ * 只读取用到的字段，不构造 Token；缓冲区必须比 Parser 存活更久。
  */
 class Parser
 {
 public:
-    explicit Parser(Lexer &lexer);
+    explicit Parser(Lexer &lexer, const TokenBuffer *tokens = nullptr);
 
     /* -------------------------------------------------------------------------- */
     /*                       Parse entry : Compilation unit                       */
@@ -29,7 +32,11 @@ public:
 
 private:
     Lexer &lexer_;                    // 词法分析器
-    Token current_;                   // 当前token
+    const TokenBuffer *tokens_;       // 预先切分的 token（为空时逐个读取）
+    size_t index_;                    // 当前 token 在 tokens_ 中的下标
+    ASTContext *context_;             // 当前编译单元的节点内存池
+    Token current_;                   // 当前token（逐个读取时）
+    mutable std::deque<Token> lookahead_; // peek 已从 Lexer 读出、尚未到达的 token（逐个读取时）
     bool hasErrors_;                  // 是否有错误
     std::vector<std::string> errors_; // 错误信息列表
 
@@ -39,10 +46,21 @@ private:
 
     void advance();
     bool match(TokenType type);
-    bool check(TokenType type) const;
-    Token consume(TokenType type, const std::string &errorMsg);
+    bool check(TokenType type) const { return kind() == type; }
+    bool consume(TokenType type, const std::string &errorMsg);
+    Identifier consumeIdentifier(const std::string &errorMsg); // 不是标识符时报错并返回空标识符
     void synchronize(); // 恢复同步
 
+    // 当前 token 的字段
+    TokenType kind() const { return tokens_ ? tokens_->kind(index_) : current_.type; }
+    SourceLocation location() const { return tokens_ ? tokens_->location(index_) : current_.location; }
+    Identifier identifier() const { return tokens_ ? tokens_->identifier(index_) : current_.identifier; }
+    long long intValue() const { return tokens_ ? tokens_->intValue(index_) : current_.value.intValue; }
+    std::string_view lexeme() const { return tokens_ ? tokens_->lexeme(index_) : lexer_.getSpelling(current_); }
+
+    // 向前查看第 n 个 token 的类型，peek(0) 即当前 token
+    TokenType peek(size_t n) const;
+
     /* -------------------------------------------------------------------------- */
     /*                                Error report                                */
     /* -------------------------------------------------------------------------- */
@@ -57,48 +75,50 @@ private:
     std::unique_ptr<CompUnit> parseCompUnit();
 
     /* ------------------------------- Declarations ----------------------------- */
-    std::unique_ptr<Decl> parseDecl(TypeSpec type, const std::string &name);
+    Decl *parseDecl(TypeSpec type, Identifier name);
     TypeSpec parseTypeSpec();
-    std::unique_ptr<VarDef> parseVarDef();
-    std::unique_ptr<Expr> parseInitVal();
+    VarDef *parseVarDef();
+    Expr *parseInitVal();
 
     /* ------------------------------ Function Definition ----------------------- */
-    std::unique_ptr<FuncDef> parseFuncDef(TypeSpec returnType, const std::string &name);
-    std::unique_ptr<FuncParam> parseFuncParam();
+    FuncDef *parseFuncDef(TypeSpec returnType, Identifier name);
+    FuncParam *parseFuncParam();
 
     /* ---------------------------------- Statements ---------------------------- */
-    std::unique_ptr<Stmt> parseStmt();
-    std::unique_ptr<BlockStmt> parseBlock();
-    std::unique_ptr<Stmt> parseIfStmt();
-    std::unique_ptr<Stmt> parseWhileStmt();
-    std::unique_ptr<Stmt> parseForStmt();
-    std::unique_ptr<Stmt> parseReturnStmt();
-    std::unique_ptr<Stmt> parseBreakStmt();
-    std::unique_ptr<Stmt> parseContinueStmt();
+    Stmt *parseStmt();
+    BlockStmt *parseBlock();
+    Stmt *parseIfStmt();
+    Stmt *parseWhileStmt();
+    Stmt *parseForStmt();
+    Stmt *parseReturnStmt();
+    Stmt *parseBreakStmt();
+    Stmt *parseContinueStmt();
 
     /* ------------------- Expressions(from lowest to highest) ------------------ */
-    std::unique_ptr<Expr> parseExpr();
-    std::unique_ptr<Expr> parseConditionalExpr(); // 条件表达式 ?:
-    std::unique_ptr<Expr> parseLOrExpr();         // 逻辑或 ||
-    std::unique_ptr<Expr> parseLAndExpr();        // 逻辑与 &&
-    std::unique_ptr<Expr> parseOrExpr();          // 按位或 |
-    std::unique_ptr<Expr> parseXorExpr();         // 按位异或 ^
-    std::unique_ptr<Expr> parseAndExpr();         // 按位与 &
-    std::unique_ptr<Expr> parseEqExpr();          // 相等 == !=
-    std::unique_ptr<Expr> parseRelExpr();         // 关系 < <= > >=
-    std::unique_ptr<Expr> parseShiftExpr();       // 移位 << >>
-    std::unique_ptr<Expr> parseAddExpr();         // 加法 + -
-    std::unique_ptr<Expr> parseMulExpr();         // 乘法 * / %
-    std::unique_ptr<Expr> parseUnaryExpr();       // 一元运算 + - ! ~
-    std::unique_ptr<Expr> parsePrimaryExpr();     // 基本表达式 变量、常量、括号表达式
-    std::unique_ptr<LValExpr> parseLVal();        // 左值表达式 变量或数组元素
-    std::unique_ptr<Expr> parseConstExpr();       // 常量表达式（语法上等同于Exp）
+    Expr *parseExpr();
+    Expr *parseConditionalExpr(); // 条件表达式 ?:
+    Expr *parseLOrExpr();         // 逻辑或 ||
+    Expr *parseLAndExpr();        // 逻辑与 &&
+    Expr *parseOrExpr();          // 按位或 |
+    Expr *parseXorExpr();         // 按位异或 ^
+    Expr *parseAndExpr();         // 按位与 &
+    Expr *parseEqExpr();          // 相等 == !=
+    Expr *parseRelExpr();         // 关系 < <= > >=
+    Expr *parseShiftExpr();       // 移位 << >>
+    Expr *parseAddExpr();         // 加法 + -
+    Expr *parseMulExpr();         // 乘法 * / %
+    Expr *parseUnaryExpr();       // 一元运算 + - ! ~
+    Expr *parsePrimaryExpr();     // 基本表达式 变量、常量、括号表达式
+    LValExpr *parseLVal();        // 左值表达式 变量或数组元素
+    Expr *parseConstExpr();       // 常量表达式（语法上等同于Exp）
 
     /* -------------------------------------------------------------------------- */
     /*                              Auxiliary methods                             */
     /* -------------------------------------------------------------------------- */
     bool isTypeSpec() const;
     bool isUnaryOp() const;
+    static BinaryOp toBinaryOp(TokenType type);
+    static UnaryOp toUnaryOp(TokenType type);
     std::string tokenToString(TokenType type) const;
 };
 
@@ -0,0 +1,59 @@
+#ifndef PHASE_TIMER_H
+#define PHASE_TIMER_H
+
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/* -------------------------------------------------------------------------- */
+/*                                 Phase Timer                                */
+/* -------------------------------------------------------------------------- */
+
+// 一个编译阶段的统计
+struct PhaseRecord
+{
+    std::string name;
+    double wallMs;  // 墙钟时间
+    double cpuMs;   // 进程 CPU 时间（用户态 + 内核态，含所有线程）
+    long peakRssKB; // 阶段结束时的进程峰值常驻内存
+};
+
+/**
+ * 驱动程序的分阶段计时（-time-phases）
+ * Phase 在构造时开始计时，析构时记录，阶段内提前返回也会被统计。
+ * 峰值内存取自 getrusage 的 ru_maxrss，是进程的历史最高值，
+ * 因此只会随阶段单调增长；与上一阶段的差值即该阶段新增的峰值。
+ */
+class PhaseTimer
+{
+private:
+    std::vector<PhaseRecord> records;
+
+public:
+    class Phase
+    {
+    private:
+        PhaseTimer &timer;
+        std::string name;
+        std::chrono::steady_clock::time_point wallStart;
+        double cpuStart;
+
+    public:
+        Phase(PhaseTimer &timer, std::string name);
+        ~Phase();
+
+        Phase(const Phase &) = delete;
+        Phase &operator=(const Phase &) = delete;
+    };
+
+    // 开始一个阶段，返回的对象离开作用域时结束
+    Phase start(const std::string &name) { return Phase(*this, name); }
+
+    const std::vector<PhaseRecord> &getRecords() const { return records; }
+
+    // 输出各阶段与合计的耗时表
+    void print(std::ostream &os) const;
+};
+
+#endif // PHASE_TIMER_H
@@ -9,7 +9,11 @@
 #include <llvm/IR/Function.h>
 #include <llvm/IR/Type.h>
 #include <llvm/IR/Verifier.h>
+#include <llvm/Target/TargetMachine.h>
+#include <deque>
 #include <map>
+#include <ostream>
+#include <set>
 #include <memory>
 #include <string>
 #include <vector>
@@ -41,21 +45,49 @@ struct SymbolInfo
           isConst(c), isGlobal(g), isFunction(f) {}
 };
 
-// 符号表
+/**
+ * 符号表
+ * 以驻留标识符为键的开放寻址哈希表，槽位指向该名字当前可见的绑定；
+ * 每个绑定记录被它遮蔽的外层绑定（遮蔽链）。绑定按声明顺序存放，
+ * 同时充当撤销日志：exitScope 弹出本层绑定并把槽位恢复为被遮蔽的绑定。
+ * 查找与作用域深度无关，只比较指针；返回的 SymbolInfo 指针在其作用域内保持有效。
+ */
 class SymbolTable
 {
 private:
-    std::vector<std::map<std::string, SymbolInfo>> scopes; // 作用域栈
+    static constexpr int32_t NO_BINDING = -1;
+
+    struct Slot
+    {
+        const void *key = nullptr; // Identifier::key()，空表示槽位未使用
+        int32_t binding = NO_BINDING;
+    };
+
+    struct Binding
+    {
+        SymbolInfo info;
+        Identifier name;
+        int32_t shadowed; // 被遮蔽的外层绑定
+        uint32_t scope;   // 所在作用域层级
+    };
+
+    std::vector<Slot> slots;         // 容量为 2 的幂
+    size_t usedSlots = 0;
+    std::deque<Binding> bindings;    // 按声明顺序排列（撤销日志）
+    std::vector<size_t> scopeMarks;  // 每层作用域开始时的 bindings 大小
+
+    Slot &findSlot(const void *key);
+    void grow();
 
 public:
     SymbolTable();
 
     void enterScope();
     void exitScope();
-    bool declare(const std::string &name, const SymbolInfo &info);
-    SymbolInfo *lookup(const std::string &name);
-    bool isCurrentScopeGlobal() const { return scopes.size() == 1; }
-    int getScopeLevel() const { return scopes.size(); }
+    bool declare(Identifier name, SymbolInfo info);
+    SymbolInfo *lookup(Identifier name);
+    bool isCurrentScopeGlobal() const { return scopeMarks.size() == 1; }
+    int getScopeLevel() const { return scopeMarks.size(); }
 };
 
 /* -------------------------------------------------------------------------- */
@@ -72,10 +104,49 @@ struct LoopContext
         : continueBlock(cont), breakBlock(brk) {}
 };
 
+/* -------------------------------------------------------------------------- */
+/*                                Optimization                                */
+/* -------------------------------------------------------------------------- */
+
+// 优化级别，对应 PassBuilder 的默认流水线
+enum class OptLevel
+{
+    O0,
+    O1,
+    O2,
+    O3
+};
+
+// 单个 pass 的统计（同名 pass 多次运行时累加）
+struct PassStat
+{
+    std::string name;
+    unsigned runs = 0;
+    double ms = 0; // 自身耗时，不含嵌套的子 pass
+};
+
+// 一次优化的统计信息
+struct OptimizationStats
+{
+    std::string pipeline; // 实际运行的流水线描述
+    double totalMs = 0;
+    size_t instructionsBefore = 0;
+    size_t instructionsAfter = 0;
+    std::vector<PassStat> passes; // 按首次运行顺序排列
+};
+
 /* -------------------------------------------------------------------------- */
 /*                               Code Generator                               */
 /* -------------------------------------------------------------------------- */
 
+// 运行时检查失败的种类，作为 __cinterp_runtime_error 的第一个参数
+enum class RuntimeCheck : int32_t
+{
+    DivisionByZero, // value 无意义
+    MemoryAccess,   // 全局数组或数组参数越出调用方内存，value 为按 32 位单元计的地址
+    ArrayAccess     // 局部数组越界，value 为按元素计的偏移
+};
+
 class CodeGenerator
 {
 private:
@@ -88,18 +159,33 @@ private:
     std::stack<LoopContext> loopStack;
 
     llvm::Function *currentFunction;
+    llvm::AllocaInst *lastEntryAlloca; // 当前函数入口块中最后一条 alloca，新的 alloca 插在其后
+
+    bool externalGlobals; // 全局变量只生成外部声明（存储由调用方提供）
+    bool deferErrors;     // 错误只记录不输出（并行生成的块由主模块统一报告）
+    bool runtimeChecks;   // 除零与数组越界生成运行时检查，见 enableRuntimeChecks
+
+    llvm::Constant *currentFunctionName; // 运行时检查报告的函数名，每个函数按需创建一次
 
     std::vector<std::string> errors;
     bool hasErrors;
 
+    OptimizationStats optStats;
+
+    std::unique_ptr<llvm::TargetMachine> targetMachine; // 本机目标，initializeTarget 后有效
+
     /* --------------------- Type system auxiliary functions -------------------- */
-    llvm::Type *getLLVMType(const TypeSpec *typeSpec);
+    llvm::Type *getLLVMType(const TypeSpec &typeSpec);
     llvm::Type *getArrayType(llvm::Type *elementType,
-                             const std::vector<std::unique_ptr<Expr>> &dims);
+                             const ASTList<Expr *> &dims);
     llvm::Type *getArrayElementType(llvm::Type *arrayType, size_t indexCount,
                                     const SymbolInfo *symInfo = nullptr);
     llvm::Value *convertToBool(llvm::Value *val); // 将值转换为bool类型，用于判断语句
 
+    // 在当前函数入口块创建 alloca（局部变量、参数与临时变量统一使用）
+    // 循环体内的声明也只分配一次栈空间，且 mem2reg/SROA 只提升入口块中的 alloca
+    llvm::AllocaInst *createEntryBlockAlloca(llvm::Type *type, const std::string &name);
+
     /* ----------------------- Expression code generation ----------------------- */
     llvm::Value *generateExpr(Expr *expr);
     llvm::Value *generateNumberExpr(NumberExpr *expr);
@@ -113,10 +199,17 @@ private:
     llvm::Value *generateInitListExpr(InitListExpr *expr, llvm::Type *targetType);
 
     /* ------------------ Array processing auxiliary functions ------------------ */
-    llvm::Value *getArrayElementPtr(const LValExpr *lval); // 获取数组元素地址，用于处理函数数组参数与数组地址处理
+    llvm::Value *getArrayElementPtr(const LValExpr *lval); // 获取数组元素地址，启用运行时检查时检查越界
+    llvm::Value *computeArrayElementPtr(const LValExpr *lval, const SymbolInfo *sym);
     void initializeArray(llvm::Value *arrayPtr, llvm::Type *arrayType,
                          Expr *initExpr, std::vector<int> &dims, int dimIndex = 0);
-    void flattenInitList(InitListExpr *initList, std::vector<llvm::Value *> &values);
+    // 由按线性偏移排列的常量构造数组常量，image 之外的部分为零（zeroinitializer）
+    // splitZeroTail 为 true 时，较长的全零尾部拆成 { 前缀数组, zeroinitializer } 结构，避免逐个列出零
+    llvm::Constant *buildConstantAggregate(llvm::Type *type, const std::vector<llvm::Constant *> &image,
+                                           size_t base = 0, bool splitZeroTail = false);
+    // 按花括号规则展开初始化列表，输出 (线性偏移, 值) 对
+    void flattenInitList(InitListExpr *initList, const std::vector<int> &dims, size_t dimIndex,
+                         int base, std::vector<std::pair<int, llvm::Value *>> &values);
 
     /* ------------------------ Statement code generation ----------------------- */
     void generateStmt(Stmt *stmt);
@@ -137,22 +230,80 @@ private:
     void generateLocalVar(VarDecl *decl, VarDef *varDef, llvm::Type *type);
 
     /* ------------------- Function definition code generation ------------------ */
+    llvm::Function *declareFunction(FuncDef *funcDef); // 创建函数原型并登记到符号表（已存在则复用）
     llvm::Function *generateFuncDef(FuncDef *funcDef);
-    void generateFuncParams(llvm::Function *func, const std::vector<std::unique_ptr<FuncParam>> &params);
+    void generateFuncParams(llvm::Function *func, const ASTList<FuncParam *> &params);
+
+    /* ---------------------------- Parallel codegen ---------------------------- */
+    // 生成 funcDefs[begin, end) 的函数体：此前出现的全局变量生成外部声明，其他函数只声明原型
+    void generateChunk(CompUnit *compUnit, const std::vector<FuncDef *> &funcDefs,
+                       size_t begin, size_t end);
+
+    /* ------------------------------ Optimization ------------------------------ */
+    // level 为空时按 pipeline 文本解析流水线
+    bool runPipeline(const OptLevel *level, const std::string &pipeline);
+
+    /* ----------------------------- Runtime checks ----------------------------- */
+    // failed 为真时调用 __cinterp_runtime_error（不返回），之后在新的基本块中继续生成
+    void emitRuntimeCheck(llvm::Value *failed, RuntimeCheck kind, llvm::Value *value);
+    void checkArrayElementPtr(const SymbolInfo *sym, llvm::Value *elemPtr);
 
     /* ----------------------------- Error handling ----------------------------- */
     void error(const std::string &message);
 
 public:
+
     CodeGenerator(const std::string &moduleName);
     ~CodeGenerator();
 
     // 生成完整编译单元的 IR
     bool generate(CompUnit *compUnit);
 
+    // 多线程生成：函数体分块在各自的 LLVMContext 中生成，再链接回本模块
+    // numThreads 为 0 时使用硬件线程数；结果与顺序生成等价，函数按源码顺序排列
+    bool generateParallel(CompUnit *compUnit, unsigned numThreads = 0);
+
+    // 仅为选定的函数生成 IR（用于分层执行），全局变量生成为外部声明
+    bool generateFunctions(CompUnit *compUnit, const std::set<const FuncDef *> &selected);
+
+    // 生成与字节码解释器一致的运行时检查（用于分层执行，须在生成代码前调用）：
+    // 除数为零或数组访问越界时调用调用方提供的 void __cinterp_runtime_error(i32 kind, ptr function, i64 value)，
+    // 该函数不返回；INT_MIN / -1 与解释器一样按补码回绕，不产生硬件异常。
+    // 全局数组与数组参数须位于外部变量 __cinterp_memory_begin 与 __cinterp_memory_end 所指的内存之内，
+    // 局部数组按其自身大小检查
+    void enableRuntimeChecks() { runtimeChecks = true; }
+
     // 获取生成的模块（用于输出 IR）
     llvm::Module *getModule() { return module.get(); }
 
+    // 转移模块及其上下文的所有权（用于 JIT 执行，转移后不可再生成代码）
+    std::unique_ptr<llvm::Module> takeModule() { return std::move(module); }
+    std::unique_ptr<llvm::LLVMContext> takeContext() { return std::move(context); }
+
+    // 用默认流水线优化模块（O0 只运行必要的 pass，如 always-inline）
+    bool optimize(OptLevel level);
+
+    // 运行自定义流水线，语法同 opt -passes=，如 "function(mem2reg,instcombine)"
+    bool runPasses(const std::string &pipeline);
+
+    // 最近一次优化的耗时与各 pass 统计
+    const OptimizationStats &getOptimizationStats() const { return optStats; }
+    void printOptimizationStats(std::ostream &os) const;
+
+    // 为本机三元组创建 TargetMachine 并设置模块的 triple 与数据布局
+    // cpu 为空时使用通用 CPU，"native" 表示本机 CPU 及其全部特性（同 -mcpu=native）
+    // 应在生成代码之前调用，使数组初始化与优化都按目标布局进行
+    bool initializeTarget(const std::string &cpu = "");
+
+    // 直接输出本机目标文件（未初始化目标时按通用 CPU 初始化）
+    bool emitObjectFile(const std::string &filename);
+
+    // 输出目标文件并用系统 C 编译器驱动（cc）与 C 运行时链接为可执行文件
+    bool emitExecutable(const std::string &filename);
+
+    // 将已有的目标文件链接为可执行文件（如编译缓存中的目标文件）
+    bool linkExecutable(const std::string &objectFile, const std::string &filename);
+
     // 错误信息
     bool hasError() const { return hasErrors; }
     const std::vector<std::string> &getErrors() const { return errors; }
@@ -162,6 +313,12 @@ public:
 
     // 输出 IR 到文件
     bool writeIRToFile(const std::string &filename);
+
+    // 输出 bitcode 到文件（同 clang -emit-llvm -c）
+    bool writeBitcodeToFile(const std::string &filename);
+
+    // 从 bitcode 文件载入模块，替换当前模块（用于编译缓存命中，载入后不可再生成代码）
+    bool loadBitcodeFile(const std::string &filename);
 };
 
 #endif // SEMANTIC_H
\ No newline at end of file
@@ -0,0 +1,76 @@
+#ifndef SOURCE_MANAGER_H
+#define SOURCE_MANAGER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/* -------------------------------------------------------------------------- */
+/*                                Source Buffer                               */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * 一个源文件的内容
+ * 普通文件以只读方式整体映射（mmap），不复制；管道等无法映射的输入读入内存。
+ * 两种方式都保证 text() 之后紧跟 '\0'，满足 Lexer 的哨兵要求：
+ * 映射长度按页向上取整且至少比文件多一个字节，文件末尾之后的字节由内核填零
+ * （文件恰好占满整页时，多出的一页是匿名零页）。
+ */
+class SourceBuffer
+{
+public:
+    ~SourceBuffer();
+    SourceBuffer(const SourceBuffer &) = delete;
+    SourceBuffer &operator=(const SourceBuffer &) = delete;
+
+    std::string_view text() const { return std::string_view(data_, size_); }
+    const std::string &getFilename() const { return filename_; }
+    uint16_t getFileId() const { return fileId_; }
+    bool isMapped() const { return mapSize_ != 0; }
+
+private:
+    friend class SourceManager;
+    SourceBuffer(const std::string &filename, uint16_t fileId) : filename_(filename), fileId_(fileId) {}
+
+    std::string filename_;
+    uint16_t fileId_;
+    const char *data_ = "";
+    size_t size_ = 0;
+    size_t mapSize_ = 0; // 映射长度，0 表示内容在 contents_ 中
+    std::string contents_;
+};
+
+/* -------------------------------------------------------------------------- */
+/*                               Source Manager                               */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * 源文件管理器
+ * 载入源文件并按载入顺序分配文件编号（即 SourceLocation::fileId）。
+ * 缓冲区归管理器所有，必须比引用它的 Lexer、token 与 AST 存活更久。
+ */
+class SourceManager
+{
+public:
+    // 载入文件，失败时返回 nullptr，原因由 getError() 给出
+    const SourceBuffer *load(const std::string &path);
+
+    const SourceBuffer *getBuffer(uint16_t fileId) const
+    {
+        return fileId < buffers_.size() ? buffers_[fileId].get() : nullptr;
+    }
+
+    const std::string &getError() const { return error_; }
+
+private:
+    std::vector<std::unique_ptr<SourceBuffer>> buffers_;
+    std::string error_;
+
+    bool mapFile(int fd, size_t size, SourceBuffer &buffer);
+    bool readFile(const std::string &path, SourceBuffer &buffer);
+};
+
+#endif // SOURCE_MANAGER_H
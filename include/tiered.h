@@ -0,0 +1,91 @@
+#ifndef TIERED_H
+#define TIERED_H
+
+#include "jit.h"
+#include "vm.h"
+#include <csetjmp>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+/* -------------------------------------------------------------------------- */
+/*                              Tiered Execution                              */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * 分层执行器
+ * 所有函数先由字节码虚拟机解释执行，启动开销小；函数的调用次数与循环回边次数
+ * 达到阈值后，经 CodeGenerator::generateFuncDef 将该函数（连同它调用的函数）
+ * 生成 IR 并由 JIT 编译，此后对它的调用直接进入本地代码。
+ *
+ * 本地代码与解释器共享全局内存：全局变量在 IR 中只生成外部声明，
+ * 绑定到 VM 线性内存中的对应地址。VM 中 char 全局变量每个字符占 32 位，
+ * 与本地布局不同，访问它们（或带 char 数组参数）的函数保持解释执行。
+ *
+ * 本地代码带有与解释器相同的运行时检查（CodeGenerator::enableRuntimeChecks）：
+ * 除零与越出 VM 内存的访问报告与解释器相同的错误，而不是硬件异常或内存损坏。
+ * 检查失败时经 longjmp 直接返回 run()。局部数组在本地栈上，按数组自身大小检查；
+ * 把局部数组作为实参传递的函数保持解释执行，因此数组参数总是指向 VM 内存。
+ *
+ * 没有栈上替换（OSR）：切换只对之后的调用生效，正在解释执行的调用（包括只调用一次的 main
+ * 及其中的循环）始终解释执行到结束。
+ */
+class TieredRunner
+{
+private:
+    CompUnit *compUnit;
+    const Program &program;
+    VM vm;
+    JitRunner jit;
+
+    std::map<std::string, const FuncDef *> funcDefs;
+    std::set<std::string> charGlobals;
+    std::vector<std::string> compiledFunctions;
+    int moduleCount;
+
+    double compileTimeMs; // 生成 IR + JIT 编译的总耗时
+    double runTimeMs;     // 入口函数执行耗时（扣除其间的编译）
+
+    std::vector<std::string> errors;
+    bool hasErrors;
+
+    // 本地代码运行时检查使用的 VM 内存范围与失败时的返回点
+    int32_t *memoryBegin;
+    int32_t *memoryEnd;
+    std::jmp_buf trapTarget;
+    std::string trapMessage;
+
+    void error(const std::string &message);
+
+    // __cinterp_runtime_error：按解释器的格式记录错误并跳回 run()
+    [[noreturn]] static void runtimeError(int32_t kind, const char *function, int64_t value);
+
+    // VM 的 tier-up 回调：编译函数并返回其本地代码入口
+    VM::NativeFunction tierUp(int functionIndex);
+
+    // 收集函数及其直接或间接调用的所有函数，无法编译为本地代码时返回 false
+    bool collectFunctions(const FuncDef *funcDef, std::set<const FuncDef *> &selected);
+
+public:
+    static constexpr int32_t DEFAULT_HOT_THRESHOLD = 1000;
+
+    TieredRunner(CompUnit *compUnit, const Program &program,
+                 int32_t hotThreshold = DEFAULT_HOT_THRESHOLD);
+
+    // 执行入口函数（默认 main），result 为其返回值（void 函数为 0）
+    bool run(int &result, const std::string &entry = "main");
+
+    // 已切换到本地代码的函数
+    const std::vector<std::string> &getCompiledFunctions() const { return compiledFunctions; }
+
+    // 计时信息（毫秒）
+    double getCompileTime() const { return compileTimeMs; }
+    double getRunTime() const { return runTimeMs; }
+
+    // 错误信息
+    bool hasError() const { return hasErrors; }
+    const std::vector<std::string> &getErrors() const { return errors; }
+};
+
+#endif // TIERED_H
@@ -0,0 +1,118 @@
+#ifndef VM_H
+#define VM_H
+
+#include "bytecode.h"
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// 由构建选项 VM_THREADED_DISPATCH 控制；编译器不支持标签地址时回退到 switch 分派
+#ifndef VM_USE_COMPUTED_GOTO
+#define VM_USE_COMPUTED_GOTO 0
+#endif
+
+/* -------------------------------------------------------------------------- */
+/*                              Virtual Machine                               */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * 字节码虚拟机
+ * 寄存器栈与线性内存在构造时以 calloc 一次性保留，大块由系统以未触碰的零页提供，
+ * 物理内存随实际用到的页按需分配，构造本身不随容量增长；调用不递归宿主栈；
+ * 被调函数的寄存器窗口直接从调用者放置实参的寄存器开始，实参无需拷贝。
+ *
+ * 分派方式：
+ *   - switch：可移植的默认实现，所有指令共用一个间接跳转
+ *   - 直接线索化（computed goto）：执行前把每条指令翻译为 {处理程序地址, 指令}，
+ *     每个处理程序末尾各自跳转到下一条指令的处理程序，分支预测器可按指令区分历史
+ */
+class VM
+{
+public:
+    // 本地代码入口：args 指向实参寄存器，mem 为 VM 线性内存（数组实参为其中的地址）
+    using NativeFunction = int32_t (*)(const int32_t *args, int32_t *mem);
+
+    // 分层执行回调：函数变热时调用，返回其本地代码入口（失败返回 nullptr，继续解释执行）
+    using TierUpHook = std::function<NativeFunction(int functionIndex)>;
+
+private:
+#if VM_USE_COMPUTED_GOTO
+    struct ThreadedInstruction
+    {
+        const void *handler;
+        Instruction ins;
+    };
+    using CodeUnit = ThreadedInstruction;
+#else
+    using CodeUnit = Instruction;
+#endif
+
+    // 调用栈帧（保存调用者的执行状态）
+    struct Frame
+    {
+        const BytecodeFunction *func;
+        const CodeUnit *returnPc;
+        int32_t *regs;
+        int32_t memBase; // 调用者栈帧数组区基址
+        uint16_t dst;    // 返回值写回调用者的寄存器
+    };
+
+    struct FreeDeleter
+    {
+        void operator()(int32_t *p) const { std::free(p); }
+    };
+    using ZeroedArray = std::unique_ptr<int32_t[], FreeDeleter>;
+
+    const Program &program;
+    ZeroedArray registers; // 寄存器栈
+    ZeroedArray memory;    // 线性内存：[全局区 | 栈帧数组区]
+    size_t registerCount;
+    size_t memorySize;
+    std::vector<Frame> frames;
+#if VM_USE_COMPUTED_GOTO
+    std::vector<std::vector<ThreadedInstruction>> threadedCode; // 按函数编号索引
+#endif
+    size_t maxCallDepth;
+    int32_t memoryUsed; // 上次执行用到的内存上界，再次执行时只需清零这一部分
+
+    // 分层执行：每个函数的热度计数（调用与循环回边递减，归零时触发 tierUp）
+    std::vector<NativeFunction> nativeCode; // 按函数编号索引，非空时调用直接进入本地代码
+    std::vector<int32_t> hotness;
+    TierUpHook tierUpHook;
+
+    std::vector<std::string> errors;
+    bool hasErrors;
+
+    void error(const std::string &message);
+    bool execute(int entryIndex, int &result);
+    void tierUp(int functionIndex);
+
+public:
+    static constexpr size_t DEFAULT_REGISTER_COUNT = 1 << 20;
+    static constexpr size_t DEFAULT_MEMORY_SIZE = 1 << 24;
+
+    explicit VM(const Program &program,
+                size_t registerCount = DEFAULT_REGISTER_COUNT,
+                size_t memorySize = DEFAULT_MEMORY_SIZE);
+
+    // 执行入口函数（默认 main），result 为其返回值（void 函数为 0）
+    bool run(int &result, const std::string &entry = "main");
+
+    // 启用分层执行：函数的调用次数与循环回边次数之和达到 threshold 时调用 hook，
+    // 之后对该函数的调用进入本地代码（正在解释执行的调用不受影响）
+    void setTierUpHook(TierUpHook hook, int32_t threshold);
+
+    // VM 线性内存（全局变量位于 Program::globalSymbols 给出的地址）
+    int32_t *getMemory() { return memory.get(); }
+    size_t getMemorySize() const { return memorySize; }
+    bool isNative(int functionIndex) const { return nativeCode[functionIndex] != nullptr; }
+
+    // 错误信息
+    bool hasError() const { return hasErrors; }
+    const std::vector<std::string> &getErrors() const { return errors; }
+};
+
+#endif // VM_H
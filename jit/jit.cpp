@@ -0,0 +1,169 @@
+#include "jit.h"
+#include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+#include <llvm/Support/TargetSelect.h>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+
+/* -------------------------------------------------------------------------- */
+/*                                 JIT Runner                                 */
+/* -------------------------------------------------------------------------- */
+
+static double elapsedMs(std::chrono::steady_clock::time_point start)
+{
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+JitRunner::JitRunner()
+    : compileTimeMs(0.0), runTimeMs(0.0), hasErrors(false)
+{
+    // 本机目标只需初始化一次
+    static std::once_flag targetInitFlag;
+    std::call_once(targetInitFlag, []()
+                   {
+        llvm::InitializeNativeTarget();
+        llvm::InitializeNativeTargetAsmPrinter(); });
+
+    auto jitOrErr = llvm::orc::LLJITBuilder().create();
+    if (!jitOrErr)
+    {
+        error("Cannot create JIT: " + llvm::toString(jitOrErr.takeError()));
+        return;
+    }
+    jit = std::move(*jitOrErr);
+
+    // 允许 JIT 代码解析宿主进程中的符号（如 libc 函数）
+    auto generator = llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(
+        jit->getDataLayout().getGlobalPrefix());
+    if (!generator)
+    {
+        error("Cannot create process symbol generator: " + llvm::toString(generator.takeError()));
+        return;
+    }
+    jit->getMainJITDylib().addGenerator(std::move(*generator));
+}
+
+JitRunner::~JitRunner() = default;
+
+void JitRunner::error(const std::string &message)
+{
+    hasErrors = true;
+    errors.push_back(message);
+    std::cerr << "JIT Error: " << message << std::endl;
+}
+
+bool JitRunner::addModule(std::unique_ptr<llvm::Module> module,
+                          std::unique_ptr<llvm::LLVMContext> context)
+{
+    if (!jit)
+        return false;
+
+    if (!module || !context)
+    {
+        error("No module to add");
+        return false;
+    }
+
+    // 记录可作为入口的无参函数（模块移交后无法再查询其类型）
+    for (const auto &func : module->functions())
+    {
+        if (!func.isDeclaration() && func.arg_empty())
+        {
+            entryReturnsVoid[std::string(func.getName())] = func.getReturnType()->isVoidTy();
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    llvm::orc::ThreadSafeModule tsm(std::move(module), std::move(context));
+    if (auto err = jit->addIRModule(std::move(tsm)))
+    {
+        error("Cannot add module: " + llvm::toString(std::move(err)));
+        return false;
+    }
+
+    compileTimeMs += elapsedMs(start);
+    return true;
+}
+
+bool JitRunner::addModule(CodeGenerator &codegen)
+{
+    // 先取模块再取上下文：模块析构依赖上下文，二者一同交给 ThreadSafeModule
+    auto module = codegen.takeModule();
+    auto context = codegen.takeContext();
+    return addModule(std::move(module), std::move(context));
+}
+
+bool JitRunner::run(int &result, const std::string &entry)
+{
+    result = 0;
+    if (!jit)
+        return false;
+
+    auto it = entryReturnsVoid.find(entry);
+    if (it == entryReturnsVoid.end())
+    {
+        error("Entry function not found or takes parameters: " + entry);
+        return false;
+    }
+
+    // lookup 触发模块物化，即真正的编译发生在此处
+    auto start = std::chrono::steady_clock::now();
+    auto sym = jit->lookup(entry);
+    if (!sym)
+    {
+        error("Cannot resolve entry function " + entry + ": " + llvm::toString(sym.takeError()));
+        return false;
+    }
+    compileTimeMs += elapsedMs(start);
+
+    start = std::chrono::steady_clock::now();
+    if (it->second)
+    {
+        auto *func = sym->toPtr<void (*)()>();
+        func();
+    }
+    else
+    {
+        auto *func = sym->toPtr<int (*)()>();
+        result = func();
+    }
+    runTimeMs = elapsedMs(start);
+
+    return true;
+}
+
+bool JitRunner::defineSymbol(const std::string &name, void *address)
+{
+    if (!jit)
+        return false;
+
+    llvm::orc::SymbolMap symbols;
+    symbols[jit->mangleAndIntern(name)] = {llvm::orc::ExecutorAddr::fromPtr(address),
+                                           llvm::JITSymbolFlags::Exported};
+    if (auto err = jit->getMainJITDylib().define(llvm::orc::absoluteSymbols(std::move(symbols))))
+    {
+        error("Cannot define symbol " + name + ": " + llvm::toString(std::move(err)));
+        return false;
+    }
+    return true;
+}
+
+void *JitRunner::lookup(const std::string &name)
+{
+    if (!jit)
+        return nullptr;
+
+    auto start = std::chrono::steady_clock::now();
+    auto sym = jit->lookup(name);
+    if (!sym)
+    {
+        error("Cannot resolve symbol " + name + ": " + llvm::toString(sym.takeError()));
+        return nullptr;
+    }
+    compileTimeMs += elapsedMs(start);
+
+    return sym->toPtr<void *>();
+}
@@ -0,0 +1,119 @@
+#include "jit.h"
+#include "parser.h"
+#include "lexer.h"
+#include <iostream>
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        std::cout << "Usage: " << argv[0] << " <source_file|--test>" << std::endl;
+        std::cout << "\nExample: " << argv[0] << " test.c" << std::endl;
+        std::cout << "\nOr run with inline test:" << std::endl;
+        std::cout << "  " << argv[0] << " --test" << std::endl;
+        return 1;
+    }
+
+    SourceManager sources;
+    std::string_view source;
+    std::string filename;
+    bool builtinTest = false;
+
+    if (std::string(argv[1]) == "--test")
+    {
+        // 内置测试代码：main 返回 add(3, 4) + factorial(5) = 127
+        filename = "test.c";
+        builtinTest = true;
+        source = R"(
+int add(int a, int b) {
+    return a + b;
+}
+
+int factorial(int n) {
+    if (n <= 1) {
+        return 1;
+    }
+    return n * factorial(n - 1);
+}
+
+int main() {
+    int x = 3;
+    int y = 4;
+    int sum = add(x, y);
+    int fact = factorial(5);
+
+    return sum + fact;
+}
+)";
+    }
+    else
+    {
+        // 从文件读取
+        filename = argv[1];
+        const SourceBuffer *buffer = sources.load(filename);
+        if (!buffer)
+        {
+            std::cerr << "Error: " << sources.getError() << std::endl;
+            return 1;
+        }
+        source = buffer->text();
+    }
+
+    std::cout << "=== JIT running " << filename << " ===" << std::endl;
+
+    // 词法分析
+    Lexer lexer(filename, source);
+
+    // 语法分析
+    Parser parser(lexer);
+    auto ast = parser.parse();
+
+    // 检查解析错误
+    if (parser.hasErrors())
+    {
+        std::cerr << "\n=== Parse Errors ===" << std::endl;
+        for (const auto &error : parser.getErrors())
+        {
+            std::cerr << error << std::endl;
+        }
+        return 1;
+    }
+
+    // 语义分析和 IR 生成
+    CodeGenerator codegen(filename);
+    if (!codegen.generate(ast.get()))
+    {
+        std::cerr << "\n=== Semantic Errors ===" << std::endl;
+        for (const auto &error : codegen.getErrors())
+        {
+            std::cerr << error << std::endl;
+        }
+        return 1;
+    }
+
+    // JIT 编译并执行 main
+    JitRunner runner;
+    int result = 0;
+    if (!runner.addModule(codegen) || !runner.run(result))
+    {
+        std::cerr << "\n=== JIT Errors ===" << std::endl;
+        for (const auto &error : runner.getErrors())
+        {
+            std::cerr << error << std::endl;
+        }
+        return 1;
+    }
+
+    std::cout << "main() returned " << result << std::endl;
+    std::cout << "Compile time: " << runner.getCompileTime() << " ms" << std::endl;
+    std::cout << "Run time:     " << runner.getRunTime() << " ms" << std::endl;
+
+    if (builtinTest && result != 127)
+    {
+        std::cerr << "Unexpected result: expected 127" << std::endl;
+        return 1;
+    }
+
+    std::cout << "\n=== JIT execution completed successfully ===" << std::endl;
+    return 0;
+}
@@ -0,0 +1,162 @@
+#include "tiered.h"
+#include "parser.h"
+#include "lexer.h"
+#include <iostream>
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        std::cout << "Usage: " << argv[0] << " <source_file|--test> [threshold]" << std::endl;
+        std::cout << "\nExample: " << argv[0] << " test.c 100" << std::endl;
+        std::cout << "\nOr run with inline test:" << std::endl;
+        std::cout << "  " << argv[0] << " --test" << std::endl;
+        return 1;
+    }
+
+    SourceManager sources;
+    std::string_view source;
+    std::string filename;
+    bool builtinTest = false;
+    int32_t threshold = argc > 2 ? std::stoi(argv[2]) : TieredRunner::DEFAULT_HOT_THRESHOLD;
+
+    if (std::string(argv[1]) == "--test")
+    {
+        // 内置测试代码：square 与 sumTo 很快变热，之后的调用进入本地代码，
+        // sumTo 通过数组参数读取 VM 中的全局数组 g
+        // main 只调用一次，没有栈上替换，它的两个循环始终解释执行
+        // main 返回 50 * (10 * (0 + 1 + 4 + ... + 81) % 1000) = 42500
+        filename = "test.c";
+        builtinTest = true;
+        threshold = argc > 2 ? threshold : 10;
+        source = R"(
+int g[100];
+
+int square(int x) {
+    return x * x;
+}
+
+int sumTo(int arr[], int n) {
+    int s = 0;
+    int i = 0;
+    while (i < n) {
+        s = s + arr[i];
+        i = i + 1;
+    }
+    return s;
+}
+
+int main() {
+    int total = 0;
+    for (int i = 0; i < 100; i = i + 1) {
+        g[i] = square(i % 10);
+    }
+    for (int r = 0; r < 50; r = r + 1) {
+        total = total + sumTo(g, 100) % 1000;
+    }
+    return total;
+}
+)";
+    }
+    else
+    {
+        // 从文件读取
+        filename = argv[1];
+        const SourceBuffer *buffer = sources.load(filename);
+        if (!buffer)
+        {
+            std::cerr << "Error: " << sources.getError() << std::endl;
+            return 1;
+        }
+        source = buffer->text();
+    }
+
+    std::cout << "=== Tiered running " << filename << " (threshold " << threshold << ") ===" << std::endl;
+
+    // 词法分析
+    Lexer lexer(filename, source);
+
+    // 语法分析
+    Parser parser(lexer);
+    auto ast = parser.parse();
+
+    // 检查解析错误
+    if (parser.hasErrors())
+    {
+        std::cerr << "\n=== Parse Errors ===" << std::endl;
+        for (const auto &error : parser.getErrors())
+        {
+            std::cerr << error << std::endl;
+        }
+        return 1;
+    }
+
+    // 编译为字节码
+    BytecodeCompiler compiler;
+    if (!compiler.compile(ast.get()))
+    {
+        std::cerr << "\n=== Bytecode Errors ===" << std::endl;
+        for (const auto &error : compiler.getErrors())
+        {
+            std::cerr << error << std::endl;
+        }
+        return 1;
+    }
+    const Program &program = compiler.getProgram();
+
+    // 纯解释执行的结果作为参照
+    VM vm(program);
+    int expected = 0;
+    bool expectedOk = vm.run(expected);
+
+    // 分层执行
+    TieredRunner runner(ast.get(), program, threshold);
+    int result = 0;
+    bool ok = runner.run(result);
+
+    std::cout << "Compiled functions:";
+    for (const auto &name : runner.getCompiledFunctions())
+    {
+        std::cout << " " << name;
+    }
+    std::cout << std::endl;
+
+    // 运行时错误（除零、越界）必须与解释器报告的相同
+    if (!expectedOk || !ok)
+    {
+        if (ok || expectedOk || runner.getErrors() != vm.getErrors())
+        {
+            std::cerr << "\n=== Tiered errors differ from interpreter ===" << std::endl;
+            for (const auto &error : runner.getErrors())
+            {
+                std::cerr << "tiered:      " << error << std::endl;
+            }
+            for (const auto &error : vm.getErrors())
+            {
+                std::cerr << "interpreter: " << error << std::endl;
+            }
+            return 1;
+        }
+        std::cout << "\n=== Tiered execution reports the interpreter's error ===" << std::endl;
+        return 0;
+    }
+
+    std::cout << "main() returned " << result << " (interpreter: " << expected << ")" << std::endl;
+    std::cout << "Compile time: " << runner.getCompileTime() << " ms" << std::endl;
+    std::cout << "Run time:     " << runner.getRunTime() << " ms" << std::endl;
+
+    if (result != expected)
+    {
+        std::cerr << "Tiered result differs from interpreter" << std::endl;
+        return 1;
+    }
+
+    if (builtinTest && (result != 42500 || runner.getCompiledFunctions().size() < 2))
+    {
+        std::cerr << "Unexpected result: expected 42500 with square and sumTo compiled" << std::endl;
+        return 1;
+    }
+
+    std::cout << "\n=== Tiered execution completed successfully ===" << std::endl;
+    return 0;
+}
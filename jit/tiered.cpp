@@ -0,0 +1,347 @@
+#include "tiered.h"
+#include "ast_visitor.h"
+#include <llvm/IR/IRBuilder.h>
+#include <chrono>
+#include <iostream>
+
+/* -------------------------------------------------------------------------- */
+/*                              AST auxiliaries                               */
+/* -------------------------------------------------------------------------- */
+
+// 收集子树中调用的函数名与引用的变量名
+// 以及是否把局部数组（或其子数组）作为实参传递
+class ReferenceCollector : public ASTVisitor<ReferenceCollector>
+{
+private:
+    std::set<std::string> &calls;
+    std::set<std::string> &names;
+    std::map<std::string, size_t> localArrays; // 名字 -> 维数
+
+public:
+    bool passesLocalArray = false;
+
+    ReferenceCollector(std::set<std::string> &calls, std::set<std::string> &names)
+        : calls(calls), names(names) {}
+
+    void walk(const ASTNode *node)
+    {
+        if (node)
+            visit(node);
+    }
+
+    void visitLValExpr(const LValExpr *lval)
+    {
+        names.insert(lval->getName());
+        for (const auto &index : lval->getIndices())
+            walk(index);
+    }
+
+    void visitFuncCallExpr(const FuncCallExpr *call)
+    {
+        calls.insert(call->getName());
+        for (const auto &arg : call->getArgs())
+        {
+            // 按名字判断，同名的遮蔽只会使判断更保守
+            if (auto *lval = dyn_cast<LValExpr>(arg))
+            {
+                auto it = localArrays.find(lval->getName());
+                if (it != localArrays.end() && lval->getIndices().size() < it->second)
+                    passesLocalArray = true;
+            }
+            walk(arg);
+        }
+    }
+
+    void visitUnaryExpr(const UnaryExpr *un) { walk(un->getRhs()); }
+
+    void visitBinaryExpr(const BinaryExpr *bin)
+    {
+        walk(bin->getLhs());
+        walk(bin->getRhs());
+    }
+
+    void visitTernaryExpr(const TernaryExpr *tern)
+    {
+        walk(tern->getCond());
+        walk(tern->getTrueExpr());
+        walk(tern->getFalseExpr());
+    }
+
+    void visitInitListExpr(const InitListExpr *list)
+    {
+        for (const auto &item : list->getItems())
+            walk(item);
+    }
+
+    void visitExprStmt(const ExprStmt *stmt) { walk(stmt->getExpr()); }
+
+    void visitAssignStmt(const AssignStmt *assign)
+    {
+        walk(assign->getLhs());
+        walk(assign->getRhs());
+    }
+
+    void visitBlockStmt(const BlockStmt *block)
+    {
+        for (const auto &item : block->getItems())
+            walk(item);
+    }
+
+    void visitIfStmt(const IfStmt *stmt)
+    {
+        walk(stmt->getCond());
+        walk(stmt->getThenStmt());
+        walk(stmt->getElseStmt());
+    }
+
+    void visitWhileStmt(const WhileStmt *stmt)
+    {
+        walk(stmt->getCond());
+        walk(stmt->getBody());
+    }
+
+    void visitForStmt(const ForStmt *stmt)
+    {
+        walk(stmt->getInit());
+        walk(stmt->getCond());
+        walk(stmt->getStep());
+        walk(stmt->getBody());
+    }
+
+    void visitReturnStmt(const ReturnStmt *stmt) { walk(stmt->getValue()); }
+
+    void visitVarDecl(const VarDecl *decl)
+    {
+        for (const auto &varDef : decl->getVars())
+        {
+            if (!varDef->getDims().empty())
+                localArrays[varDef->getName()] = varDef->getDims().size();
+            for (const auto &dim : varDef->getDims())
+                walk(dim);
+            walk(varDef->getInit());
+        }
+    }
+};
+
+static double elapsedMs(std::chrono::steady_clock::time_point start)
+{
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+/* -------------------------------------------------------------------------- */
+/*                              Tiered Execution                              */
+/* -------------------------------------------------------------------------- */
+
+// 当前线程中正在执行 run() 的执行器，供 runtimeError 找到返回点
+static thread_local TieredRunner *activeRunner = nullptr;
+
+TieredRunner::TieredRunner(CompUnit *compUnit, const Program &program, int32_t hotThreshold)
+    : compUnit(compUnit), program(program), vm(program), moduleCount(0),
+      compileTimeMs(0.0), runTimeMs(0.0), hasErrors(false),
+      memoryBegin(vm.getMemory()), memoryEnd(vm.getMemory() + vm.getMemorySize())
+{
+    for (const auto &func : program.functions)
+    {
+        if (func.source)
+            funcDefs[func.name] = func.source;
+    }
+
+    // 全局变量绑定到 VM 内存中的存储位置
+    for (const auto &global : program.globalSymbols)
+    {
+        if (global.isChar)
+        {
+            charGlobals.insert(global.name);
+            continue;
+        }
+        jit.defineSymbol(global.name, vm.getMemory() + global.address);
+    }
+
+    // 本地代码的运行时检查
+    jit.defineSymbol("__cinterp_memory_begin", &memoryBegin);
+    jit.defineSymbol("__cinterp_memory_end", &memoryEnd);
+    jit.defineSymbol("__cinterp_runtime_error", reinterpret_cast<void *>(&TieredRunner::runtimeError));
+
+    vm.setTierUpHook([this](int functionIndex)
+                     { return tierUp(functionIndex); },
+                     hotThreshold);
+}
+
+void TieredRunner::error(const std::string &message)
+{
+    hasErrors = true;
+    errors.push_back(message);
+    std::cerr << "Tiered Error: " << message << std::endl;
+}
+
+void TieredRunner::runtimeError(int32_t kind, const char *function, int64_t value)
+{
+    // 与 VM::execute 中的错误信息相同
+    TieredRunner *runner = activeRunner;
+    switch (static_cast<RuntimeCheck>(kind))
+    {
+    case RuntimeCheck::DivisionByZero:
+        runner->trapMessage = std::string("Division by zero in function: ") + function;
+        break;
+    case RuntimeCheck::MemoryAccess:
+        runner->trapMessage = std::string("Memory access out of bounds in function ") + function +
+                              ": address " + std::to_string(value);
+        break;
+    case RuntimeCheck::ArrayAccess:
+        runner->trapMessage = std::string("Array access out of bounds in function ") + function +
+                              ": index " + std::to_string(value);
+        break;
+    }
+    std::longjmp(runner->trapTarget, 1);
+}
+
+bool TieredRunner::collectFunctions(const FuncDef *funcDef, std::set<const FuncDef *> &selected)
+{
+    if (!selected.insert(funcDef).second)
+        return true; // 已收集（递归调用）
+
+    // char 数组参数在 VM 中按 32 位单元存放，无法直接交给本地代码
+    for (const auto &param : funcDef->getParams())
+    {
+        if (param->getIsArray() && param->getType().kind == TypeSpec::CHAR)
+            return false;
+    }
+
+    std::set<std::string> calls, names;
+    ReferenceCollector collector(calls, names);
+    collector.walk(funcDef->getBody());
+
+    // 局部数组在本地栈上，被调函数无法按 VM 内存检查其数组参数
+    if (collector.passesLocalArray)
+        return false;
+
+    for (const auto &name : names)
+    {
+        if (charGlobals.count(name))
+            return false;
+    }
+
+    for (const auto &name : calls)
+    {
+        auto it = funcDefs.find(name);
+        if (it == funcDefs.end() || !collectFunctions(it->second, selected))
+            return false;
+    }
+    return true;
+}
+
+VM::NativeFunction TieredRunner::tierUp(int functionIndex)
+{
+    const BytecodeFunction &func = program.functions[functionIndex];
+
+    std::set<const FuncDef *> selected;
+    if (!func.source || !collectFunctions(func.source, selected))
+        return nullptr;
+
+    auto start = std::chrono::steady_clock::now();
+
+    // 仅为该函数及其调用的函数生成 IR，带与解释器相同的运行时检查
+    CodeGenerator codegen("tier." + func.name);
+    codegen.enableRuntimeChecks();
+    if (!codegen.generateFunctions(compUnit, selected))
+    {
+        compileTimeMs += elapsedMs(start);
+        return nullptr;
+    }
+
+    llvm::Module *module = codegen.getModule();
+    llvm::LLVMContext &context = module->getContext();
+    llvm::Function *target = module->getFunction(func.name);
+    if (!target)
+    {
+        compileTimeMs += elapsedMs(start);
+        return nullptr;
+    }
+
+    // 入口适配函数 int32_t entry(const int32_t *args, int32_t *mem)：
+    // 从实参寄存器取值，数组实参由 VM 内存地址转换为指针
+    llvm::Type *int32Ty = llvm::Type::getInt32Ty(context);
+    llvm::Type *ptrTy = llvm::PointerType::get(context, 0);
+    std::string entryName = "__tier_entry." + std::to_string(moduleCount++);
+    llvm::Function *entry = llvm::Function::Create(
+        llvm::FunctionType::get(int32Ty, {ptrTy, ptrTy}, false),
+        llvm::Function::ExternalLinkage, entryName, module);
+
+    llvm::IRBuilder<> builder(llvm::BasicBlock::Create(context, "entry", entry));
+    llvm::Value *argsPtr = entry->getArg(0);
+    llvm::Value *memPtr = entry->getArg(1);
+
+    std::vector<llvm::Value *> args;
+    for (size_t i = 0; i < func.source->getParams().size(); ++i)
+    {
+        const FuncParam *param = func.source->getParams()[i];
+        llvm::Value *slot = builder.CreateGEP(int32Ty, argsPtr, builder.getInt32(static_cast<uint32_t>(i)));
+        llvm::Value *value = builder.CreateLoad(int32Ty, slot);
+
+        if (param->getIsArray())
+            value = builder.CreateGEP(int32Ty, memPtr, value);
+        else if (param->getType().kind == TypeSpec::CHAR)
+            value = builder.CreateTrunc(value, builder.getInt8Ty());
+
+        args.push_back(value);
+    }
+
+    llvm::Value *result = builder.CreateCall(target, args);
+    if (target->getReturnType()->isVoidTy())
+        result = builder.getInt32(0);
+    else if (target->getReturnType()->isIntegerTy(8))
+        result = builder.CreateSExt(result, int32Ty);
+    builder.CreateRet(result);
+
+    // 其余函数仅供本模块使用，避免与之前编译的模块重名
+    for (auto &function : *module)
+    {
+        if (!function.isDeclaration() && &function != entry)
+            function.setLinkage(llvm::GlobalValue::InternalLinkage);
+    }
+
+    if (!jit.addModule(codegen))
+    {
+        compileTimeMs += elapsedMs(start);
+        return nullptr;
+    }
+
+    void *address = jit.lookup(entryName);
+    compileTimeMs += elapsedMs(start);
+    if (!address)
+        return nullptr;
+
+    compiledFunctions.push_back(func.name);
+    return reinterpret_cast<VM::NativeFunction>(address);
+}
+
+bool TieredRunner::run(int &result, const std::string &entry)
+{
+    double compileBefore = compileTimeMs;
+    auto start = std::chrono::steady_clock::now();
+
+    // 本地代码的运行时检查失败时从 runtimeError 跳回这里，跳过的 VM 栈帧没有需要析构的对象，
+    // VM 的执行状态在下次 run 时重新建立
+    TieredRunner *previousRunner = activeRunner;
+    activeRunner = this;
+    if (setjmp(trapTarget) != 0)
+    {
+        activeRunner = previousRunner;
+        runTimeMs += elapsedMs(start) - (compileTimeMs - compileBefore);
+        error(trapMessage);
+        return false;
+    }
+
+    bool ok = vm.run(result, entry);
+    activeRunner = previousRunner;
+    runTimeMs += elapsedMs(start) - (compileTimeMs - compileBefore);
+
+    if (!ok)
+    {
+        // VM 已输出错误信息，这里只记录
+        hasErrors = true;
+        errors.insert(errors.end(), vm.getErrors().begin(), vm.getErrors().end());
+    }
+    return ok;
+}
@@ -0,0 +1,323 @@
+#include "char_scan.h"
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#if LEXER_USE_SIMD
+#include <immintrin.h>
+#endif
+
+/* -------------------------------------------------------------------------- */
+/*                               Scalar Kernels                               */
+/* -------------------------------------------------------------------------- */
+
+namespace
+{
+    inline bool isBlank(char c)
+    {
+        return c == ' ' || (c >= '\t' && c <= '\r');
+    }
+
+    inline bool isIdentifierChar(char c)
+    {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+    }
+
+    const char *skipBlanksScalar(const char *p)
+    {
+        while (isBlank(*p))
+            ++p;
+        return p;
+    }
+
+    const char *findLineEndScalar(const char *p)
+    {
+        while (*p != '\n' && *p != '\0')
+            ++p;
+        return p;
+    }
+
+    const char *findCommentEndScalar(const char *p)
+    {
+        for (; *p != '\0'; ++p)
+        {
+            if (*p == '*' && p[1] == '/')
+                break;
+        }
+        return p;
+    }
+
+    const char *skipIdentifierScalar(const char *p)
+    {
+        while (isIdentifierChar(*p))
+            ++p;
+        return p;
+    }
+
+    const char *findLiteralStartScalar(const char *p)
+    {
+        while (*p != '"' && *p != '\'' && *p != '/' && *p != '\0')
+            ++p;
+        return p;
+    }
+
+    const ScanKernels scalarKernels = {ScanLevel::Scalar, skipBlanksScalar, findLineEndScalar,
+                                       findCommentEndScalar, skipIdentifierScalar, findLiteralStartScalar};
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                SIMD Kernels                                */
+/* -------------------------------------------------------------------------- */
+
+#if LEXER_USE_SIMD
+
+// 整块读取会越过对象的边界（见 char_scan.h），AddressSanitizer 不检查这些函数
+#define SCAN_SSE2 __attribute__((target("sse2"), no_sanitize_address))
+#define SCAN_AVX2 __attribute__((target("avx2"), no_sanitize_address))
+
+/*
+ * 两套内核结构相同，只是向量宽度不同：
+ * 每个块先用比较 + movemask 得到“停止字节”的位掩码（第 i 位对应块内第 i 个字节），
+ * 再用 ctz 取第一个停止位置。首块从 p 所在的对齐地址读取，p 之前的位被移出。
+ * 区间判断使用有符号比较，>= 0x80 的字节为负数，不会落入任何 ASCII 区间。
+ */
+namespace
+{
+    template <uintptr_t WIDTH>
+    inline const char *alignDown(const char *p)
+    {
+        return reinterpret_cast<const char *>(reinterpret_cast<uintptr_t>(p) & ~(WIDTH - 1));
+    }
+}
+
+namespace sse2
+{
+    using Vec = __m128i;
+    constexpr uintptr_t WIDTH = 16;
+    constexpr uint32_t FULL = 0xFFFF;
+
+    SCAN_SSE2 inline Vec load(const char *p) { return _mm_load_si128(reinterpret_cast<const Vec *>(p)); }
+
+    SCAN_SSE2 inline uint32_t equal(Vec v, char c)
+    {
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(c))));
+    }
+
+    // lo <= v <= hi
+    SCAN_SSE2 inline uint32_t inRange(Vec v, char lo, char hi)
+    {
+        Vec ge = _mm_cmpgt_epi8(v, _mm_set1_epi8(static_cast<char>(lo - 1)));
+        Vec le = _mm_cmpgt_epi8(_mm_set1_epi8(static_cast<char>(hi + 1)), v);
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_and_si128(ge, le)));
+    }
+
+    // 空格与 \t \n \v \f \r（9..13）之外的字节
+    SCAN_SSE2 inline uint32_t notBlank(Vec v)
+    {
+        uint32_t blank = equal(v, ' ') | inRange(v, '\t', '\r');
+        return ~blank & FULL;
+    }
+
+    SCAN_SSE2 inline uint32_t lineEnd(Vec v) { return equal(v, '\n') | equal(v, '\0'); }
+
+    SCAN_SSE2 inline uint32_t literalStart(Vec v)
+    {
+        return equal(v, '"') | equal(v, '\'') | equal(v, '/') | equal(v, '\0');
+    }
+
+    // 大写字母或上 0x20 变为小写，其余字节不会因此落入 a-z
+    SCAN_SSE2 inline uint32_t notIdentifier(Vec v)
+    {
+        Vec lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+        uint32_t ident = inRange(lower, 'a', 'z') | inRange(v, '0', '9') | equal(v, '_');
+        return ~ident & FULL;
+    }
+
+    template <uint32_t (*STOP)(Vec)>
+    SCAN_SSE2 const char *findFirst(const char *p)
+    {
+        const char *block = alignDown<WIDTH>(p);
+        uint32_t stop = STOP(load(block)) >> (p - block);
+        if (stop)
+            return p + __builtin_ctz(stop);
+        for (block += WIDTH;; block += WIDTH)
+        {
+            stop = STOP(load(block));
+            if (stop)
+                return block + __builtin_ctz(stop);
+        }
+    }
+
+    SCAN_SSE2 const char *findCommentEnd(const char *p)
+    {
+        const char *block = alignDown<WIDTH>(p);
+        uint32_t valid = (FULL << (p - block)) & FULL;
+        uint32_t carry = 0; // 上一块的最后一个字节是 '*'
+        for (;; block += WIDTH, valid = FULL)
+        {
+            Vec v = load(block);
+            uint32_t star = equal(v, '*') & valid;
+            uint32_t slash = equal(v, '/');
+            if (carry && (slash & 1))
+                return block - 1;
+
+            uint32_t stop = (star & (slash >> 1)) | (equal(v, '\0') & valid);
+            if (stop)
+                return block + __builtin_ctz(stop);
+            carry = star >> (WIDTH - 1);
+        }
+    }
+
+    const ScanKernels kernels = {ScanLevel::SSE2, findFirst<notBlank>, findFirst<lineEnd>, findCommentEnd,
+                                 findFirst<notIdentifier>, findFirst<literalStart>};
+}
+
+namespace avx2
+{
+    using Vec = __m256i;
+    constexpr uintptr_t WIDTH = 32;
+    constexpr uint32_t FULL = 0xFFFFFFFF;
+
+    SCAN_AVX2 inline Vec load(const char *p) { return _mm256_load_si256(reinterpret_cast<const Vec *>(p)); }
+
+    SCAN_AVX2 inline uint32_t equal(Vec v, char c)
+    {
+        return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(c))));
+    }
+
+    SCAN_AVX2 inline uint32_t inRange(Vec v, char lo, char hi)
+    {
+        Vec ge = _mm256_cmpgt_epi8(v, _mm256_set1_epi8(static_cast<char>(lo - 1)));
+        Vec le = _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(hi + 1)), v);
+        return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_and_si256(ge, le)));
+    }
+
+    SCAN_AVX2 inline uint32_t notBlank(Vec v)
+    {
+        uint32_t blank = equal(v, ' ') | inRange(v, '\t', '\r');
+        return ~blank;
+    }
+
+    SCAN_AVX2 inline uint32_t lineEnd(Vec v) { return equal(v, '\n') | equal(v, '\0'); }
+
+    SCAN_AVX2 inline uint32_t literalStart(Vec v)
+    {
+        return equal(v, '"') | equal(v, '\'') | equal(v, '/') | equal(v, '\0');
+    }
+
+    SCAN_AVX2 inline uint32_t notIdentifier(Vec v)
+    {
+        Vec lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+        uint32_t ident = inRange(lower, 'a', 'z') | inRange(v, '0', '9') | equal(v, '_');
+        return ~ident;
+    }
+
+    template <uint32_t (*STOP)(Vec)>
+    SCAN_AVX2 const char *findFirst(const char *p)
+    {
+        const char *block = alignDown<WIDTH>(p);
+        uint32_t stop = STOP(load(block)) >> (p - block);
+        if (stop)
+            return p + __builtin_ctz(stop);
+        for (block += WIDTH;; block += WIDTH)
+        {
+            stop = STOP(load(block));
+            if (stop)
+                return block + __builtin_ctz(stop);
+        }
+    }
+
+    SCAN_AVX2 const char *findCommentEnd(const char *p)
+    {
+        const char *block = alignDown<WIDTH>(p);
+        uint32_t valid = FULL << (p - block);
+        uint32_t carry = 0;
+        for (;; block += WIDTH, valid = FULL)
+        {
+            Vec v = load(block);
+            uint32_t star = equal(v, '*') & valid;
+            uint32_t slash = equal(v, '/');
+            if (carry && (slash & 1))
+                return block - 1;
+
+            uint32_t stop = (star & (slash >> 1)) | (equal(v, '\0') & valid);
+            if (stop)
+                return block + __builtin_ctz(stop);
+            carry = star >> (WIDTH - 1);
+        }
+    }
+
+    const ScanKernels kernels = {ScanLevel::AVX2, findFirst<notBlank>, findFirst<lineEnd>, findCommentEnd,
+                                 findFirst<notIdentifier>, findFirst<literalStart>};
+}
+
+#endif // LEXER_USE_SIMD
+
+/* -------------------------------------------------------------------------- */
+/*                                  Dispatch                                  */
+/* -------------------------------------------------------------------------- */
+
+const char *scanLevelName(ScanLevel level)
+{
+    switch (level)
+    {
+    case ScanLevel::Scalar:
+        return "scalar";
+    case ScanLevel::SSE2:
+        return "sse2";
+    case ScanLevel::AVX2:
+        return "avx2";
+    }
+    return "unknown";
+}
+
+const ScanKernels *getScanKernels(ScanLevel level)
+{
+    switch (level)
+    {
+    case ScanLevel::Scalar:
+        return &scalarKernels;
+#if LEXER_USE_SIMD
+    case ScanLevel::SSE2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse2") ? &sse2::kernels : nullptr;
+    case ScanLevel::AVX2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") ? &avx2::kernels : nullptr;
+#else
+    default:
+        return nullptr;
+#endif
+    }
+    return nullptr;
+}
+
+namespace
+{
+    const ScanKernels &selectKernels()
+    {
+        ScanLevel highest = ScanLevel::AVX2;
+        if (const char *requested = std::getenv("CINTERP_LEXER_SCAN"))
+        {
+            const ScanLevel levels[] = {ScanLevel::Scalar, ScanLevel::SSE2, ScanLevel::AVX2};
+            for (ScanLevel level : levels)
+            {
+                if (std::strcmp(requested, scanLevelName(level)) == 0)
+                    highest = level;
+            }
+        }
+
+        // 从请求的级别向下找第一个可用的
+        for (int level = static_cast<int>(highest); level > 0; --level)
+        {
+            if (const ScanKernels *kernels = getScanKernels(static_cast<ScanLevel>(level)))
+                return *kernels;
+        }
+        return scalarKernels;
+    }
+}
+
+const ScanKernels &getScanKernels()
+{
+    static const ScanKernels &selected = selectKernels();
+    return selected;
+}
@@ -1,239 +1,439 @@
 #include "lexer.h"
-#include <cctype>
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
 #include <iostream>
 #include <sstream>
-#include <map>
+
+static_assert(sizeof(Token) == 32, "Token must stay 32 bytes");
 
 // Token 到字符串的转换
 std::string Token::toString() const
 {
     std::stringstream ss;
-    ss << "Token(" << static_cast<int>(type) << ", \"" << lexeme << "\", "
-       << location.line << ":" << location.column << ")";
+    ss << "Token(" << static_cast<int>(type) << ", "
+       << "@" << location.offset << "+" << length << ")";
     return ss.str();
 }
 
-// 关键字映射表
-static const std::map<std::string, TokenType> keywords = {
-    {"int", TokenType::TOK_INT},
-    {"char", TokenType::TOK_CHAR},
-    {"void", TokenType::TOK_VOID},
-    {"const", TokenType::TOK_CONST},
-    {"if", TokenType::TOK_IF},
-    {"else", TokenType::TOK_ELSE},
-    {"while", TokenType::TOK_WHILE},
-    {"for", TokenType::TOK_FOR},
-    {"return", TokenType::TOK_RETURN}};
+/* -------------------------------------------------------------------------- */
+/*                             Keyword Perfect Hash                           */
+/* -------------------------------------------------------------------------- */
 
-// 构造函数
-Lexer::Lexer(const std::string &filename, const std::string &source)
-    : filename_(filename),
-      source_(source), position_(0), line_(1), column_(1), hasErrors_(false)
+namespace
 {
-}
+    struct KeywordEntry
+    {
+        std::string_view spelling;
+        TokenType type;
+    };
 
-// 获取当前字符
-char Lexer::currentChar() const
-{
-    if (position_ >= source_.length())
+    constexpr KeywordEntry keywordList[] = {
+        {"int", TokenType::TOK_INT},
+        {"char", TokenType::TOK_CHAR},
+        {"void", TokenType::TOK_VOID},
+        {"const", TokenType::TOK_CONST},
+        {"if", TokenType::TOK_IF},
+        {"else", TokenType::TOK_ELSE},
+        {"while", TokenType::TOK_WHILE},
+        {"for", TokenType::TOK_FOR},
+        {"return", TokenType::TOK_RETURN},
+        {"break", TokenType::TOK_BREAK},
+        {"continue", TokenType::TOK_CONTINUE}};
+
+    constexpr size_t KEYWORD_MIN_LENGTH = 2;
+    constexpr size_t KEYWORD_MAX_LENGTH = 8;
+    constexpr size_t KEYWORD_TABLE_SIZE = 32;
+
+    // 长度 + 首字符 + 尾字符，对当前关键字集合无冲突（由下方 static_assert 保证）
+    constexpr size_t keywordHash(std::string_view word)
     {
-        return '\0';
+        return (word.size() + static_cast<unsigned char>(word.front()) +
+                static_cast<unsigned char>(word.back())) &
+               (KEYWORD_TABLE_SIZE - 1);
     }
-    return source_[position_];
-}
 
-// 查看前面的字符
-char Lexer::peekChar(int offset) const
-{
-    size_t pos = position_ + offset;
-    if (pos >= source_.length())
+    struct KeywordTable
     {
-        return '\0';
-    }
-    return source_[pos];
-}
+        KeywordEntry slots[KEYWORD_TABLE_SIZE];
+        bool perfect;
+    };
 
-// 前进一个字符
-void Lexer::advance()
-{
-    if (position_ < source_.length())
+    // 编译期构造散列表，空槽位的 spelling 为空串
+    constexpr KeywordTable buildKeywordTable()
     {
-        if (source_[position_] == '\n')
-        {
-            line_++;
-            column_ = 1;
-        }
-        else
+        KeywordTable table{};
+        table.perfect = true;
+        for (const auto &entry : keywordList)
         {
-            column_++;
+            KeywordEntry &slot = table.slots[keywordHash(entry.spelling)];
+            if (!slot.spelling.empty() ||
+                entry.spelling.size() < KEYWORD_MIN_LENGTH ||
+                entry.spelling.size() > KEYWORD_MAX_LENGTH)
+            {
+                table.perfect = false;
+            }
+            slot = entry;
         }
-        position_++;
+        return table;
     }
+
+    constexpr KeywordTable keywordTable = buildKeywordTable();
+    static_assert(keywordTable.perfect, "keyword hash has collisions; adjust keywordHash()");
 }
 
-// 跳过空白字符
-void Lexer::skipWhitespace()
+/* -------------------------------------------------------------------------- */
+/*                              Character Classes                             */
+/* -------------------------------------------------------------------------- */
+
+// 各扫描函数只在 nextToken 中调用，强制内联以省去每个 token 的调用与寄存器保存
+#if defined(__GNUC__)
+#define LEXER_INLINE inline __attribute__((always_inline))
+#else
+#define LEXER_INLINE inline
+#endif
+
+namespace
 {
-    while (std::isspace(currentChar()))
+    // 字符类别（可组合的位标志），按字节查表，'\0' 不属于任何类别
+    enum CharClass : uint8_t
     {
-        advance();
-    }
-}
+        CC_SPACE = 1 << 0,       // 空白（含换行），与 C 区域的 isspace 一致
+        CC_IDENT_START = 1 << 2, // 字母与下划线
+        CC_DIGIT = 1 << 3,       // 0-9
+        CC_OCTAL_DIGIT = 1 << 4, // 0-7
+        CC_HEX_DIGIT = 1 << 5,   // 0-9 a-f A-F
+    };
 
-// 跳过注释
-void Lexer::skipComment()
-{
-    if (currentChar() == '/' && peekChar() == '/')
+    constexpr uint8_t CC_IDENT = CC_IDENT_START | CC_DIGIT;
+
+    // token 的起始类别，决定 nextToken 进入哪个扫描函数
+    enum class TokenStart : uint8_t
     {
-        // 单行注释
-        while (currentChar() != '\n' && currentChar() != '\0')
+        End,
+        Identifier,
+        Number,
+        String,
+        Char,
+        Operator,
+    };
+
+    struct CharTables
+    {
+        uint8_t classes[256];
+        uint8_t digitValue[256]; // 十六进制数位的值
+        TokenStart start[256];
+    };
+
+    constexpr CharTables buildCharTables()
+    {
+        CharTables tables{};
+        for (int c = 0; c < 256; ++c)
         {
-            advance();
+            uint8_t cls = 0;
+            if (c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r')
+                cls |= CC_SPACE;
+            if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_')
+                cls |= CC_IDENT_START;
+            if (c >= '0' && c <= '9')
+                cls |= CC_DIGIT | CC_HEX_DIGIT;
+            if (c >= '0' && c <= '7')
+                cls |= CC_OCTAL_DIGIT;
+            if ((c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F'))
+                cls |= CC_HEX_DIGIT;
+            tables.classes[c] = cls;
+
+            tables.digitValue[c] = (c >= '0' && c <= '9')   ? c - '0'
+                                   : (c >= 'a' && c <= 'f') ? c - 'a' + 10
+                                   : (c >= 'A' && c <= 'F') ? c - 'A' + 10
+                                                            : 0;
+
+            tables.start[c] = c == '\0'                    ? TokenStart::End
+                              : (cls & CC_IDENT_START)     ? TokenStart::Identifier
+                              : (cls & CC_DIGIT)           ? TokenStart::Number
+                              : c == '"'                   ? TokenStart::String
+                              : c == '\''                  ? TokenStart::Char
+                                                           : TokenStart::Operator;
         }
+        return tables;
+    }
+
+    constexpr CharTables charTables = buildCharTables();
+
+    inline uint8_t classOf(char c)
+    {
+        return charTables.classes[static_cast<unsigned char>(c)];
     }
-    else if (currentChar() == '/' && peekChar() == '*')
+
+    /* ---------------------------- Operator DFA ---------------------------- */
+
+    // 运算符自动机：状态为首字符，至多再接受一个字符（所有双字符运算符）
+    struct OperatorState
+    {
+        TokenType single;  // 只有首字符时的 token，TOK_ERROR 表示不是运算符
+        char next[2];      // 可接受的第二个字符（'\0' 表示无）
+        TokenType pair[2]; // 接受第二个字符后的 token
+    };
+
+    struct OperatorTable
+    {
+        OperatorState states[256];
+    };
+
+    constexpr OperatorTable buildOperatorTable()
     {
-        // 多行注释
-        advance(); // skip '/'
-        advance(); // skip '*'
-        while (currentChar() != '\0')
+        OperatorTable table{};
+        for (auto &state : table.states)
         {
-            if (currentChar() == '*' && peekChar() == '/')
-            {
-                advance(); // skip '*'
-                advance(); // skip '/'
-                break;
-            }
-            advance();
+            state = {TokenType::TOK_ERROR, {'\0', '\0'}, {TokenType::TOK_ERROR, TokenType::TOK_ERROR}};
         }
+
+        struct Single
+        {
+            char c;
+            TokenType type;
+        };
+        constexpr Single singles[] = {
+            {'+', TokenType::TOK_PLUS}, {'-', TokenType::TOK_MINUS}, {'*', TokenType::TOK_STAR},
+            {'/', TokenType::TOK_SLASH}, {'%', TokenType::TOK_PERCENT}, {'=', TokenType::TOK_ASSIGN},
+            {'<', TokenType::TOK_LT}, {'>', TokenType::TOK_GT}, {'&', TokenType::TOK_AND},
+            {'|', TokenType::TOK_OR}, {'^', TokenType::TOK_XOR}, {'!', TokenType::TOK_NOT},
+            {'~', TokenType::TOK_TILDE}, {'(', TokenType::TOK_LPAREN}, {')', TokenType::TOK_RPAREN},
+            {'{', TokenType::TOK_LBRACE}, {'}', TokenType::TOK_RBRACE}, {'[', TokenType::TOK_LBRACKET},
+            {']', TokenType::TOK_RBRACKET}, {';', TokenType::TOK_SEMICOLON}, {',', TokenType::TOK_COMMA},
+            {'.', TokenType::TOK_DOT}, {':', TokenType::TOK_COLON}, {'?', TokenType::TOK_QUESTION}};
+        for (const auto &single : singles)
+        {
+            table.states[static_cast<unsigned char>(single.c)].single = single.type;
+        }
+
+        struct Pair
+        {
+            char first, second;
+            TokenType type;
+        };
+        constexpr Pair pairs[] = {
+            {'+', '+', TokenType::TOK_INC}, {'-', '-', TokenType::TOK_DEC}, {'=', '=', TokenType::TOK_EQ},
+            {'!', '=', TokenType::TOK_NE}, {'<', '=', TokenType::TOK_LE}, {'<', '<', TokenType::TOK_SHL},
+            {'>', '=', TokenType::TOK_GE}, {'>', '>', TokenType::TOK_SHR}, {'&', '&', TokenType::TOK_LAND},
+            {'|', '|', TokenType::TOK_LOR}};
+        for (const auto &pair : pairs)
+        {
+            OperatorState &state = table.states[static_cast<unsigned char>(pair.first)];
+            int slot = state.next[0] == '\0' ? 0 : 1;
+            state.next[slot] = pair.second;
+            state.pair[slot] = pair.type;
+        }
+        return table;
     }
+
+    constexpr OperatorTable operatorTable = buildOperatorTable();
 }
 
-// 字符分类函数
-bool Lexer::isAlpha(char c) const
+/* -------------------------------------------------------------------------- */
+/*                                 Line Table                                 */
+/* -------------------------------------------------------------------------- */
+
+// 换行之后的位置都是行首；源码中间的 '\0' 由 findLineEnd 返回后跳过即可
+LineTable::LineTable(std::string_view source)
 {
-    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+    const ScanKernels &scan = getScanKernels();
+    const char *begin = source.data();
+    const char *end = begin + source.size();
+    lineStarts_.push_back(0);
+    for (const char *p = scan.findLineEnd(begin); p < end; p = scan.findLineEnd(p + 1))
+    {
+        if (*p == '\n')
+            lineStarts_.push_back(static_cast<uint32_t>(p + 1 - begin));
+    }
 }
 
-bool Lexer::isDigit(char c) const
+int LineTable::getLine(uint32_t offset) const
 {
-    return c >= '0' && c <= '9';
+    // 最后一个不大于 offset 的行首
+    auto it = std::upper_bound(lineStarts_.begin(), lineStarts_.end(), offset);
+    return static_cast<int>(it - lineStarts_.begin());
 }
 
-bool Lexer::isAlnum(char c) const
+int LineTable::getColumn(uint32_t offset) const
 {
-    return isAlpha(c) || isDigit(c);
+    return static_cast<int>(offset - lineStarts_[getLine(offset) - 1]) + 1;
 }
 
-bool Lexer::isHexDigit(char c) const
+/* -------------------------------------------------------------------------- */
+/*                                    Lexer                                   */
+/* -------------------------------------------------------------------------- */
+
+// 构造函数
+Lexer::Lexer(const std::string &filename, std::string_view source,
+             std::shared_ptr<IdentifierTable> identifiers, uint16_t fileId)
+    : filename_(filename),
+      source_(source.data() ? source : std::string_view("", 0)),
+      identifiers_(identifiers ? std::move(identifiers) : std::make_shared<IdentifierTable>()),
+      scan_(&getScanKernels()), cur_(source_.data()), fileId_(fileId), hasErrors_(false), hasPeeked_(false),
+      deferErrors_(false)
 {
-    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+    assert(source_.data()[source_.size()] == '\0' && "source must be followed by a NUL sentinel");
+    assert(source_.size() <= UINT32_MAX && "source offsets must fit in 32 bits");
 }
 
-bool Lexer::isOctalDigit(char c) const
+PresumedLocation Lexer::resolveLocation(SourceLocation loc) const
 {
-    return c >= '0' && c <= '7';
+    assert(loc.fileId == fileId_ && "location belongs to another file");
+    if (!lineTable_)
+        lineTable_ = std::make_unique<LineTable>(source_);
+    return {filename_, lineTable_->getLine(loc.offset), lineTable_->getColumn(loc.offset)};
 }
 
-// 检查是否为关键字
-TokenType Lexer::getKeywordType(const std::string &identifier)
+// 跳过空白与注释（换行也是普通空白，行号由 LineTable 事后计算）
+// 短的空白逐字节处理；超过 8 字节的空白（深缩进、对齐）与注释交给批量扫描内核
+LEXER_INLINE void Lexer::skipWhitespaceAndComments()
 {
-    auto it = keywords.find(identifier);
-    if (it != keywords.end())
+    const char *p = cur_;
+    while (true)
     {
-        return it->second;
+        uint8_t cls = classOf(*p);
+        if (cls & CC_SPACE)
+        {
+            const char *shortEnd = p + 8;
+            for (++p; p < shortEnd && (classOf(*p) & CC_SPACE); ++p)
+            {
+            }
+            if (p == shortEnd && (classOf(*p) & CC_SPACE))
+                p = scan_->skipBlanks(p);
+        }
+        else if (*p == '/' && p[1] == '/')
+        {
+            // 单行注释：换行留给下一轮处理
+            p = scan_->findLineEnd(p + 2);
+        }
+        else if (*p == '/' && p[1] == '*')
+        {
+            // 多行注释（未闭合时停在结尾）
+            p = scan_->findCommentEnd(p + 2);
+            if (*p != '\0')
+                p += 2;
+        }
+        else
+        {
+            break;
+        }
     }
-    return TokenType::TOK_IDENTIFIER;
+    cur_ = p;
 }
 
-// 读取标识符或关键字
-Token Lexer::readIdentifierOrKeyword()
+// 检查是否为关键字：一次散列 + 至多一次逐字符比较（关键字很短，不调用 memcmp）
+LEXER_INLINE TokenType Lexer::getKeywordType(std::string_view identifier)
 {
-    SourceLocation loc = getCurrentLocation();
-    std::string identifier;
+    if (identifier.size() < KEYWORD_MIN_LENGTH || identifier.size() > KEYWORD_MAX_LENGTH)
+    {
+        return TokenType::TOK_IDENTIFIER;
+    }
 
-    while (isAlnum(currentChar()))
+    const KeywordEntry &slot = keywordTable.slots[keywordHash(identifier)];
+    if (slot.spelling.size() != identifier.size())
     {
-        identifier += currentChar();
-        advance();
+        return TokenType::TOK_IDENTIFIER;
     }
+    for (size_t i = 0; i < identifier.size(); ++i)
+    {
+        if (slot.spelling[i] != identifier[i])
+            return TokenType::TOK_IDENTIFIER;
+    }
+    return slot.type;
+}
 
+// 读取标识符或关键字
+LEXER_INLINE Token Lexer::readIdentifierOrKeyword()
+{
+    SourceLocation loc = getCurrentLocation();
+    const char *start = cur_;
+    // 大多数标识符很短，前 8 个字节逐字节扫描，更长的交给批量扫描内核
+    const char *p = cur_ + 1;
+    const char *shortEnd = cur_ + 8;
+    while (p < shortEnd && (classOf(*p) & CC_IDENT))
+        ++p;
+    if (p == shortEnd && (classOf(*p) & CC_IDENT))
+        p = scan_->skipIdentifier(p);
+    cur_ = p;
+
+    std::string_view identifier(start, p - start);
     TokenType type = getKeywordType(identifier);
-    return Token(type, identifier, loc);
+    Token token(type, static_cast<uint32_t>(identifier.size()), loc);
+    if (type == TokenType::TOK_IDENTIFIER)
+    {
+        token.identifier = identifiers_->intern(identifier);
+    }
+    return token;
 }
 
-// 读取数字
-Token Lexer::readNumber()
+// 读取数字（0x 开头为十六进制，0 后接八进制数位为八进制，其余为十进制）
+LEXER_INLINE Token Lexer::readNumber()
 {
     SourceLocation loc = getCurrentLocation();
-    std::string number;
+    const char *start = cur_;
+    const char *p = cur_;
     long long value = 0;
-    int base = 10;
 
-    // 检查十六进制
-    if (currentChar() == '0' && (peekChar() == 'x' || peekChar() == 'X'))
+    if (p[0] == '0' && (p[1] == 'x' || p[1] == 'X'))
     {
-        base = 16;
-        number += currentChar();
-        advance(); // '0'
-        number += currentChar();
-        advance(); // 'x' or 'X'
-
-        while (isHexDigit(currentChar()))
-        {
-            char c = currentChar();
-            number += c;
-            int digit = (c >= '0' && c <= '9') ? (c - '0') : (c >= 'a' && c <= 'f') ? (c - 'a' + 10)
-                                                                                    : (c - 'A' + 10);
-            value = value * 16 + digit;
-            advance();
-        }
+        for (p += 2; classOf(*p) & CC_HEX_DIGIT; ++p)
+            value = value * 16 + charTables.digitValue[static_cast<unsigned char>(*p)];
     }
-    // 检查八进制
-    else if (currentChar() == '0' && isOctalDigit(peekChar()))
+    else if (p[0] == '0' && (classOf(p[1]) & CC_OCTAL_DIGIT))
     {
-        base = 8;
-        number += currentChar();
-        advance(); // '0'
-
-        while (isOctalDigit(currentChar()))
-        {
-            char c = currentChar();
-            number += c;
-            value = value * 8 + (c - '0');
-            advance();
-        }
+        for (++p; classOf(*p) & CC_OCTAL_DIGIT; ++p)
+            value = value * 8 + (*p - '0');
     }
-    // 十进制
     else
     {
-        while (isDigit(currentChar()))
-        {
-            char c = currentChar();
-            number += c;
-            value = value * 10 + (c - '0');
-            advance();
-        }
+        for (; classOf(*p) & CC_DIGIT; ++p)
+            value = value * 10 + (*p - '0');
     }
+    cur_ = p;
 
-    Token token(TokenType::TOK_NUMBER, number, loc);
+    Token token(TokenType::TOK_NUMBER, static_cast<uint32_t>(p - start), loc);
     token.value.intValue = value;
     return token;
 }
 
-// 读取字符串字面量
+// 读取字符串字面量（只确定范围，转义序列由 decodeStringLiteral 解码）
 Token Lexer::readString()
 {
     SourceLocation loc = getCurrentLocation();
+    const char *start = cur_;
+    const char *p = cur_ + 1; // skip opening "
+
+    for (char c; (c = *p) != '"' && c != '\0'; ++p)
+    {
+        // 转义字符与反斜杠一起跳过
+        if (c == '\\' && p[1] != '\0')
+            ++p;
+    }
+
+    if (*p == '"')
+        ++p; // skip closing "
+    cur_ = p;
+    return Token(TokenType::TOK_STRING, static_cast<uint32_t>(p - start), loc);
+}
+
+// 解码字符串字面量
+std::string decodeStringLiteral(std::string_view spelling)
+{
+    // 去掉两端引号（未闭合的字面量没有结尾引号）
+    if (!spelling.empty() && spelling.front() == '"')
+        spelling.remove_prefix(1);
+    if (!spelling.empty() && spelling.back() == '"')
+        spelling.remove_suffix(1);
+
     std::string strLit;
-    advance(); // skip opening "
+    strLit.reserve(spelling.size());
 
-    while (currentChar() != '"' && currentChar() != '\0')
+    for (size_t i = 0; i < spelling.size(); ++i)
     {
-        if (currentChar() == '\\')
+        if (spelling[i] == '\\' && i + 1 < spelling.size())
         {
-            advance();
-            char esc = currentChar();
+            char esc = spelling[++i];
             switch (esc)
             {
             case 'n':
@@ -258,261 +458,225 @@ Token Lexer::readString()
         }
         else
         {
-            strLit += currentChar();
+            strLit += spelling[i];
         }
-        advance();
     }
 
-    advance(); // skip closing "
-    return Token(TokenType::TOK_STRING, strLit, loc);
+    return strLit;
 }
 
 // 读取字符字面量
 Token Lexer::readCharLiteral()
 {
     SourceLocation loc = getCurrentLocation();
-    std::string charLit;
-
-    advance(); // skip opening quote
+    const char *start = cur_;
+    const char *p = cur_ + 1; // skip opening quote
+    char value = '\0';
 
-    if (currentChar() == '\\')
+    if (*p == '\\')
     {
-        advance();
-        switch (currentChar())
+        ++p;
+        switch (*p)
         {
         case 'n':
-            charLit += '\n';
+            value = '\n';
             break;
         case 't':
-            charLit += '\t';
+            value = '\t';
             break;
         case 'r':
-            charLit += '\r';
-            break;
-        case '\\':
-            charLit += '\\';
-            break;
-        case '\'':
-            charLit += '\'';
+            value = '\r';
             break;
         case '0':
-            charLit += '\0';
+            value = '\0';
             break;
         default:
-            charLit += currentChar();
+            value = *p; // \\、\' 以及未知转义都取字符本身
             break;
         }
-        advance();
+        if (*p != '\0')
+            ++p;
     }
-    else if (currentChar() != '\'')
+    else if (*p != '\'' && *p != '\0')
     {
-        charLit += currentChar();
-        advance();
+        value = *p;
+        ++p;
     }
 
-    if (currentChar() == '\'')
+    cur_ = p;
+    if (*p == '\'')
     {
-        advance(); // skip closing quote
+        cur_ = p + 1; // skip closing quote
     }
     else
     {
         reportError("Unterminated character literal");
     }
 
-    Token token(TokenType::TOK_CHAR_LITERAL, charLit, loc);
-    if (!charLit.empty())
-    {
-        token.value.intValue = static_cast<unsigned char>(charLit[0]);
-    }
+    Token token(TokenType::TOK_CHAR_LITERAL, static_cast<uint32_t>(cur_ - start), loc);
+    token.value.intValue = static_cast<unsigned char>(value);
     return token;
 }
 
-// 读取运算符
-Token Lexer::readOperator()
+// 读取运算符：查运算符自动机，首字符一次转移，至多再接受一个字符
+LEXER_INLINE Token Lexer::readOperator()
 {
     SourceLocation loc = getCurrentLocation();
-    char c = currentChar();
+    const char *start = cur_;
+    const OperatorState &state = operatorTable.states[static_cast<unsigned char>(*start)];
 
-    // 双字符运算符
-    if (c == '+' && peekChar() == '+')
+    // *start 不是 '\0'，start[1] 至多是结尾的哨兵
+    char next = start[1];
+    if (next != '\0' && (next == state.next[0] || next == state.next[1]))
     {
-        advance();
-        advance();
-        return Token(TokenType::TOK_INC, "++", loc);
+        cur_ = start + 2;
+        return Token(state.pair[next == state.next[0] ? 0 : 1], 2, loc);
     }
-    if (c == '-' && peekChar() == '-')
-    {
-        advance();
-        advance();
-        return Token(TokenType::TOK_DEC, "--", loc);
-    }
-    if (c == '=' && peekChar() == '=')
-    {
-        advance();
-        advance();
-        return Token(TokenType::TOK_EQ, "==", loc);
-    }
-    if (c == '!' && peekChar() == '=')
-    {
-        advance();
-        advance();
-        return Token(TokenType::TOK_NE, "!=", loc);
-    }
-    if (c == '<' && peekChar() == '=')
-    {
-        advance();
-        advance();
-        return Token(TokenType::TOK_LE, "<=", loc);
-    }
-    if (c == '>' && peekChar() == '=')
-    {
-        advance();
-        advance();
-        return Token(TokenType::TOK_GE, ">=", loc);
-    }
-    if (c == '<' && peekChar() == '<')
-    {
-        advance();
-        advance();
-        return Token(TokenType::TOK_SHL, "<<", loc);
-    }
-    if (c == '>' && peekChar() == '>')
-    {
-        advance();
-        advance();
-        return Token(TokenType::TOK_SHR, ">>", loc);
-    }
-    if (c == '&' && peekChar() == '&')
+
+    cur_ = start + 1;
+    if (state.single == TokenType::TOK_ERROR)
     {
-        advance();
-        advance();
-        return Token(TokenType::TOK_LAND, "&&", loc);
+        reportError("Unknown character: " + std::string(1, *start));
     }
-    if (c == '|' && peekChar() == '|')
+    return Token(state.single, 1, loc);
+}
+
+// 从 cur_ 处切分出一个 token（调用前已跳过空白与注释）
+LEXER_INLINE Token Lexer::scanToken()
+{
+    switch (charTables.start[static_cast<unsigned char>(*cur_)])
     {
-        advance();
-        advance();
-        return Token(TokenType::TOK_LOR, "||", loc);
+    case TokenStart::Identifier:
+        return readIdentifierOrKeyword();
+    case TokenStart::Number:
+        return readNumber();
+    case TokenStart::String:
+        return readString();
+    case TokenStart::Char:
+        return readCharLiteral();
+    case TokenStart::Operator:
+        return readOperator();
+    case TokenStart::End:
+        break;
     }
 
-    // 单字符运算符和分隔符
-    advance();
-    switch (c)
-    {
-    case '+':
-        return Token(TokenType::TOK_PLUS, "+", loc);
-    case '-':
-        return Token(TokenType::TOK_MINUS, "-", loc);
-    case '*':
-        return Token(TokenType::TOK_STAR, "*", loc);
-    case '/':
-        return Token(TokenType::TOK_SLASH, "/", loc);
-    case '%':
-        return Token(TokenType::TOK_PERCENT, "%", loc);
-    case '=':
-        return Token(TokenType::TOK_ASSIGN, "=", loc);
-    case '<':
-        return Token(TokenType::TOK_LT, "<", loc);
-    case '>':
-        return Token(TokenType::TOK_GT, ">", loc);
-    case '&':
-        return Token(TokenType::TOK_AND, "&", loc);
-    case '|':
-        return Token(TokenType::TOK_OR, "|", loc);
-    case '^':
-        return Token(TokenType::TOK_XOR, "^", loc);
-    case '!':
-        return Token(TokenType::TOK_NOT, "!", loc);
-    case '~':
-        return Token(TokenType::TOK_TILDE, "~", loc);
-    case '(':
-        return Token(TokenType::TOK_LPAREN, "(", loc);
-    case ')':
-        return Token(TokenType::TOK_RPAREN, ")", loc);
-    case '{':
-        return Token(TokenType::TOK_LBRACE, "{", loc);
-    case '}':
-        return Token(TokenType::TOK_RBRACE, "}", loc);
-    case '[':
-        return Token(TokenType::TOK_LBRACKET, "[", loc);
-    case ']':
-        return Token(TokenType::TOK_RBRACKET, "]", loc);
-    case ';':
-        return Token(TokenType::TOK_SEMICOLON, ";", loc);
-    case ',':
-        return Token(TokenType::TOK_COMMA, ",", loc);
-    case '.':
-        return Token(TokenType::TOK_DOT, ".", loc);
-    case ':':
-        return Token(TokenType::TOK_COLON, ":", loc);
-    case '?':
-        return Token(TokenType::TOK_QUESTION, "?", loc);
-    default:
-        reportError("Unknown character: " + std::string(1, c));
-        return Token(TokenType::TOK_ERROR, std::string(1, c), loc);
-    }
+    // 文件结束（或源码中的 '\0'）
+    return Token(TokenType::TOK_EOF, 0, getCurrentLocation());
+}
+
+// 切分出下一个 token
+LEXER_INLINE Token Lexer::lexToken()
+{
+    skipWhitespaceAndComments();
+    return scanToken();
 }
 
 // 获取下一个 token
 Token Lexer::nextToken()
 {
-    // 跳过空白和注释
-    while (true)
+    if (hasPeeked_)
     {
-        skipWhitespace();
-        if (currentChar() == '/' && (peekChar() == '/' || peekChar() == '*'))
-        {
-            skipComment();
-        }
-        else
-        {
-            break;
-        }
+        hasPeeked_ = false;
+        return peeked_;
     }
+    return lexToken();
+}
 
-    SourceLocation loc = getCurrentLocation();
-    char c = currentChar();
-
-    // 文件结束
-    if (c == '\0')
+// 查看下一个 token：读出后缓存，下一次 nextToken 直接返回它（错误只报告一次）
+Token Lexer::peekToken()
+{
+    if (!hasPeeked_)
     {
-        return Token(TokenType::TOK_EOF, "", loc);
+        peeked_ = lexToken();
+        hasPeeked_ = true;
     }
+    return peeked_;
+}
 
-    // 标识符或关键字
-    if (isAlpha(c))
-    {
-        return readIdentifierOrKeyword();
-    }
+TokenBuffer Lexer::tokenize()
+{
+    TokenBuffer tokens(source_, fileId_);
+    // 典型源码平均每个 token 约 3~4 个字节，按此预留以避免反复扩容
+    tokens.reserve((source_.size() - (cur_ - source_.data())) / 4 + 1);
 
-    // 数字
-    if (isDigit(c))
+    Token token = hasPeeked_ ? peeked_ : lexToken();
+    hasPeeked_ = false;
+    tokens.push(token);
+    while (token.type != TokenType::TOK_EOF)
     {
-        return readNumber();
+        token = lexToken();
+        tokens.push(token);
     }
+    return tokens;
+}
 
-    // 字符串字面量
-    if (c == '"')
+// 切分起点不早于 end 之前的 token，不追加 TOK_EOF
+// end 必须是 tokenizeParallel 找到的切分点或文件结尾：跨越 end 的只可能是空白与注释，不会是 token
+void Lexer::tokenizeUntil(const char *end, TokenBuffer &tokens)
+{
+    while (true)
     {
-        return readString();
+        skipWhitespaceAndComments();
+        if (cur_ >= end)
+            break;
+        tokens.push(scanToken());
     }
+}
 
-    // 字符字面量
-    if (c == '\'')
-    {
-        return readCharLiteral();
-    }
+/* -------------------------------------------------------------------------- */
+/*                                Token Buffer                                */
+/* -------------------------------------------------------------------------- */
 
-    // 运算符和分隔符
-    return readOperator();
+void TokenBuffer::reserve(size_t count)
+{
+    kinds_.reserve(count);
+    offsets_.reserve(count);
+    lengths_.reserve(count);
+    payloads_.reserve(count);
+}
+
+void TokenBuffer::push(const Token &token)
+{
+    Payload payload;
+    if (token.type == TokenType::TOK_IDENTIFIER)
+        payload.identifier = &token.identifier.str();
+    else
+        payload.intValue = token.value.intValue;
+
+    kinds_.push_back(token.type);
+    offsets_.push_back(token.location.offset);
+    lengths_.push_back(token.length);
+    payloads_.push_back(payload);
+}
+
+Token TokenBuffer::get(size_t i) const
+{
+    Token token(kind(i), length(i), location(i));
+    if (token.type == TokenType::TOK_IDENTIFIER)
+        token.identifier = identifier(i);
+    else
+        token.value.intValue = intValue(i);
+    return token;
 }
 
 // 错误报告
 void Lexer::reportError(const std::string &message)
+{
+    reportError(getCurrentLocation(), message);
+}
+
+void Lexer::reportError(SourceLocation location, const std::string &message)
 {
     hasErrors_ = true;
-    std::string errorMsg = filename_ + ":" + std::to_string(line_) + ":" +
-                           std::to_string(column_) + ": error: " + message;
+    if (deferErrors_)
+    {
+        deferredErrors_.emplace_back(location, message);
+        return;
+    }
+
+    PresumedLocation loc = resolveLocation(location);
+    std::string errorMsg = filename_ + ":" + std::to_string(loc.line) + ":" +
+                           std::to_string(loc.column) + ": error: " + message;
     errorMessages_.push_back(errorMsg);
     std::cerr << errorMsg << std::endl;
 }
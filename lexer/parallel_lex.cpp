@@ -0,0 +1,232 @@
+#include "lexer.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstring>
+#include <thread>
+#include <unordered_map>
+
+/* -------------------------------------------------------------------------- */
+/*                                Split Points                                */
+/* -------------------------------------------------------------------------- */
+
+namespace
+{
+    constexpr size_t MIN_PARALLEL_BYTES = 1 << 20; // 更小的源码串行切分
+    constexpr size_t MIN_CHUNK_BYTES = 128 << 10;
+    constexpr size_t CHUNKS_PER_THREAD = 4;
+
+    // 跳过字符串字面量，规则与 Lexer::readString 相同（字面量可以跨行）
+    const char *skipString(const char *p)
+    {
+        for (++p; *p != '"' && *p != '\0'; ++p)
+        {
+            if (*p == '\\' && p[1] != '\0')
+                ++p;
+        }
+        return *p == '"' ? p + 1 : p;
+    }
+
+    // 跳过字符字面量，规则与 Lexer::readCharLiteral 相同（未闭合时停在第一个字符之后）
+    const char *skipCharLiteral(const char *p)
+    {
+        ++p;
+        if (*p == '\\')
+        {
+            ++p;
+            if (*p != '\0')
+                ++p;
+        }
+        else if (*p != '\'' && *p != '\0')
+        {
+            ++p;
+        }
+        return *p == '\'' ? p + 1 : p;
+    }
+
+    /*
+     * 按词法分析器的规则顺序扫描一遍，只跟踪 字符串 / 字符字面量 / 注释 三种状态，
+     * 在每个目标位置之后取第一个位于它们之外的换行，切分点为换行的下一个字节。
+     * 切分点处于 token 之间，跨越它的只可能是空白与注释，因此各块可以独立切分。
+     * 字面量与注释之外由 findLiteralStart 整块跳到下一个 '"' '\'' '/'，越过目标位置后
+     * 再用 memchr 在跳过的区间中找换行，预扫描不逐字节检查源码。
+     * 返回严格递增的切分点，首尾分别为 begin 与 end。
+     */
+    std::vector<const char *> findSplitPoints(const char *begin, const char *end, size_t numChunks,
+                                              const ScanKernels &scan)
+    {
+        size_t size = end - begin;
+        std::vector<const char *> splits{begin};
+        size_t next = 1;
+        const char *target = begin + size / numChunks;
+
+        const char *p = begin;
+        while (next < numChunks)
+        {
+            const char *stop = scan.findLiteralStart(p);
+
+            // [p, stop) 位于字面量与注释之外，其中位于 target - 1 及之后的第一个换行给出切分点
+            const char *from = std::max(p, target - 1);
+            const char *newline = from < stop ? static_cast<const char *>(std::memchr(from, '\n', stop - from)) : nullptr;
+            if (newline)
+            {
+                p = newline + 1;
+                if (p >= end)
+                    break;
+                splits.push_back(p);
+                // 一个很长的字面量或注释可能越过多个目标
+                while (next < numChunks && begin + size * next / numChunks <= p)
+                    ++next;
+                target = begin + size * next / numChunks;
+                continue;
+            }
+
+            p = stop;
+            char c = *p;
+            if (c == '\0')
+                break;
+            if (c == '"')
+                p = skipString(p);
+            else if (c == '\'')
+                p = skipCharLiteral(p);
+            else if (p[1] == '/') // 余下的情况 c == '/'
+                p = scan.findLineEnd(p + 2);
+            else if (p[1] == '*')
+            {
+                p = scan.findCommentEnd(p + 2);
+                if (*p != '\0')
+                    p += 2;
+            }
+            else
+                ++p;
+        }
+
+        splits.push_back(end);
+        return splits;
+    }
+
+    // 与 CodeGenerator::generateParallel 相同：线程按序号动态领取块，当前线程也参与
+    template <typename Work>
+    void runChunks(unsigned numThreads, size_t numChunks, const Work &work)
+    {
+        std::atomic<size_t> nextChunk{0};
+        auto worker = [&]()
+        {
+            for (size_t chunk; (chunk = nextChunk.fetch_add(1)) < numChunks;)
+                work(chunk);
+        };
+
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < std::min<size_t>(numThreads, numChunks); ++i)
+        {
+            threads.emplace_back(worker);
+        }
+        worker();
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/*                              Parallel Tokenize                             */
+/* -------------------------------------------------------------------------- */
+
+TokenBuffer Lexer::tokenizeParallel(unsigned numThreads)
+{
+    assert(cur_ == source_.data() && !hasPeeked_ && "tokenizeParallel must start at the beginning");
+
+    if (numThreads == 0)
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    if (numThreads <= 1 || source_.size() < MIN_PARALLEL_BYTES)
+        return tokenize();
+
+    // 源码中间的 '\0' 即文件结束
+    const char *begin = source_.data();
+    const char *end = static_cast<const char *>(std::memchr(begin, '\0', source_.size()));
+    if (!end)
+        end = begin + source_.size();
+
+    size_t numChunks = std::min<size_t>(numThreads * CHUNKS_PER_THREAD, (end - begin) / MIN_CHUNK_BYTES);
+    std::vector<const char *> splits = findSplitPoints(begin, end, std::max<size_t>(numChunks, 1), *scan_);
+    numChunks = splits.size() - 1;
+    if (numChunks < 2)
+        return tokenize();
+
+    // 每块使用独立的词法分析器与标识符表，token 的偏移本来就相对于整个文件，拼接时无需修正
+    struct ChunkResult
+    {
+        TokenBuffer tokens;
+        std::shared_ptr<IdentifierTable> identifiers;
+        std::vector<std::pair<SourceLocation, std::string>> errors;
+    };
+    std::vector<ChunkResult> results(numChunks);
+
+    auto lexChunk = [&](size_t chunk)
+    {
+        ChunkResult &result = results[chunk];
+        Lexer lexer(filename_, source_, std::make_shared<IdentifierTable>(), fileId_);
+        lexer.deferErrors_ = true;
+        lexer.cur_ = splits[chunk];
+        result.tokens = TokenBuffer(source_, fileId_);
+        result.tokens.reserve((splits[chunk + 1] - splits[chunk]) / 4 + 1);
+        lexer.tokenizeUntil(splits[chunk + 1], result.tokens);
+        result.identifiers = lexer.identifiers_;
+        result.errors = std::move(lexer.deferredErrors_);
+    };
+    runChunks(numThreads, numChunks, lexChunk);
+
+    // 按块顺序把各块的名字驻留到本表中，驻留顺序与串行切分相同
+    std::vector<std::unordered_map<const std::string *, const std::string *>> remaps(numChunks);
+    std::vector<size_t> starts(numChunks + 1, 0);
+    for (size_t chunk = 0; chunk < numChunks; ++chunk)
+    {
+        auto &remap = remaps[chunk];
+        const auto &names = results[chunk].identifiers->getNames();
+        remap.reserve(names.size());
+        for (const std::string &name : names)
+            remap.emplace(&name, &identifiers_->intern(name).str());
+        starts[chunk + 1] = starts[chunk] + results[chunk].tokens.size();
+    }
+
+    TokenBuffer tokens(source_, fileId_);
+    size_t count = starts[numChunks];
+    tokens.kinds_.resize(count + 1);
+    tokens.offsets_.resize(count + 1);
+    tokens.lengths_.resize(count + 1);
+    tokens.payloads_.resize(count + 1);
+
+    auto copyChunk = [&](size_t chunk)
+    {
+        const TokenBuffer &from = results[chunk].tokens;
+        const auto &remap = remaps[chunk];
+        size_t at = starts[chunk];
+        std::copy(from.kinds_.begin(), from.kinds_.end(), tokens.kinds_.begin() + at);
+        std::copy(from.offsets_.begin(), from.offsets_.end(), tokens.offsets_.begin() + at);
+        std::copy(from.lengths_.begin(), from.lengths_.end(), tokens.lengths_.begin() + at);
+        for (size_t i = 0; i < from.size(); ++i)
+        {
+            TokenBuffer::Payload payload = from.payloads_[i];
+            if (from.kinds_[i] == TokenType::TOK_IDENTIFIER)
+                payload.identifier = remap.find(payload.identifier)->second;
+            tokens.payloads_[at + i] = payload;
+        }
+        // 释放块的缓冲区，降低拼接期间的峰值内存
+        results[chunk].tokens = TokenBuffer();
+    };
+    runChunks(numThreads, numChunks, copyChunk);
+
+    cur_ = end;
+    tokens.kinds_[count] = TokenType::TOK_EOF;
+    tokens.offsets_[count] = static_cast<uint32_t>(end - begin);
+    tokens.lengths_[count] = 0;
+    tokens.payloads_[count].intValue = 0;
+
+    for (const ChunkResult &result : results)
+    {
+        for (const auto &[location, message] : result.errors)
+            reportError(location, message);
+    }
+    return tokens;
+}
@@ -0,0 +1,116 @@
+#include "source_manager.h"
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SOURCE_USE_MMAP 1
+#else
+#define SOURCE_USE_MMAP 0
+#endif
+
+SourceBuffer::~SourceBuffer()
+{
+#if SOURCE_USE_MMAP
+    if (mapSize_)
+        munmap(const_cast<char *>(data_), mapSize_);
+#endif
+}
+
+const SourceBuffer *SourceManager::load(const std::string &path)
+{
+    if (buffers_.size() > UINT16_MAX)
+    {
+        error_ = "Too many source files";
+        return nullptr;
+    }
+    std::unique_ptr<SourceBuffer> buffer(new SourceBuffer(path, static_cast<uint16_t>(buffers_.size())));
+
+#if SOURCE_USE_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        error_ = "Cannot open file '" + path + "': " + std::strerror(errno);
+        return nullptr;
+    }
+
+    struct stat info;
+    bool ok;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0)
+        ok = mapFile(fd, static_cast<size_t>(info.st_size), *buffer);
+    else
+        ok = readFile(path, *buffer); // 空文件、管道与设备
+    ::close(fd);
+#else
+    bool ok = readFile(path, *buffer);
+#endif
+    if (!ok)
+        return nullptr;
+
+    // token 位置以 32 位偏移记录
+    if (buffer->size_ > UINT32_MAX)
+    {
+        error_ = "File '" + path + "' is larger than 4 GiB";
+        return nullptr;
+    }
+
+    buffers_.push_back(std::move(buffer));
+    return buffers_.back().get();
+}
+
+#if SOURCE_USE_MMAP
+// 先保留整页对齐的匿名零页区域，再把文件映射到其开头：
+// 区域至少比文件多一个字节，因此无论文件长度是否恰为整页，结尾之后总有 '\0'
+bool SourceManager::mapFile(int fd, size_t size, SourceBuffer &buffer)
+{
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t mapSize = (size / page + 1) * page;
+
+    void *base = mmap(nullptr, mapSize, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED)
+    {
+        error_ = "Cannot map file '" + buffer.filename_ + "': " + std::strerror(errno);
+        return false;
+    }
+    if (mmap(base, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED)
+    {
+        error_ = "Cannot map file '" + buffer.filename_ + "': " + std::strerror(errno);
+        munmap(base, mapSize);
+        return false;
+    }
+    // 词法分析从头到尾顺序读取一遍
+    madvise(base, size, MADV_SEQUENTIAL);
+
+    buffer.data_ = static_cast<const char *>(base);
+    buffer.size_ = size;
+    buffer.mapSize_ = mapSize;
+    return true;
+}
+#else
+bool SourceManager::mapFile(int, size_t, SourceBuffer &)
+{
+    return false;
+}
+#endif
+
+bool SourceManager::readFile(const std::string &path, SourceBuffer &buffer)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        error_ = "Cannot open file '" + path + "'";
+        return false;
+    }
+
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    buffer.contents_ = contents.str();
+    buffer.data_ = buffer.contents_.c_str();
+    buffer.size_ = buffer.contents_.size();
+    return true;
+}
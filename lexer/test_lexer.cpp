@@ -1,7 +1,10 @@
 #include "lexer.h"
-#include <iostream>
+#include <chrono>
+#include <cstdio>
 #include <fstream>
+#include <iostream>
 #include <sstream>
+#include <thread>
 
 // Token 类型名称映射
 std::string getTokenTypeName(TokenType type)
@@ -16,6 +19,8 @@ std::string getTokenTypeName(TokenType type)
         return "CHAR";
     case TokenType::TOK_VOID:
         return "VOID";
+    case TokenType::TOK_CONST:
+        return "CONST";
     case TokenType::TOK_IF:
         return "IF";
     case TokenType::TOK_ELSE:
@@ -26,6 +31,10 @@ std::string getTokenTypeName(TokenType type)
         return "FOR";
     case TokenType::TOK_RETURN:
         return "RETURN";
+    case TokenType::TOK_BREAK:
+        return "BREAK";
+    case TokenType::TOK_CONTINUE:
+        return "CONTINUE";
     case TokenType::TOK_IDENTIFIER:
         return "IDENTIFIER";
     case TokenType::TOK_NUMBER:
@@ -109,7 +118,8 @@ std::string getTokenTypeName(TokenType type)
     }
 }
 
-void testLexer(const std::string &code)
+// 返回批量切分与逐个读取是否一致
+bool testLexer(std::string_view code)
 {
     std::cout << "=== Testing Lexer ===" << std::endl;
     std::cout << "Source Code:" << std::endl;
@@ -121,8 +131,9 @@ void testLexer(const std::string &code)
 
     while (token.type != TokenType::TOK_EOF)
     {
-        std::cout << "[" << token.location.line << ":" << token.location.column << "] "
-                  << getTokenTypeName(token.type) << " \t'" << token.lexeme << "'";
+        PresumedLocation loc = lexer.resolveLocation(token.location);
+        std::cout << "[" << loc.line << ":" << loc.column << "] "
+                  << getTokenTypeName(token.type) << " \t'" << lexer.getSpelling(token) << "'";
 
         if (token.type == TokenType::TOK_NUMBER)
         {
@@ -135,20 +146,278 @@ void testLexer(const std::string &code)
 
     std::cout << "\n=== End of Tokens ===" << std::endl;
 
+    // 批量切分的结果必须与逐个读取一致（数量、类型与位置）
+    auto identifiers = std::make_shared<IdentifierTable>();
+    Lexer batchLexer("test.c", code, identifiers);
+    Lexer streamLexer("test.c", code, identifiers);
+    TokenBuffer tokens = batchLexer.tokenize();
+    bool agree = true;
+    for (size_t i = 0; i < tokens.size(); i++)
+    {
+        Token expected = streamLexer.nextToken();
+        Token actual = tokens.get(i);
+        if (actual.type != expected.type || actual.length != expected.length ||
+            actual.location.offset != expected.location.offset ||
+            actual.value.intValue != expected.value.intValue || actual.identifier != expected.identifier)
+        {
+            std::cout << "Token buffer mismatch at token " << i << std::endl;
+            agree = false;
+            break;
+        }
+    }
+
     if (lexer.hasErrors())
     {
         std::cout << "\nLexer encountered errors!" << std::endl;
     }
+    return agree;
+}
+
+// 吞吐量测试：源码重复拼接到至少 minBytes，取多轮中最快的一轮
+// 校验和由 token 类型、位置与长度组成，用于确认优化前后的 token 流一致
+std::string repeatSource(std::string_view code, size_t minBytes)
+{
+    std::string source;
+    source.reserve(minBytes + code.size() + 1);
+    while (source.size() < minBytes)
+    {
+        source += code;
+        source += '\n';
+    }
+    return source;
+}
+
+int benchLexer(std::string_view code, int iterations)
+{
+    std::string source = repeatSource(code, 4 << 20);
+
+    double bestSeconds = 0;
+    size_t tokens = 0;
+    unsigned long long checksum = 0;
+    for (int i = 0; i < iterations; i++)
+    {
+        Lexer lexer("bench.c", source);
+        size_t count = 0;
+        unsigned long long sum = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        for (Token token = lexer.nextToken(); token.type != TokenType::TOK_EOF; token = lexer.nextToken())
+        {
+            count++;
+            sum = sum * 31 + static_cast<unsigned>(token.type) * 7919 + token.length +
+                  static_cast<unsigned>(token.location.offset) * 131;
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (i == 0 || seconds < bestSeconds)
+            bestSeconds = seconds;
+        tokens = count;
+        checksum = sum;
+        if (lexer.hasErrors())
+            return 1;
+    }
+
+    std::cout << "Scanner:    " << scanLevelName(getScanKernels().level) << std::endl;
+    std::cout << "Source:     " << source.size() << " bytes, " << tokens << " tokens" << std::endl;
+    std::cout << "Best time:  " << bestSeconds * 1000 << " ms (" << iterations << " iterations)" << std::endl;
+    std::cout << "Throughput: " << source.size() / bestSeconds / (1 << 20) << " MB/s, "
+              << tokens / bestSeconds / 1e6 << " M tokens/s" << std::endl;
+    std::cout << "Checksum:   " << std::hex << checksum << std::dec << std::endl;
+
+    // 多线程切分（使用全部硬件线程）
+    double parallelSeconds = 0;
+    for (int i = 0; i < iterations; i++)
+    {
+        Lexer lexer("bench.c", source);
+        auto start = std::chrono::steady_clock::now();
+        TokenBuffer buffer = lexer.tokenizeParallel();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (i == 0 || seconds < parallelSeconds)
+            parallelSeconds = seconds;
+    }
+    std::cout << "Parallel:   " << source.size() / parallelSeconds / (1 << 20) << " MB/s ("
+              << std::thread::hardware_concurrency() << " threads)" << std::endl;
+    return 0;
+}
+
+// 并行切分检查：在字面量与注释密集的大源码上，结果必须与串行切分逐个 token 相同
+int checkParallelLexer(std::string_view code)
+{
+    const std::string tricky = R"(
+// line comment with " quote and ' apostrophe
+/* block comment with // and "
+   spanning lines ' */
+char *s = "string with /* not a comment */ and // not a comment\
+ and an escaped \" quote";
+char q = '"'; char a = '\''; char n = '\n'; char slash = '/';
+char *m = "string
+spanning lines";
+int x = a / b /c;
+)";
+    // 词法错误分散在源码各处（因而落在不同的块中），延迟报告的错误文本与顺序也必须与串行相同
+    std::string source;
+    for (int part = 0; part < 5; part++)
+    {
+        source += repeatSource(tricky + std::string(code), 800 << 10);
+        source += "int err" + std::to_string(part) + " = 1 @ 2; $\n";
+    }
+
+    auto identifiers = std::make_shared<IdentifierTable>();
+    Lexer serialLexer("check.c", source, identifiers);
+    Lexer parallelLexer("check.c", source, identifiers);
+    std::ostringstream discarded;
+    std::streambuf *stderrBuffer = std::cerr.rdbuf(discarded.rdbuf());
+    TokenBuffer serial = serialLexer.tokenize();
+    TokenBuffer parallel = parallelLexer.tokenizeParallel(4);
+    std::cerr.rdbuf(stderrBuffer);
+
+    const auto &serialErrors = serialLexer.getErrors();
+    const auto &parallelErrors = parallelLexer.getErrors();
+    bool ok = serial.size() == parallel.size() && !serialErrors.empty() && serialErrors == parallelErrors;
+    for (size_t i = 0; i < std::min(serialErrors.size(), parallelErrors.size()); i++)
+    {
+        if (serialErrors[i] != parallelErrors[i])
+        {
+            std::cout << "Error mismatch: \"" << serialErrors[i] << "\" vs \"" << parallelErrors[i] << "\"" << std::endl;
+            break;
+        }
+    }
+    std::cout << "Errors: " << serialErrors.size() << " serial, " << parallelErrors.size() << " parallel" << std::endl;
+    for (size_t i = 0; ok && i < serial.size(); i++)
+    {
+        Token expected = serial.get(i);
+        Token actual = parallel.get(i);
+        if (actual.type != expected.type || actual.location.offset != expected.location.offset ||
+            actual.length != expected.length || actual.value.intValue != expected.value.intValue ||
+            actual.identifier != expected.identifier)
+        {
+            std::cout << "Token mismatch at token " << i << std::endl;
+            ok = false;
+        }
+    }
+    std::cout << "Tokens: " << serial.size() << " serial, " << parallel.size() << " parallel" << std::endl;
+    std::cout << (ok ? "Parallel tokens match" : "Parallel tokens differ") << std::endl;
+    return ok ? 0 : 1;
+}
+
+// 扫描内核一致性检查：各级别内核在每个起始偏移上的结果都必须与标量实现相同
+int checkScanKernels()
+{
+    const std::string samples[] = {
+        "    \t  \v\f\r \n \t                                          x",
+        "a line comment that runs past a couple of vector blocks ........ \n next",
+        "block comment\n with * stars ** and / slashes\n spanning blocks ...... **/ tail",
+        "unterminated block comment\n * without an end ..............................",
+        "long_identifier_Name_0123456789_with_MIXED_case_and_more_letters+1",
+        "\x80\xff high bytes \xc3\xa9 are never blanks or identifier characters",
+        "code without literals for a few vector blocks ................. x = a / b; s = \"s\"; c = 'c';",
+    };
+
+    const ScanKernels &scalar = *getScanKernels(ScanLevel::Scalar);
+    const ScanLevel levels[] = {ScanLevel::SSE2, ScanLevel::AVX2};
+    int failures = 0;
+    for (ScanLevel level : levels)
+    {
+        const ScanKernels *kernels = getScanKernels(level);
+        if (!kernels)
+        {
+            std::cout << scanLevelName(level) << ": not available" << std::endl;
+            continue;
+        }
+        for (const std::string &sample : samples)
+        {
+            for (size_t offset = 0; offset < sample.size(); ++offset)
+            {
+                const char *p = sample.c_str() + offset;
+                bool ok = kernels->skipBlanks(p) == scalar.skipBlanks(p) &&
+                          kernels->findLineEnd(p) == scalar.findLineEnd(p) &&
+                          kernels->skipIdentifier(p) == scalar.skipIdentifier(p) &&
+                          kernels->findCommentEnd(p) == scalar.findCommentEnd(p) &&
+                          kernels->findLiteralStart(p) == scalar.findLiteralStart(p);
+                if (!ok)
+                {
+                    std::cout << scanLevelName(level) << ": mismatch at offset " << offset << " of \""
+                              << sample.substr(0, 20) << "...\"" << std::endl;
+                    failures++;
+                }
+            }
+        }
+        std::cout << scanLevelName(level) << ": checked" << std::endl;
+    }
+    std::cout << (failures ? "Scan kernels differ" : "Scan kernels agree") << std::endl;
+    return failures ? 1 : 0;
+}
+
+// 映射源文件检查：长度恰为整页（最容易缺少哨兵的情况）的文件结尾之后也必须是 '\0'
+int checkMappedSource(const std::string &path)
+{
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << std::string(4095, ' ') << 'x';
+    }
+
+    SourceManager sources;
+    const SourceBuffer *buffer = sources.load(path);
+    std::remove(path.c_str());
+    if (!buffer)
+    {
+        std::cerr << "Error: " << sources.getError() << std::endl;
+        return 1;
+    }
+
+    std::string_view text = buffer->text();
+    Lexer lexer(*buffer);
+    Token first = lexer.nextToken();
+    Token second = lexer.nextToken();
+    bool ok = text.size() == 4096 && text.data()[text.size()] == '\0' && lexer.getSpelling(first) == "x" &&
+              second.type == TokenType::TOK_EOF && !lexer.hasErrors();
+    std::cout << "Mapped: " << (buffer->isMapped() ? "yes" : "no") << std::endl;
+    std::cout << (ok ? "Mapped source OK" : "Mapped source broken") << std::endl;
+    return ok ? 0 : 1;
 }
 
 int main(int argc, char **argv)
 {
+    if (argc > 1 && std::string(argv[1]) == "--check-scan")
+        return checkScanKernels();
+    if (argc > 2 && std::string(argv[1]) == "--check-mmap")
+        return checkMappedSource(argv[2]);
+
+    // --check-parallel <file>：比较并行与串行切分的结果
+    if (argc > 2 && std::string(argv[1]) == "--check-parallel")
+    {
+        SourceManager sources;
+        const SourceBuffer *buffer = sources.load(argv[2]);
+        if (!buffer)
+        {
+            std::cerr << "Error: " << sources.getError() << std::endl;
+            return 1;
+        }
+        return checkParallelLexer(buffer->text());
+    }
+
+    // --bench <file> [iterations]：只测量词法分析吞吐量
+    if (argc > 2 && std::string(argv[1]) == "--bench")
+    {
+        SourceManager sources;
+        const SourceBuffer *buffer = sources.load(argv[2]);
+        if (!buffer)
+        {
+            std::cerr << "Error: " << sources.getError() << std::endl;
+            return 1;
+        }
+        return benchLexer(buffer->text(), argc > 3 ? std::stoi(argv[3]) : 10);
+    }
+
+    // 批量切分与逐个读取不一致的用例数
+    int failures = 0;
+
     // 测试用例 1: 简单的变量声明和赋值
     std::string test1 = R"(
 int x = 42;
 char c = 'a';
 )";
-    testLexer(test1);
+    failures += !testLexer(test1);
 
     std::cout << "\n\n";
 
@@ -158,7 +427,7 @@ int add(int a, int b) {
     return a + b;
 }
 )";
-    testLexer(test2);
+    failures += !testLexer(test2);
 
     std::cout << "\n\n";
 
@@ -170,7 +439,7 @@ if (x > 0) {
     y = -x;
 }
 )";
-    testLexer(test3);
+    failures += !testLexer(test3);
 
     std::cout << "\n\n";
 
@@ -181,7 +450,7 @@ flag = (x == y) && (a != b) || (c < d);
 result = x++ + --y;
 value = array[index];
 )";
-    testLexer(test4);
+    failures += !testLexer(test4);
 
     std::cout << "\n\n";
 
@@ -190,7 +459,7 @@ value = array[index];
 char* str = "Hello, World!\n";
 char newline = '\n';
 )";
-    testLexer(test5);
+    failures += !testLexer(test5);
 
     std::cout << "\n\n";
 
@@ -200,7 +469,16 @@ int dec = 123;
 int hex = 0xFF;
 int oct = 0755;
 )";
-    testLexer(test6);
+    failures += !testLexer(test6);
+
+    std::cout << "\n\n";
+
+    // 测试用例 7: 关键字与相近的标识符
+    std::string test7 = R"(
+while (1) { if (x) break; else continue; }
+const int breaks = returned + fort + constant + in + voids;
+)";
+    failures += !testLexer(test7);
 
     std::cout << "\n\n";
 
@@ -208,22 +486,17 @@ int oct = 0755;
     if (argc > 1)
     {
         std::string filename = argv[1];
-        std::ifstream file(filename);
-
-        if (!file.is_open())
+        SourceManager sources;
+        const SourceBuffer *buffer = sources.load(filename);
+        if (!buffer)
         {
-            std::cerr << "Error: Cannot open file " << filename << std::endl;
+            std::cerr << "Error: " << sources.getError() << std::endl;
             return 1;
         }
 
-        std::stringstream buffer;
-        buffer << file.rdbuf();
-        std::string code = buffer.str();
-        file.close();
-
         std::cout << "=== Analyzing file: " << filename << " ===" << std::endl;
-        testLexer(code);
+        failures += !testLexer(buffer->text());
     }
 
-    return 0;
+    return failures ? 1 : 0;
 }
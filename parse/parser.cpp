@@ -1,16 +1,21 @@
 #include "parser.h"
+#include <cassert>
 #include <sstream>
 
 /* ========================================================================== */
 /*                          Constructor & Entry Point                         */
 /* ========================================================================== */
 
-Parser::Parser(Lexer &lexer)
+Parser::Parser(Lexer &lexer, const TokenBuffer *tokens)
     : lexer_(lexer),
-      current_(TokenType::TOK_EOF, "", SourceLocation()),
+      tokens_(tokens),
+      index_(0),
+      context_(nullptr),
+      current_(TokenType::TOK_EOF, 0, SourceLocation()),
       hasErrors_(false)
 {
-    advance(); // 读取第一个token
+    if (!tokens_)
+        advance(); // 读取第一个token
 }
 
 std::unique_ptr<CompUnit> Parser::parse()
@@ -24,7 +29,31 @@ std::unique_ptr<CompUnit> Parser::parse()
 
 void Parser::advance()
 {
-    current_ = lexer_.nextToken();
+    if (tokens_)
+    {
+        ++index_;
+    }
+    else if (!lookahead_.empty())
+    {
+        current_ = lookahead_.front();
+        lookahead_.pop_front();
+    }
+    else
+    {
+        current_ = lexer_.nextToken();
+    }
+}
+
+TokenType Parser::peek(size_t n) const
+{
+    if (tokens_)
+        return tokens_->kind(index_ + n);
+    if (n == 0)
+        return current_.type;
+
+    while (lookahead_.size() < n)
+        lookahead_.push_back(lexer_.nextToken());
+    return lookahead_[n - 1].type;
 }
 
 bool Parser::match(TokenType type)
@@ -37,21 +66,24 @@ bool Parser::match(TokenType type)
     return false;
 }
 
-bool Parser::check(TokenType type) const
+bool Parser::consume(TokenType type, const std::string &errorMsg)
 {
-    return current_.type == type;
+    if (match(type))
+        return true;
+    error(errorMsg);
+    return false;
 }
 
-Token Parser::consume(TokenType type, const std::string &errorMsg)
+Identifier Parser::consumeIdentifier(const std::string &errorMsg)
 {
-    if (check(type))
+    if (check(TokenType::TOK_IDENTIFIER))
     {
-        Token tok = current_;
+        Identifier name = identifier();
         advance();
-        return tok;
+        return name;
     }
     error(errorMsg);
-    return current_;
+    return Identifier();
 }
 
 void Parser::synchronize()
@@ -60,13 +92,13 @@ void Parser::synchronize()
     while (!check(TokenType::TOK_EOF))
     {
         // 在语句或声明的开始处停止
-        if (current_.type == TokenType::TOK_SEMICOLON)
+        if (check(TokenType::TOK_SEMICOLON))
         {
             advance();
             return;
         }
 
-        switch (current_.type)
+        switch (kind())
         {
         case TokenType::TOK_INT:
         case TokenType::TOK_CHAR:
@@ -75,6 +107,8 @@ void Parser::synchronize()
         case TokenType::TOK_WHILE:
         case TokenType::TOK_FOR:
         case TokenType::TOK_RETURN:
+        case TokenType::TOK_BREAK:
+        case TokenType::TOK_CONTINUE:
             return;
         default:
             advance();
@@ -89,9 +123,10 @@ void Parser::synchronize()
 void Parser::error(const std::string &message)
 {
     hasErrors_ = true;
+    PresumedLocation loc = lexer_.resolveLocation(location());
     std::ostringstream oss;
-    oss << "Error at line " << current_.location.line
-        << ", column " << current_.location.column
+    oss << "Error at line " << loc.line
+        << ", column " << loc.column
         << ": " << message;
     errors_.push_back(oss.str());
 }
@@ -103,7 +138,11 @@ void Parser::error(const std::string &message)
 // CompUnit ::= { Decl | FuncDef } EOF
 std::unique_ptr<CompUnit> Parser::parseCompUnit()
 {
-    auto compUnit = std::make_unique<CompUnit>();
+    // 节点都分配在 CompUnit 持有的 ASTContext 中
+    auto compUnit = std::make_unique<CompUnit>(std::make_unique<ASTContext>());
+    context_ = &compUnit->getContext();
+    // AST 中的 Identifier 指向词法分析器的驻留表，由上下文共同持有
+    context_->setIdentifierTable(lexer_.getIdentifierTable());
 
     while (!check(TokenType::TOK_EOF))
     {
@@ -117,21 +156,21 @@ std::unique_ptr<CompUnit> Parser::parseCompUnit()
         // 向前看判断是 Decl 还是 FuncDef
         // 需要看 TypeSpec IDENT 后面是 "(" 还是其他
         TypeSpec type = parseTypeSpec();
-        Token name = consume(TokenType::TOK_IDENTIFIER, "Expected identifier");
+        Identifier name = consumeIdentifier("Expected identifier");
 
         if (check(TokenType::TOK_LPAREN))
         {
             // FuncDef ::= TypeSpec IDENT "(" [ FuncParams ] ")" Block
-            auto funcDef = parseFuncDef(type, name.lexeme);
+            auto funcDef = parseFuncDef(type, name);
             if (funcDef)
-                compUnit->addUnit(std::move(funcDef));
+                compUnit->addUnit(funcDef);
         }
         else
         {
             // Decl ::= TypeSpec InitDeclList ";"
-            auto decl = parseDecl(type, name.lexeme);
+            auto decl = parseDecl(type, name);
             if (decl)
-                compUnit->addUnit(std::move(decl));
+                compUnit->addUnit(decl);
         }
     }
 
@@ -165,10 +204,10 @@ TypeSpec Parser::parseTypeSpec()
 }
 
 // InitDecl ::= IDENT ArraySuffix? ( "=" InitVal )?
-std::unique_ptr<VarDef> Parser::parseVarDef()
+VarDef *Parser::parseVarDef()
 {
-    Token name = consume(TokenType::TOK_IDENTIFIER, "Expected identifier");
-    auto varDef = std::make_unique<VarDef>(name.lexeme);
+    Identifier name = consumeIdentifier("Expected identifier");
+    auto varDef = context_->create<VarDef>(name);
 
     // ArraySuffix ::= "[" ConstExp? "]" { "[" ConstExp? "]" }
     while (match(TokenType::TOK_LBRACKET))
@@ -176,7 +215,7 @@ std::unique_ptr<VarDef> Parser::parseVarDef()
         if (!check(TokenType::TOK_RBRACKET))
         {
             auto dim = parseConstExpr();
-            varDef->addDim(std::move(dim));
+            varDef->addDim(*context_, dim);
         }
         consume(TokenType::TOK_RBRACKET, "Expected ']'");
     }
@@ -185,27 +224,27 @@ std::unique_ptr<VarDef> Parser::parseVarDef()
     if (match(TokenType::TOK_ASSIGN))
     {
         auto initVal = parseInitVal();
-        varDef->setInit(std::move(initVal));
+        varDef->setInit(initVal);
     }
 
     return varDef;
 }
 
 // InitVal ::= Exp | "{" [ InitVal { "," InitVal } ] "}"
-std::unique_ptr<Expr> Parser::parseInitVal()
+Expr *Parser::parseInitVal()
 {
     if (match(TokenType::TOK_LBRACE))
     {
         // 初始化列表
-        auto initList = std::make_unique<InitListExpr>();
+        auto initList = context_->create<InitListExpr>();
 
         if (!check(TokenType::TOK_RBRACE))
         {
-            initList->addItem(parseInitVal());
+            initList->addItem(*context_, parseInitVal());
 
             while (match(TokenType::TOK_COMMA))
             {
-                initList->addItem(parseInitVal());
+                initList->addItem(*context_, parseInitVal());
             }
         }
 
@@ -222,13 +261,13 @@ std::unique_ptr<Expr> Parser::parseInitVal()
 // Decl ::= TypeSpec InitDeclList ";"
 // InitDeclList ::= InitDecl { "," InitDecl }
 // type 和第一个 name 已经在 parseCompUnit 中被解析
-std::unique_ptr<Decl> Parser::parseDecl(TypeSpec type, const std::string &firstName)
+Decl *Parser::parseDecl(TypeSpec type, Identifier firstName)
 {
-    auto decl = std::make_unique<VarDecl>(type);
+    auto decl = context_->create<VarDecl>(type);
 
     // 解析第一个 InitDecl (IDENT 已经被解析为 firstName)
     // InitDecl ::= IDENT ArraySuffix? ( "=" InitVal )?
-    auto varDef = std::make_unique<VarDef>(firstName);
+    auto varDef = context_->create<VarDef>(firstName);
 
     // ArraySuffix ::= "[" ConstExp? "]" { "[" ConstExp? "]" }
     while (match(TokenType::TOK_LBRACKET))
@@ -236,7 +275,7 @@ std::unique_ptr<Decl> Parser::parseDecl(TypeSpec type, const std::string &firstN
         if (!check(TokenType::TOK_RBRACKET))
         {
             auto dim = parseConstExpr();
-            varDef->addDim(std::move(dim));
+            varDef->addDim(*context_, dim);
         }
         consume(TokenType::TOK_RBRACKET, "Expected ']'");
     }
@@ -245,17 +284,17 @@ std::unique_ptr<Decl> Parser::parseDecl(TypeSpec type, const std::string &firstN
     if (match(TokenType::TOK_ASSIGN))
     {
         auto initVal = parseInitVal();
-        varDef->setInit(std::move(initVal));
+        varDef->setInit(initVal);
     }
 
-    decl->addVar(std::move(varDef));
+    decl->addVar(*context_, varDef);
 
     // { "," InitDecl }
     while (match(TokenType::TOK_COMMA))
     {
         // 现在解析完整的 InitDecl，包括 IDENT
         varDef = parseVarDef();
-        decl->addVar(std::move(varDef));
+        decl->addVar(*context_, varDef);
     }
 
     consume(TokenType::TOK_SEMICOLON, "Expected ';' after declaration");
@@ -268,9 +307,9 @@ std::unique_ptr<Decl> Parser::parseDecl(TypeSpec type, const std::string &firstN
 
 // FuncDef ::= TypeSpec IDENT "(" [ FuncParams ] ")" Block
 // type 和 name 已经在 parseCompUnit 中被解析
-std::unique_ptr<FuncDef> Parser::parseFuncDef(TypeSpec returnType, const std::string &name)
+FuncDef *Parser::parseFuncDef(TypeSpec returnType, Identifier name)
 {
-    auto funcDef = std::make_unique<FuncDef>(returnType, name);
+    auto funcDef = context_->create<FuncDef>(returnType, name);
 
     consume(TokenType::TOK_LPAREN, "Expected '(' after function name");
 
@@ -278,11 +317,11 @@ std::unique_ptr<FuncDef> Parser::parseFuncDef(TypeSpec returnType, const std::st
     // FuncParams ::= FuncParam { "," FuncParam }
     if (!check(TokenType::TOK_RPAREN))
     {
-        funcDef->addParam(parseFuncParam());
+        funcDef->addParam(*context_, parseFuncParam());
 
         while (match(TokenType::TOK_COMMA))
         {
-            funcDef->addParam(parseFuncParam());
+            funcDef->addParam(*context_, parseFuncParam());
         }
     }
 
@@ -295,19 +334,19 @@ std::unique_ptr<FuncDef> Parser::parseFuncDef(TypeSpec returnType, const std::st
         return nullptr;
     }
     auto body = parseBlock();
-    funcDef->setBody(std::move(body));
+    funcDef->setBody(body);
 
     return funcDef;
 }
 
 // FuncParam ::= TypeSpec IDENT FuncParamArray?
 // FuncParamArray ::= "[" "]" { "[" ConstExp? "]" }
-std::unique_ptr<FuncParam> Parser::parseFuncParam()
+FuncParam *Parser::parseFuncParam()
 {
     TypeSpec type = parseTypeSpec();
-    Token name = consume(TokenType::TOK_IDENTIFIER, "Expected parameter name");
+    Identifier name = consumeIdentifier("Expected parameter name");
 
-    auto param = std::make_unique<FuncParam>(type, name.lexeme);
+    auto param = context_->create<FuncParam>(type, name);
 
     // FuncParamArray?
     if (match(TokenType::TOK_LBRACKET))
@@ -321,7 +360,7 @@ std::unique_ptr<FuncParam> Parser::parseFuncParam()
             if (!check(TokenType::TOK_RBRACKET))
             {
                 auto dim = parseConstExpr();
-                param->addDim(std::move(dim));
+                param->addDim(*context_, dim);
             }
             consume(TokenType::TOK_RBRACKET, "Expected ']'");
         }
@@ -336,11 +375,11 @@ std::unique_ptr<FuncParam> Parser::parseFuncParam()
 
 // Block ::= "{" { BlockItem } "}"
 // BlockItem ::= Decl | Stmt
-std::unique_ptr<BlockStmt> Parser::parseBlock()
+BlockStmt *Parser::parseBlock()
 {
     consume(TokenType::TOK_LBRACE, "Expected '{'");
 
-    auto block = std::make_unique<BlockStmt>();
+    auto block = context_->create<BlockStmt>();
 
     while (!check(TokenType::TOK_RBRACE) && !check(TokenType::TOK_EOF))
     {
@@ -349,18 +388,18 @@ std::unique_ptr<BlockStmt> Parser::parseBlock()
         {
             // Decl ::= TypeSpec InitDeclList ";"
             TypeSpec type = parseTypeSpec();
-            Token name = consume(TokenType::TOK_IDENTIFIER, "Expected identifier");
+            Identifier name = consumeIdentifier("Expected identifier");
 
-            auto decl = parseDecl(type, name.lexeme);
+            auto decl = parseDecl(type, name);
             if (decl)
-                block->addItem(std::move(decl));
+                block->addItem(*context_, decl);
         }
         else
         {
             // Stmt
             auto stmt = parseStmt();
             if (stmt)
-                block->addItem(std::move(stmt));
+                block->addItem(*context_, stmt);
         }
     }
 
@@ -377,7 +416,7 @@ std::unique_ptr<BlockStmt> Parser::parseBlock()
 //        | "return" [Exp] ";"
 //        | "break" ";"
 //        | "continue" ";"
-std::unique_ptr<Stmt> Parser::parseStmt()
+Stmt *Parser::parseStmt()
 {
     // Block
     if (check(TokenType::TOK_LBRACE))
@@ -410,13 +449,13 @@ std::unique_ptr<Stmt> Parser::parseStmt()
     }
 
     // break
-    if (check(TokenType::TOK_IDENTIFIER) && current_.lexeme == "break")
+    if (check(TokenType::TOK_BREAK))
     {
         return parseBreakStmt();
     }
 
     // continue
-    if (check(TokenType::TOK_IDENTIFIER) && current_.lexeme == "continue")
+    if (check(TokenType::TOK_CONTINUE))
     {
         return parseContinueStmt();
     }
@@ -425,7 +464,7 @@ std::unique_ptr<Stmt> Parser::parseStmt()
     if (check(TokenType::TOK_SEMICOLON))
     {
         advance();
-        return std::make_unique<ExprStmt>(nullptr);
+        return context_->create<ExprStmt>(nullptr);
     }
 
     // LVal "=" Exp ";" 或 [Exp] ";"
@@ -442,7 +481,7 @@ std::unique_ptr<Stmt> Parser::parseStmt()
     {
         // 这是赋值语句：LVal "=" Exp ";"
         // 验证左边是 LVal
-        auto lval = dynamic_cast<LValExpr *>(expr.get());
+        auto lval = dyn_cast_or_null<LValExpr>(expr);
         if (!lval)
         {
             error("Left side of assignment must be an lvalue");
@@ -450,26 +489,22 @@ std::unique_ptr<Stmt> Parser::parseStmt()
             return nullptr;
         }
 
-        // 转移所有权
-        expr.release();
-        std::unique_ptr<LValExpr> lvalPtr(lval);
-
         advance(); // consume "="
         auto rhs = parseExpr();
         consume(TokenType::TOK_SEMICOLON, "Expected ';' after assignment");
 
-        return std::make_unique<AssignStmt>(std::move(lvalPtr), std::move(rhs));
+        return context_->create<AssignStmt>(lval, rhs);
     }
     else
     {
         // 表达式语句：[Exp] ";"
         consume(TokenType::TOK_SEMICOLON, "Expected ';' after expression");
-        return std::make_unique<ExprStmt>(std::move(expr));
+        return context_->create<ExprStmt>(expr);
     }
 }
 
 // "if" "(" Exp ")" Stmt [ "else" Stmt ]
-std::unique_ptr<Stmt> Parser::parseIfStmt()
+Stmt *Parser::parseIfStmt()
 {
     consume(TokenType::TOK_IF, "Expected 'if'");
     consume(TokenType::TOK_LPAREN, "Expected '(' after 'if'");
@@ -480,17 +515,17 @@ std::unique_ptr<Stmt> Parser::parseIfStmt()
 
     auto thenStmt = parseStmt();
 
-    std::unique_ptr<Stmt> elseStmt = nullptr;
+    Stmt *elseStmt = nullptr;
     if (match(TokenType::TOK_ELSE))
     {
         elseStmt = parseStmt();
     }
 
-    return std::make_unique<IfStmt>(std::move(cond), std::move(thenStmt), std::move(elseStmt));
+    return context_->create<IfStmt>(cond, thenStmt, elseStmt);
 }
 
 // "while" "(" Exp ")" Stmt
-std::unique_ptr<Stmt> Parser::parseWhileStmt()
+Stmt *Parser::parseWhileStmt()
 {
     consume(TokenType::TOK_WHILE, "Expected 'while'");
     consume(TokenType::TOK_LPAREN, "Expected '(' after 'while'");
@@ -501,20 +536,20 @@ std::unique_ptr<Stmt> Parser::parseWhileStmt()
 
     auto body = parseStmt();
 
-    return std::make_unique<WhileStmt>(std::move(cond), std::move(body));
+    return context_->create<WhileStmt>(cond, body);
 }
 
 // "for" "(" ForInit? ";" ForCond? ";" ForLoop? ")" Stmt
 // ForInit ::= Decl | Exp | LVal "=" Exp
 // ForCond ::= Exp
 // ForLoop ::= Exp | LVal "=" Exp
-std::unique_ptr<Stmt> Parser::parseForStmt()
+Stmt *Parser::parseForStmt()
 {
     consume(TokenType::TOK_FOR, "Expected 'for'");
     consume(TokenType::TOK_LPAREN, "Expected '(' after 'for'");
 
     // ForInit?
-    std::unique_ptr<ASTNode> init = nullptr;
+    ASTNode *init = nullptr;
     if (!check(TokenType::TOK_SEMICOLON))
     {
         // ForInit ::= Decl | Exp | LVal "=" Exp
@@ -522,8 +557,8 @@ std::unique_ptr<Stmt> Parser::parseForStmt()
         {
             // Decl
             TypeSpec type = parseTypeSpec();
-            Token name = consume(TokenType::TOK_IDENTIFIER, "Expected identifier");
-            init = parseDecl(type, name.lexeme);
+            Identifier name = consumeIdentifier("Expected identifier");
+            init = parseDecl(type, name);
             // parseDecl 已经消费了分号
         }
         else
@@ -534,7 +569,7 @@ std::unique_ptr<Stmt> Parser::parseForStmt()
             if (check(TokenType::TOK_ASSIGN))
             {
                 // LVal "=" Exp
-                auto lval = dynamic_cast<LValExpr *>(expr.get());
+                auto lval = dyn_cast_or_null<LValExpr>(expr);
                 if (!lval)
                 {
                     error("Left side of assignment must be an lvalue");
@@ -542,17 +577,14 @@ std::unique_ptr<Stmt> Parser::parseForStmt()
                     return nullptr;
                 }
 
-                expr.release();
-                std::unique_ptr<LValExpr> lvalPtr(lval);
-
                 advance(); // consume "="
                 auto rhs = parseExpr();
-                init = std::make_unique<AssignStmt>(std::move(lvalPtr), std::move(rhs));
+                init = context_->create<AssignStmt>(lval, rhs);
             }
             else
             {
                 // Exp
-                init = std::make_unique<ExprStmt>(std::move(expr));
+                init = context_->create<ExprStmt>(expr);
             }
 
             consume(TokenType::TOK_SEMICOLON, "Expected ';'");
@@ -564,7 +596,7 @@ std::unique_ptr<Stmt> Parser::parseForStmt()
     }
 
     // ForCond?
-    std::unique_ptr<Expr> cond = nullptr;
+    Expr *cond = nullptr;
     if (!check(TokenType::TOK_SEMICOLON))
     {
         cond = parseExpr();
@@ -572,7 +604,7 @@ std::unique_ptr<Stmt> Parser::parseForStmt()
     consume(TokenType::TOK_SEMICOLON, "Expected ';' after for condition");
 
     // ForLoop? ::= Exp | LVal "=" Exp
-    std::unique_ptr<ASTNode> step = nullptr;
+    ASTNode *step = nullptr;
     if (!check(TokenType::TOK_RPAREN))
     {
         auto expr = parseExpr();
@@ -580,7 +612,7 @@ std::unique_ptr<Stmt> Parser::parseForStmt()
         if (check(TokenType::TOK_ASSIGN))
         {
             // LVal "=" Exp
-            auto lval = dynamic_cast<LValExpr *>(expr.get());
+            auto lval = dyn_cast_or_null<LValExpr>(expr);
             if (!lval)
             {
                 error("Left side of assignment must be an lvalue");
@@ -588,17 +620,14 @@ std::unique_ptr<Stmt> Parser::parseForStmt()
                 return nullptr;
             }
 
-            expr.release();
-            std::unique_ptr<LValExpr> lvalPtr(lval);
-
             advance(); // consume "="
             auto rhs = parseExpr();
-            step = std::make_unique<AssignStmt>(std::move(lvalPtr), std::move(rhs));
+            step = context_->create<AssignStmt>(lval, rhs);
         }
         else
         {
             // Exp
-            step = std::make_unique<ExprStmt>(std::move(expr));
+            step = context_->create<ExprStmt>(expr);
         }
     }
 
@@ -606,38 +635,38 @@ std::unique_ptr<Stmt> Parser::parseForStmt()
 
     auto body = parseStmt();
 
-    return std::make_unique<ForStmt>(std::move(init), std::move(cond), std::move(step), std::move(body));
+    return context_->create<ForStmt>(init, cond, step, body);
 }
 
 // "return" [Exp] ";"
-std::unique_ptr<Stmt> Parser::parseReturnStmt()
+Stmt *Parser::parseReturnStmt()
 {
     consume(TokenType::TOK_RETURN, "Expected 'return'");
 
-    std::unique_ptr<Expr> value = nullptr;
+    Expr *value = nullptr;
     if (!check(TokenType::TOK_SEMICOLON))
     {
         value = parseExpr();
     }
 
     consume(TokenType::TOK_SEMICOLON, "Expected ';' after return");
-    return std::make_unique<ReturnStmt>(std::move(value));
+    return context_->create<ReturnStmt>(value);
 }
 
 // "break" ";"
-std::unique_ptr<Stmt> Parser::parseBreakStmt()
+Stmt *Parser::parseBreakStmt()
 {
-    advance(); // consume "break"
+    consume(TokenType::TOK_BREAK, "Expected 'break'");
     consume(TokenType::TOK_SEMICOLON, "Expected ';' after break");
-    return std::make_unique<BreakStmt>();
+    return context_->create<BreakStmt>();
 }
 
 // "continue" ";"
-std::unique_ptr<Stmt> Parser::parseContinueStmt()
+Stmt *Parser::parseContinueStmt()
 {
-    advance(); // consume "continue"
+    consume(TokenType::TOK_CONTINUE, "Expected 'continue'");
     consume(TokenType::TOK_SEMICOLON, "Expected ';' after continue");
-    return std::make_unique<ContinueStmt>();
+    return context_->create<ContinueStmt>();
 }
 
 /* ========================================================================== */
@@ -645,13 +674,13 @@ std::unique_ptr<Stmt> Parser::parseContinueStmt()
 /* ========================================================================== */
 
 // Exp ::= ConditionalExp
-std::unique_ptr<Expr> Parser::parseExpr()
+Expr *Parser::parseExpr()
 {
     return parseConditionalExpr();
 }
 
 // ConditionalExp ::= LOrExp | LOrExp "?" Exp ":" ConditionalExp
-std::unique_ptr<Expr> Parser::parseConditionalExpr()
+Expr *Parser::parseConditionalExpr()
 {
     auto expr = parseLOrExpr();
 
@@ -661,158 +690,158 @@ std::unique_ptr<Expr> Parser::parseConditionalExpr()
         consume(TokenType::TOK_COLON, "Expected ':' in ternary expression");
         auto falseExpr = parseConditionalExpr();
 
-        return std::make_unique<TernaryExpr>(std::move(expr), std::move(trueExpr), std::move(falseExpr));
+        return context_->create<TernaryExpr>(expr, trueExpr, falseExpr);
     }
 
     return expr;
 }
 
 // LOrExp ::= LAndExp { "||" LAndExp }
-std::unique_ptr<Expr> Parser::parseLOrExpr()
+Expr *Parser::parseLOrExpr()
 {
     auto left = parseLAndExpr();
 
     while (match(TokenType::TOK_LOR))
     {
         auto right = parseLAndExpr();
-        left = std::make_unique<BinaryExpr>(std::move(left), "||", std::move(right));
+        left = context_->create<BinaryExpr>(left, BinaryOp::LogicalOr, right);
     }
 
     return left;
 }
 
 // LAndExp ::= OrExp { "&&" OrExp }
-std::unique_ptr<Expr> Parser::parseLAndExpr()
+Expr *Parser::parseLAndExpr()
 {
     auto left = parseOrExpr();
 
     while (match(TokenType::TOK_LAND))
     {
         auto right = parseOrExpr();
-        left = std::make_unique<BinaryExpr>(std::move(left), "&&", std::move(right));
+        left = context_->create<BinaryExpr>(left, BinaryOp::LogicalAnd, right);
     }
 
     return left;
 }
 
 // OrExp ::= XorExp { "|" XorExp }
-std::unique_ptr<Expr> Parser::parseOrExpr()
+Expr *Parser::parseOrExpr()
 {
     auto left = parseXorExpr();
 
     while (match(TokenType::TOK_OR))
     {
         auto right = parseXorExpr();
-        left = std::make_unique<BinaryExpr>(std::move(left), "|", std::move(right));
+        left = context_->create<BinaryExpr>(left, BinaryOp::BitOr, right);
     }
 
     return left;
 }
 
 // XorExp ::= AndExp { "^" AndExp }
-std::unique_ptr<Expr> Parser::parseXorExpr()
+Expr *Parser::parseXorExpr()
 {
     auto left = parseAndExpr();
 
     while (match(TokenType::TOK_XOR))
     {
         auto right = parseAndExpr();
-        left = std::make_unique<BinaryExpr>(std::move(left), "^", std::move(right));
+        left = context_->create<BinaryExpr>(left, BinaryOp::BitXor, right);
     }
 
     return left;
 }
 
 // AndExp ::= EqExp { "&" EqExp }
-std::unique_ptr<Expr> Parser::parseAndExpr()
+Expr *Parser::parseAndExpr()
 {
     auto left = parseEqExpr();
 
     while (match(TokenType::TOK_AND))
     {
         auto right = parseEqExpr();
-        left = std::make_unique<BinaryExpr>(std::move(left), "&", std::move(right));
+        left = context_->create<BinaryExpr>(left, BinaryOp::BitAnd, right);
     }
 
     return left;
 }
 
 // EqExp ::= RelExp { ("==" | "!=") RelExp }
-std::unique_ptr<Expr> Parser::parseEqExpr()
+Expr *Parser::parseEqExpr()
 {
     auto left = parseRelExpr();
 
     while (check(TokenType::TOK_EQ) || check(TokenType::TOK_NE))
     {
-        std::string op = current_.lexeme;
+        BinaryOp op = toBinaryOp(kind());
         advance();
         auto right = parseRelExpr();
-        left = std::make_unique<BinaryExpr>(std::move(left), op, std::move(right));
+        left = context_->create<BinaryExpr>(left, op, right);
     }
 
     return left;
 }
 
 // RelExp ::= ShiftExp { ("<" | ">" | "<=" | ">=") ShiftExp }
-std::unique_ptr<Expr> Parser::parseRelExpr()
+Expr *Parser::parseRelExpr()
 {
     auto left = parseShiftExpr();
 
     while (check(TokenType::TOK_LT) || check(TokenType::TOK_GT) ||
            check(TokenType::TOK_LE) || check(TokenType::TOK_GE))
     {
-        std::string op = current_.lexeme;
+        BinaryOp op = toBinaryOp(kind());
         advance();
         auto right = parseShiftExpr();
-        left = std::make_unique<BinaryExpr>(std::move(left), op, std::move(right));
+        left = context_->create<BinaryExpr>(left, op, right);
     }
 
     return left;
 }
 
 // ShiftExp ::= AddExp { ("<<" | ">>") AddExp }
-std::unique_ptr<Expr> Parser::parseShiftExpr()
+Expr *Parser::parseShiftExpr()
 {
     auto left = parseAddExpr();
 
     while (check(TokenType::TOK_SHL) || check(TokenType::TOK_SHR))
     {
-        std::string op = current_.lexeme;
+        BinaryOp op = toBinaryOp(kind());
         advance();
         auto right = parseAddExpr();
-        left = std::make_unique<BinaryExpr>(std::move(left), op, std::move(right));
+        left = context_->create<BinaryExpr>(left, op, right);
     }
 
     return left;
 }
 
 // AddExp ::= MulExp { ("+" | "-") MulExp }
-std::unique_ptr<Expr> Parser::parseAddExpr()
+Expr *Parser::parseAddExpr()
 {
     auto left = parseMulExpr();
 
     while (check(TokenType::TOK_PLUS) || check(TokenType::TOK_MINUS))
     {
-        std::string op = current_.lexeme;
+        BinaryOp op = toBinaryOp(kind());
         advance();
         auto right = parseMulExpr();
-        left = std::make_unique<BinaryExpr>(std::move(left), op, std::move(right));
+        left = context_->create<BinaryExpr>(left, op, right);
     }
 
     return left;
 }
 
 // MulExp ::= UnaryExp { ("*" | "/" | "%") UnaryExp }
-std::unique_ptr<Expr> Parser::parseMulExpr()
+Expr *Parser::parseMulExpr()
 {
     auto left = parseUnaryExpr();
 
     while (check(TokenType::TOK_STAR) || check(TokenType::TOK_SLASH) || check(TokenType::TOK_PERCENT))
     {
-        std::string op = current_.lexeme;
+        BinaryOp op = toBinaryOp(kind());
         advance();
         auto right = parseUnaryExpr();
-        left = std::make_unique<BinaryExpr>(std::move(left), op, std::move(right));
+        left = context_->create<BinaryExpr>(left, op, right);
     }
 
     return left;
@@ -822,59 +851,37 @@ std::unique_ptr<Expr> Parser::parseMulExpr()
 //            | IDENT "(" [ FuncRParams ] ")"
 //            | UnaryOp UnaryExp
 // UnaryOp ::= "+" | "-" | "!" | "~" | "++" | "--"
-std::unique_ptr<Expr> Parser::parseUnaryExpr()
+Expr *Parser::parseUnaryExpr()
 {
     // UnaryOp UnaryExp
     if (isUnaryOp())
     {
-        std::string op = current_.lexeme;
+        UnaryOp op = toUnaryOp(kind());
         advance();
         auto rhs = parseUnaryExpr();
-        return std::make_unique<UnaryExpr>(op, std::move(rhs));
+        return context_->create<UnaryExpr>(op, rhs);
     }
 
-    // IDENT "(" [ FuncRParams ] ")"
-    if (check(TokenType::TOK_IDENTIFIER))
+    // IDENT "(" [ FuncRParams ] ")"：向前看一个 token 区分函数调用与 LVal
+    if (check(TokenType::TOK_IDENTIFIER) && peek(1) == TokenType::TOK_LPAREN)
     {
-        // 向前看一个 token
-        Token name = current_;
-        advance();
+        auto funcCall = context_->create<FuncCallExpr>(identifier());
+        advance(); // IDENT
+        advance(); // "("
 
-        if (match(TokenType::TOK_LPAREN))
+        // FuncRParams ::= Exp { "," Exp }
+        if (!check(TokenType::TOK_RPAREN))
         {
-            // 函数调用
-            auto funcCall = std::make_unique<FuncCallExpr>(name.lexeme);
+            funcCall->addArg(*context_, parseExpr());
 
-            // FuncRParams ::= Exp { "," Exp }
-            if (!check(TokenType::TOK_RPAREN))
+            while (match(TokenType::TOK_COMMA))
             {
-                funcCall->addArg(parseExpr());
-
-                while (match(TokenType::TOK_COMMA))
-                {
-                    funcCall->addArg(parseExpr());
-                }
+                funcCall->addArg(*context_, parseExpr());
             }
-
-            consume(TokenType::TOK_RPAREN, "Expected ')' after arguments");
-            return funcCall;
         }
-        else
-        {
-            // 不是函数调用，是 LVal
-            // 回退并解析为 PrimaryExp
-            auto lval = std::make_unique<LValExpr>(name.lexeme);
 
-            // LVal ::= IDENT { "[" Exp "]" }
-            while (match(TokenType::TOK_LBRACKET))
-            {
-                auto index = parseExpr();
-                lval->addIndex(std::move(index));
-                consume(TokenType::TOK_RBRACKET, "Expected ']'");
-            }
-
-            return lval;
-        }
+        consume(TokenType::TOK_RPAREN, "Expected ')' after arguments");
+        return funcCall;
     }
 
     // PrimaryExp
@@ -886,7 +893,7 @@ std::unique_ptr<Expr> Parser::parseUnaryExpr()
 //              | Number
 //              | String
 //              | CharLiteral
-std::unique_ptr<Expr> Parser::parsePrimaryExpr()
+Expr *Parser::parsePrimaryExpr()
 {
     // "(" Exp ")"
     if (match(TokenType::TOK_LPAREN))
@@ -899,26 +906,26 @@ std::unique_ptr<Expr> Parser::parsePrimaryExpr()
     // Number
     if (check(TokenType::TOK_NUMBER))
     {
-        int value = std::stoi(current_.lexeme);
+        // 数值已由词法分析器按进制解析
+        int value = static_cast<int>(intValue());
         advance();
-        return std::make_unique<NumberExpr>(value);
+        return context_->create<NumberExpr>(value);
     }
 
     // CharLiteral
     if (check(TokenType::TOK_CHAR_LITERAL))
     {
-        // 简化处理：取第一个字符
-        char value = current_.lexeme.empty() ? '\0' : current_.lexeme[0];
+        char value = static_cast<char>(intValue());
         advance();
-        return std::make_unique<CharExpr>(value);
+        return context_->create<CharExpr>(value);
     }
 
     // String
     if (check(TokenType::TOK_STRING))
     {
-        std::string value = current_.lexeme;
+        const std::string &value = context_->saveString(decodeStringLiteral(lexeme()));
         advance();
-        return std::make_unique<StringExpr>(value);
+        return context_->create<StringExpr>(value);
     }
 
     // LVal
@@ -932,16 +939,16 @@ std::unique_ptr<Expr> Parser::parsePrimaryExpr()
 }
 
 // LVal ::= IDENT { "[" Exp "]" }
-std::unique_ptr<LValExpr> Parser::parseLVal()
+LValExpr *Parser::parseLVal()
 {
-    Token name = consume(TokenType::TOK_IDENTIFIER, "Expected identifier");
-    auto lval = std::make_unique<LValExpr>(name.lexeme);
+    Identifier name = consumeIdentifier("Expected identifier");
+    auto lval = context_->create<LValExpr>(name);
 
     // { "[" Exp "]" }
     while (match(TokenType::TOK_LBRACKET))
     {
         auto index = parseExpr();
-        lval->addIndex(std::move(index));
+        lval->addIndex(*context_, index);
         consume(TokenType::TOK_RBRACKET, "Expected ']'");
     }
 
@@ -949,7 +956,7 @@ std::unique_ptr<LValExpr> Parser::parseLVal()
 }
 
 // ConstExp ::= Exp (语法上等同于 Exp，语义上要求是常量表达式)
-std::unique_ptr<Expr> Parser::parseConstExpr()
+Expr *Parser::parseConstExpr()
 {
     return parseExpr();
 }
@@ -975,6 +982,74 @@ bool Parser::isUnaryOp() const
            check(TokenType::TOK_DEC);
 }
 
+BinaryOp Parser::toBinaryOp(TokenType type)
+{
+    switch (type)
+    {
+    case TokenType::TOK_PLUS:
+        return BinaryOp::Add;
+    case TokenType::TOK_MINUS:
+        return BinaryOp::Sub;
+    case TokenType::TOK_STAR:
+        return BinaryOp::Mul;
+    case TokenType::TOK_SLASH:
+        return BinaryOp::Div;
+    case TokenType::TOK_PERCENT:
+        return BinaryOp::Mod;
+    case TokenType::TOK_LT:
+        return BinaryOp::Lt;
+    case TokenType::TOK_GT:
+        return BinaryOp::Gt;
+    case TokenType::TOK_LE:
+        return BinaryOp::Le;
+    case TokenType::TOK_GE:
+        return BinaryOp::Ge;
+    case TokenType::TOK_EQ:
+        return BinaryOp::Eq;
+    case TokenType::TOK_NE:
+        return BinaryOp::Ne;
+    case TokenType::TOK_AND:
+        return BinaryOp::BitAnd;
+    case TokenType::TOK_OR:
+        return BinaryOp::BitOr;
+    case TokenType::TOK_XOR:
+        return BinaryOp::BitXor;
+    case TokenType::TOK_SHL:
+        return BinaryOp::Shl;
+    case TokenType::TOK_SHR:
+        return BinaryOp::Shr;
+    case TokenType::TOK_LAND:
+        return BinaryOp::LogicalAnd;
+    case TokenType::TOK_LOR:
+        return BinaryOp::LogicalOr;
+    default:
+        assert(false && "token is not a binary operator");
+        return BinaryOp::Add;
+    }
+}
+
+UnaryOp Parser::toUnaryOp(TokenType type)
+{
+    switch (type)
+    {
+    case TokenType::TOK_PLUS:
+        return UnaryOp::Plus;
+    case TokenType::TOK_MINUS:
+        return UnaryOp::Minus;
+    case TokenType::TOK_NOT:
+        return UnaryOp::LogicalNot;
+    case TokenType::TOK_TILDE:
+        return UnaryOp::BitNot;
+    case TokenType::TOK_INC:
+        return UnaryOp::PreInc;
+    case TokenType::TOK_DEC:
+        return UnaryOp::PreDec;
+    default:
+        assert(false && "token is not a unary operator");
+        return UnaryOp::Plus;
+    }
+}
+
 std::string Parser::tokenToString(TokenType type) const
 {
     // 简化实现
@@ -2,21 +2,29 @@
 #include "ast.h"
 #include "lexer.h"
 #include <iostream>
-#include <fstream>
 #include <sstream>
 
 int main(int argc, char *argv[])
 {
+    // --token-buffer：先整体切分为 TokenBuffer，再由语法分析器按下标遍历
+    bool useTokenBuffer = argc > 1 && std::string(argv[1]) == "--token-buffer";
+    if (useTokenBuffer)
+    {
+        argv++;
+        argc--;
+    }
+
     if (argc < 2)
     {
-        std::cout << "Usage: " << argv[0] << " <source_file>" << std::endl;
+        std::cout << "Usage: " << argv[0] << " [--token-buffer] <source_file>" << std::endl;
         std::cout << "\nExample: " << argv[0] << " test.c" << std::endl;
         std::cout << "\nOr run with inline test:" << std::endl;
         std::cout << "  " << argv[0] << " --test" << std::endl;
         return 1;
     }
 
-    std::string source;
+    SourceManager sources;
+    std::string_view source;
     std::string filename;
 
     if (std::string(argv[1]) == "--test")
@@ -46,16 +54,13 @@ int main() {
     {
         // 从文件读取
         filename = argv[1];
-        std::ifstream file(filename);
-        if (!file)
+        const SourceBuffer *buffer = sources.load(filename);
+        if (!buffer)
         {
-            std::cerr << "Error: Cannot open file '" << filename << "'" << std::endl;
+            std::cerr << "Error: " << sources.getError() << std::endl;
             return 1;
         }
-
-        std::stringstream buffer;
-        buffer << file.rdbuf();
-        source = buffer.str();
+        source = buffer->text();
     }
 
     std::cout << "=== Parsing " << filename << " ===" << std::endl;
@@ -68,7 +73,13 @@ int main() {
     Lexer lexer(filename, source);
 
     // 创建语法分析器
-    Parser parser(lexer);
+    TokenBuffer tokens;
+    if (useTokenBuffer)
+    {
+        tokens = lexer.tokenize();
+        std::cout << "\nTokenized " << tokens.size() << " tokens" << std::endl;
+    }
+    Parser parser(lexer, useTokenBuffer ? &tokens : nullptr);
 
     // 解析
     std::cout << "\n=== Parsing ===" << std::endl;
@@ -96,6 +107,37 @@ int main() {
         std::cout << "(empty)" << std::endl;
     }
 
+    if (useTokenBuffer)
+    {
+        // 按下标遍历与逐个读取必须得到相同的 AST
+        auto dumpOf = [](const CompUnit *unit)
+        {
+            std::ostringstream os;
+            std::streambuf *old = std::cout.rdbuf(os.rdbuf());
+            unit->dump(0);
+            std::cout.rdbuf(old);
+            return os.str();
+        };
+        Lexer streamLexer(filename, source);
+        Parser streamParser(streamLexer);
+        auto streamAst = streamParser.parse();
+        if (streamParser.hasErrors() || !ast || !streamAst || dumpOf(streamAst.get()) != dumpOf(ast.get()))
+        {
+            std::cerr << "AST from token buffer differs from streaming parse" << std::endl;
+            return 1;
+        }
+
+        // 默认构造的空缓冲区读作 TOK_EOF
+        TokenBuffer empty;
+        Parser emptyParser(lexer, &empty);
+        auto emptyAst = emptyParser.parse();
+        if (emptyParser.hasErrors() || !emptyAst || !emptyAst->getUnits().empty())
+        {
+            std::cerr << "Empty token buffer did not parse as an empty unit" << std::endl;
+            return 1;
+        }
+    }
+
     std::cout << "\n=== Parse completed successfully ===" << std::endl;
     return 0;
 }
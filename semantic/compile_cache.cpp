@@ -0,0 +1,99 @@
+#include "compile_cache.h"
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Config/llvm-config.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/Process.h>
+#include <llvm/Support/SHA1.h>
+#include <llvm/TargetParser/Host.h>
+
+/* -------------------------------------------------------------------------- */
+/*                                Compile cache                               */
+/* -------------------------------------------------------------------------- */
+
+namespace
+{
+    // 缓存内容或键的格式改变时递增，使旧条目失效
+    constexpr const char *CACHE_FORMAT = "cinterp-cache-1";
+}
+
+CompileCache::CompileCache(const std::string &directory)
+    : directory(directory.empty() ? getDefaultDirectory() : directory)
+{
+}
+
+std::string CompileCache::getDefaultDirectory()
+{
+    if (auto dir = llvm::sys::Process::GetEnv("CINTERP_CACHE_DIR"))
+        return *dir;
+
+    llvm::SmallString<128> path;
+    if (!llvm::sys::path::cache_directory(path))
+        llvm::sys::fs::current_path(path);
+    llvm::sys::path::append(path, "cinterp");
+    return path.str().str();
+}
+
+std::string CompileCache::computeKey(std::string_view source, const KeyOptions &options)
+{
+    std::string flags = "opt=" + (options.optLevel < 0 ? std::string("none") : std::to_string(options.optLevel)) +
+                        ";passes=" + options.pipeline +
+                        ";target=" + (options.native ? "cpu:" + options.cpu : std::string("none"));
+
+    // 各部分以 '\0' 分隔，避免不同的拼接产生相同的输入；源码直接增量哈希，不复制
+    llvm::SHA1 sha;
+    for (const std::string &part : {std::string(CACHE_FORMAT), std::string(LLVM_VERSION_STRING),
+                                    llvm::sys::getDefaultTargetTriple(), llvm::sys::getHostCPUName().str(),
+                                    flags})
+    {
+        sha.update(part);
+        sha.update(llvm::StringRef("\0", 1));
+    }
+    sha.update(llvm::StringRef(source.data(), source.size()));
+
+    auto digest = sha.final();
+    return llvm::toHex(digest, /*LowerCase=*/true);
+}
+
+std::string CompileCache::getPath(const std::string &key, const std::string &extension) const
+{
+    llvm::SmallString<128> path(directory);
+    llvm::sys::path::append(path, key + extension);
+    return path.str().str();
+}
+
+bool CompileCache::contains(const std::string &key, const std::string &extension) const
+{
+    return llvm::sys::fs::exists(getPath(key, extension));
+}
+
+bool CompileCache::store(const std::string &key, const std::string &extension,
+                         const std::function<bool(const std::string &)> &write)
+{
+    if (llvm::sys::fs::create_directories(directory))
+        return false;
+
+    // 临时文件与条目位于同一目录，rename 才是原子的
+    int fd;
+    llvm::SmallString<128> tempPath;
+    llvm::SmallString<128> model(directory);
+    llvm::sys::path::append(model, key + "-%%%%%%" + extension + ".tmp");
+    if (llvm::sys::fs::createUniqueFile(model, fd, tempPath))
+        return false;
+    llvm::sys::Process::SafelyCloseFileDescriptor(fd);
+
+    std::string temp = tempPath.str().str();
+    if (!write(temp) || llvm::sys::fs::rename(temp, getPath(key, extension)))
+    {
+        llvm::sys::fs::remove(temp);
+        return false;
+    }
+    return true;
+}
+
+bool CompileCache::copyTo(const std::string &key, const std::string &extension,
+                          const std::string &destination) const
+{
+    return !llvm::sys::fs::copy_file(getPath(key, extension), destination);
+}
@@ -0,0 +1,219 @@
+#include "semantic.h"
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/IR/PassInstrumentation.h>
+#include <llvm/Support/Error.h>
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <unordered_map>
+
+/* -------------------------------------------------------------------------- */
+/*                                Optimization                                */
+/* -------------------------------------------------------------------------- */
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double elapsedMs(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    size_t countInstructions(const llvm::Module &module)
+    {
+        size_t count = 0;
+        for (const llvm::Function &func : module)
+            count += func.getInstructionCount();
+        return count;
+    }
+
+    // pass 管理器、适配器等只负责调度，不计入统计（与 -time-passes 一致）
+    bool isSpecialPass(llvm::StringRef name)
+    {
+        static const char *const specials[] = {"PassManager", "PassAdaptor", "AnalysisManagerProxy",
+                                               "ModuleInlinerWrapperPass", "DevirtSCCRepeatedPass"};
+        for (const char *special : specials)
+        {
+            if (name.contains(special))
+                return true;
+        }
+        return false;
+    }
+
+    /**
+     * 通过 pass instrumentation 统计每个 pass 的运行次数与自身耗时
+     * pass 会嵌套运行（模块 -> CGSCC -> 函数 -> 循环），用栈记录开始时间，
+     * 子 pass 的耗时从父 pass 中扣除。
+     */
+    class PassTimer
+    {
+    private:
+        struct Frame
+        {
+            Clock::time_point start;
+            double childMs;
+        };
+
+        std::vector<Frame> stack;
+        std::unordered_map<std::string, size_t> index;
+        std::vector<PassStat> &stats;
+
+        void before()
+        {
+            stack.push_back({Clock::now(), 0});
+        }
+
+        void after(llvm::StringRef name)
+        {
+            if (stack.empty())
+                return;
+
+            Frame frame = stack.back();
+            stack.pop_back();
+            double total = elapsedMs(frame.start);
+            if (!stack.empty())
+                stack.back().childMs += total;
+
+            if (isSpecialPass(name))
+                return;
+
+            auto it = index.find(name.str());
+            if (it == index.end())
+            {
+                it = index.emplace(name.str(), stats.size()).first;
+                stats.push_back({name.str(), 0, 0});
+            }
+            PassStat &stat = stats[it->second];
+            stat.runs++;
+            stat.ms += total - frame.childMs;
+        }
+
+    public:
+        explicit PassTimer(std::vector<PassStat> &out) : stats(out) {}
+
+        void registerCallbacks(llvm::PassInstrumentationCallbacks &pic)
+        {
+            pic.registerBeforeNonSkippedPassCallback(
+                [this](llvm::StringRef, llvm::Any) { before(); });
+            pic.registerAfterPassCallback(
+                [this](llvm::StringRef name, llvm::Any, const llvm::PreservedAnalyses &) { after(name); });
+            pic.registerAfterPassInvalidatedCallback(
+                [this](llvm::StringRef name, const llvm::PreservedAnalyses &) { after(name); });
+        }
+    };
+
+    llvm::OptimizationLevel toLLVMLevel(OptLevel level)
+    {
+        switch (level)
+        {
+        case OptLevel::O0:
+            return llvm::OptimizationLevel::O0;
+        case OptLevel::O1:
+            return llvm::OptimizationLevel::O1;
+        case OptLevel::O2:
+            return llvm::OptimizationLevel::O2;
+        case OptLevel::O3:
+            return llvm::OptimizationLevel::O3;
+        }
+        return llvm::OptimizationLevel::O2;
+    }
+
+    const char *getLevelName(OptLevel level)
+    {
+        static const char *const names[] = {"default<O0>", "default<O1>", "default<O2>", "default<O3>"};
+        return names[static_cast<int>(level)];
+    }
+}
+
+bool CodeGenerator::optimize(OptLevel level)
+{
+    return runPipeline(&level, getLevelName(level));
+}
+
+bool CodeGenerator::runPasses(const std::string &pipeline)
+{
+    return runPipeline(nullptr, pipeline);
+}
+
+bool CodeGenerator::runPipeline(const OptLevel *level, const std::string &pipeline)
+{
+    if (!module)
+    {
+        error("No module to optimize");
+        return false;
+    }
+
+    optStats = OptimizationStats();
+    optStats.pipeline = pipeline;
+    optStats.instructionsBefore = countInstructions(*module);
+
+    // 各分析管理器之间互相引用，必须按此顺序声明以保证析构顺序正确
+    llvm::LoopAnalysisManager LAM;
+    llvm::FunctionAnalysisManager FAM;
+    llvm::CGSCCAnalysisManager CGAM;
+    llvm::ModuleAnalysisManager MAM;
+
+    llvm::PassInstrumentationCallbacks PIC;
+    PassTimer timer(optStats.passes);
+    timer.registerCallbacks(PIC);
+
+    // 已初始化目标时向优化器提供目标信息（向量宽度、指令代价等）
+    llvm::PassBuilder PB(targetMachine.get(), llvm::PipelineTuningOptions(), {}, &PIC);
+    PB.registerModuleAnalyses(MAM);
+    PB.registerCGSCCAnalyses(CGAM);
+    PB.registerFunctionAnalyses(FAM);
+    PB.registerLoopAnalyses(LAM);
+    PB.crossRegisterProxies(LAM, FAM, CGAM, MAM);
+
+    llvm::ModulePassManager MPM;
+    if (level)
+    {
+        if (*level == OptLevel::O0)
+            MPM = PB.buildO0DefaultPipeline(llvm::OptimizationLevel::O0);
+        else
+            MPM = PB.buildPerModuleDefaultPipeline(toLLVMLevel(*level));
+    }
+    else if (llvm::Error err = PB.parsePassPipeline(MPM, pipeline))
+    {
+        error("Invalid pass pipeline '" + pipeline + "': " + llvm::toString(std::move(err)));
+        return false;
+    }
+
+    auto start = Clock::now();
+    MPM.run(*module, MAM);
+    optStats.totalMs = elapsedMs(start);
+    optStats.instructionsAfter = countInstructions(*module);
+
+    // 自定义流水线可能破坏 IR，优化后再次验证
+    std::string verifyErrors;
+    llvm::raw_string_ostream os(verifyErrors);
+    if (llvm::verifyModule(*module, &os))
+    {
+        error("Module verification failed after optimization:\n" + os.str());
+        return false;
+    }
+
+    return true;
+}
+
+void CodeGenerator::printOptimizationStats(std::ostream &os) const
+{
+    std::ios::fmtflags flags = os.flags();
+    std::streamsize precision = os.precision();
+
+    os << "Pipeline: " << optStats.pipeline << "\n";
+    os << "Total: " << std::fixed << std::setprecision(3) << optStats.totalMs << " ms, instructions "
+       << optStats.instructionsBefore << " -> " << optStats.instructionsAfter << "\n";
+
+    // 按耗时从高到低输出
+    std::vector<PassStat> sorted = optStats.passes;
+    std::stable_sort(sorted.begin(), sorted.end(),
+                     [](const PassStat &a, const PassStat &b) { return a.ms > b.ms; });
+    for (const PassStat &stat : sorted)
+    {
+        os << std::setw(10) << stat.ms << " ms  " << std::setw(5) << stat.runs << "x  " << stat.name << "\n";
+    }
+    os.flags(flags);
+    os.precision(precision);
+}
@@ -0,0 +1,174 @@
+#include "semantic.h"
+#include "const_fold.h"
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/Linker/Linker.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <unordered_set>
+
+/* -------------------------------------------------------------------------- */
+/*                              Parallel codegen                              */
+/* -------------------------------------------------------------------------- */
+
+namespace
+{
+    // 每个线程平均分到的块数：块越多负载越均衡，但每块都要重新声明它之前的全局符号
+    constexpr size_t CHUNKS_PER_THREAD = 4;
+
+    // 一个函数块的生成结果（在工作线程中序列化为 bitcode，主线程解析并链接）
+    struct ChunkResult
+    {
+        llvm::SmallVector<char, 0> bitcode;
+        std::vector<std::string> errors;
+    };
+}
+
+void CodeGenerator::generateChunk(CompUnit *compUnit, const std::vector<FuncDef *> &funcDefs,
+                                  size_t begin, size_t end)
+{
+    externalGlobals = true;
+
+    // 按源码顺序走到块内最后一个函数为止：块外的函数只声明原型，
+    // 因此块内函数能看到的符号与顺序生成时相同（调用后面的函数、使用后面的全局变量照样报错）
+    size_t next = begin;
+    for (const auto &unit : compUnit->getUnits())
+    {
+        if (auto *funcDef = dyn_cast<FuncDef>(unit))
+        {
+            if (funcDef != funcDefs[next])
+            {
+                declareFunction(funcDef);
+                continue;
+            }
+            generateFuncDef(funcDef);
+            if (++next == end)
+                break;
+        }
+        else if (auto *decl = dyn_cast<Decl>(unit))
+        {
+            // 全局声明的错误由主模块报告一次，块中丢弃
+            size_t numErrors = errors.size();
+            generateDecl(decl);
+            errors.resize(numErrors);
+            hasErrors = numErrors != 0;
+        }
+    }
+
+    externalGlobals = false;
+}
+
+bool CodeGenerator::generateParallel(CompUnit *compUnit, unsigned numThreads)
+{
+    // 工作线程只读 AST，折叠必须在启动线程之前完成
+    foldConstants(compUnit);
+
+    size_t numFuncs = 0;
+    for (const auto &unit : compUnit->getUnits())
+    {
+        if (isa<FuncDef>(unit))
+            ++numFuncs;
+    }
+
+    if (numThreads == 0)
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    if (numThreads <= 1 || numFuncs < 2)
+        return generate(compUnit);
+
+    // 全局变量在本模块中定义（声明错误只在这里报告），各块中只有外部声明；
+    // 重复定义的函数同样在这里报告，且不交给任何块生成
+    std::vector<FuncDef *> funcDefs;
+    std::unordered_set<Identifier> funcNames;
+    for (const auto &unit : compUnit->getUnits())
+    {
+        if (auto *funcDef = dyn_cast<FuncDef>(unit))
+        {
+            if (funcNames.insert(funcDef->getIdentifier()).second)
+                funcDefs.push_back(funcDef);
+            else
+                error("Redefinition of function: " + funcDef->getName());
+        }
+        else if (auto *decl = dyn_cast<Decl>(unit))
+        {
+            generateDecl(decl);
+        }
+    }
+
+    // 按源码顺序切成连续的块，线程动态领取；链接按块顺序进行，输出与调度无关
+    size_t numChunks = std::min(funcDefs.size(), numThreads * CHUNKS_PER_THREAD);
+    std::vector<ChunkResult> results(numChunks);
+    std::atomic<size_t> nextChunk{0};
+
+    auto worker = [&]()
+    {
+        for (size_t chunk; (chunk = nextChunk.fetch_add(1)) < numChunks;)
+        {
+            size_t begin = funcDefs.size() * chunk / numChunks;
+            size_t end = funcDefs.size() * (chunk + 1) / numChunks;
+
+            // 每块使用独立的 LLVMContext，线程之间不共享任何 LLVM 对象
+            // 错误只记录不输出，由当前线程按块顺序统一报告
+            CodeGenerator chunkGen(module->getModuleIdentifier());
+            chunkGen.deferErrors = true;
+            chunkGen.module->setTargetTriple(module->getTargetTriple());
+            chunkGen.module->setDataLayout(module->getDataLayout());
+            chunkGen.generateChunk(compUnit, funcDefs, begin, end);
+
+            ChunkResult &result = results[chunk];
+            result.errors = std::move(chunkGen.errors);
+            if (!chunkGen.hasErrors)
+            {
+                llvm::raw_svector_ostream os(result.bitcode);
+                llvm::WriteBitcodeToFile(*chunkGen.module, os);
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < std::min<size_t>(numThreads, numChunks); ++i)
+    {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    // 解析到本模块的上下文并链接：外部声明解析到本模块或其他块中的定义
+    llvm::Linker linker(*module);
+    for (auto &result : results)
+    {
+        if (!result.errors.empty())
+        {
+            for (const auto &message : result.errors)
+                error(message);
+            continue;
+        }
+
+        llvm::MemoryBufferRef buffer(llvm::StringRef(result.bitcode.data(), result.bitcode.size()),
+                                     module->getModuleIdentifier());
+        auto chunkModule = llvm::parseBitcodeFile(buffer, *context);
+        if (!chunkModule)
+        {
+            error("Cannot read generated module: " + llvm::toString(chunkModule.takeError()));
+            continue;
+        }
+        if (linker.linkInModule(std::move(*chunkModule)))
+        {
+            error("Cannot link generated module");
+        }
+    }
+
+    // 验证模块
+    if (llvm::verifyModule(*module, &llvm::errs()))
+    {
+        error("Module verification failed");
+        return false;
+    }
+
+    return !hasErrors;
+}
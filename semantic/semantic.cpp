@@ -1,8 +1,13 @@
-#include "semantic.h.old"
+#include "semantic.h"
+#include "const_fold.h"
 #include <llvm/IR/Verifier.h>
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/Support/MemoryBuffer.h>
 #include <llvm/Support/raw_ostream.h>
 #include <llvm/Support/FileSystem.h>
 #include <llvm/IR/Constants.h>
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 
@@ -10,46 +15,83 @@
 /*                                Symbol Table                                */
 /* -------------------------------------------------------------------------- */
 SymbolTable::SymbolTable()
+    : slots(64)
 {
     enterScope(); // 全局作用域
 }
 
+SymbolTable::Slot &SymbolTable::findSlot(const void *key)
+{
+    // 指针低位是对齐产生的 0，乘法散列后取高位
+    size_t mask = slots.size() - 1;
+    size_t i = ((reinterpret_cast<uintptr_t>(key) * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+    while (slots[i].key && slots[i].key != key)
+    {
+        i = (i + 1) & mask; // 线性探测
+    }
+    return slots[i];
+}
+
+void SymbolTable::grow()
+{
+    std::vector<Slot> old(slots.size() * 2);
+    old.swap(slots);
+    for (const Slot &slot : old)
+    {
+        if (slot.key)
+            findSlot(slot.key) = slot;
+    }
+}
+
 void SymbolTable::enterScope()
 {
-    scopes.emplace_back();
+    scopeMarks.push_back(bindings.size());
 }
 
 void SymbolTable::exitScope()
 {
-    if (scopes.size() > 1)
+    if (scopeMarks.size() <= 1)
+        return;
+
+    // 按声明的逆序撤销本层绑定
+    size_t mark = scopeMarks.back();
+    scopeMarks.pop_back();
+    while (bindings.size() > mark)
     {
-        scopes.pop_back();
+        const Binding &binding = bindings.back();
+        findSlot(binding.name.key()).binding = binding.shadowed;
+        bindings.pop_back();
     }
 }
 
-bool SymbolTable::declare(const std::string &name, const SymbolInfo &info)
+bool SymbolTable::declare(Identifier name, SymbolInfo info)
 {
-    auto &currentScope = scopes.back();
-    if (currentScope.find(name) != currentScope.end())
+    // 负载因子保持在 1/2 以下，槽位只在出现新名字时占用
+    if ((usedSlots + 1) * 2 > slots.size())
+        grow();
+
+    Slot &slot = findSlot(name.key());
+    uint32_t scope = scopeMarks.size();
+    if (slot.binding != NO_BINDING && bindings[slot.binding].scope == scope)
     {
         return false; // 重复声明
     }
-    currentScope[name] = info;
+
+    if (!slot.key)
+    {
+        slot.key = name.key();
+        usedSlots++;
+    }
+
+    bindings.push_back({std::move(info), name, slot.binding, scope});
+    slot.binding = static_cast<int32_t>(bindings.size() - 1);
     return true;
 }
 
-SymbolInfo *SymbolTable::lookup(const std::string &name)
+SymbolInfo *SymbolTable::lookup(Identifier name)
 {
-    // 从内向外查找
-    for (auto it = scopes.rbegin(); it != scopes.rend(); ++it)
-    {
-        auto found = it->find(name);
-        if (found != it->end())
-        {
-            return &found->second;
-        }
-    }
-    return nullptr;
+    Slot &slot = findSlot(name.key());
+    return slot.binding == NO_BINDING ? nullptr : &bindings[slot.binding].info;
 }
 
 /* -------------------------------------------------------------------------- */
@@ -57,7 +99,8 @@ SymbolInfo *SymbolTable::lookup(const std::string &name)
 /* -------------------------------------------------------------------------- */
 
 CodeGenerator::CodeGenerator(const std::string &moduleName)
-    : hasErrors(false), currentFunction(nullptr)
+    : currentFunction(nullptr), lastEntryAlloca(nullptr), externalGlobals(false), deferErrors(false),
+      runtimeChecks(false), currentFunctionName(nullptr), hasErrors(false)
 {
     context = std::make_unique<llvm::LLVMContext>();
     module = std::make_unique<llvm::Module>(moduleName, *context);
@@ -70,7 +113,8 @@ void CodeGenerator::error(const std::string &message)
 {
     hasErrors = true;
     errors.push_back(message);
-    std::cerr << "Semantic Error: " << message << std::endl;
+    if (!deferErrors)
+        std::cerr << "Semantic Error: " << message << std::endl;
 }
 
 /* --------------------- Type system auxiliary functions -------------------- */
@@ -91,14 +135,14 @@ llvm::Type *CodeGenerator::getLLVMType(const TypeSpec &typeSpec)
 }
 
 llvm::Type *CodeGenerator::getArrayType(llvm::Type *elementType,
-                                        const std::vector<std::unique_ptr<Expr>> &dims)
+                                        const ASTList<Expr *> &dims)
 {
     llvm::Type *type = elementType;
 
     // 从右到左构建数组类型（内层到外层）
     for (auto it = dims.rbegin(); it != dims.rend(); ++it)
     {
-        if (auto *numExpr = dynamic_cast<NumberExpr *>(it->get()))
+        if (auto *numExpr = dyn_cast<NumberExpr>(*it))
         {
             int size = numExpr->getValue();
             if (size <= 0)
@@ -214,32 +258,45 @@ llvm::Value *CodeGenerator::convertToBool(llvm::Value *val)
     return nullptr;
 }
 
+// 在入口块中分配栈空间：按声明顺序排在已有 alloca 之后，位于任何其他指令之前
+llvm::AllocaInst *CodeGenerator::createEntryBlockAlloca(llvm::Type *type, const std::string &name)
+{
+    llvm::BasicBlock &entry = currentFunction->getEntryBlock();
+    llvm::IRBuilder<> entryBuilder(&entry, lastEntryAlloca ? std::next(lastEntryAlloca->getIterator())
+                                                           : entry.begin());
+    lastEntryAlloca = entryBuilder.CreateAlloca(type, nullptr, name);
+    return lastEntryAlloca;
+}
+
 /* ----------------------- Expression code generation ----------------------- */
 llvm::Value *CodeGenerator::generateExpr(Expr *expr)
 {
     if (!expr)
         return nullptr;
 
-    if (auto *numExpr = dynamic_cast<NumberExpr *>(expr))
-        return generateNumberExpr(numExpr);
-    if (auto *charExpr = dynamic_cast<CharExpr *>(expr))
-        return generateCharExpr(charExpr);
-    if (auto *strExpr = dynamic_cast<StringExpr *>(expr))
-        return generateStringExpr(strExpr);
-    if (auto *lvalExpr = dynamic_cast<LValExpr *>(expr))
-        return generateLValExpr(lvalExpr);
-    if (auto *binExpr = dynamic_cast<BinaryExpr *>(expr))
-        return generateBinaryExpr(binExpr);
-    if (auto *unExpr = dynamic_cast<UnaryExpr *>(expr))
-        return generateUnaryExpr(unExpr);
-    if (auto *ternExpr = dynamic_cast<TernaryExpr *>(expr))
-        return generateTernaryExpr(ternExpr);
-    if (auto *callExpr = dynamic_cast<FuncCallExpr *>(expr))
-        return generateFuncCallExpr(callExpr);
-    if (auto *initListExpr = dynamic_cast<InitListExpr *>(expr))
+    switch (expr->getKind())
     {
+    case NodeKind::NumberExpr:
+        return generateNumberExpr(cast<NumberExpr>(expr));
+    case NodeKind::CharExpr:
+        return generateCharExpr(cast<CharExpr>(expr));
+    case NodeKind::StringExpr:
+        return generateStringExpr(cast<StringExpr>(expr));
+    case NodeKind::LValExpr:
+        return generateLValExpr(cast<LValExpr>(expr));
+    case NodeKind::BinaryExpr:
+        return generateBinaryExpr(cast<BinaryExpr>(expr));
+    case NodeKind::UnaryExpr:
+        return generateUnaryExpr(cast<UnaryExpr>(expr));
+    case NodeKind::TernaryExpr:
+        return generateTernaryExpr(cast<TernaryExpr>(expr));
+    case NodeKind::FuncCallExpr:
+        return generateFuncCallExpr(cast<FuncCallExpr>(expr));
+    case NodeKind::InitListExpr:
         error("InitList expression can only be used in variable initialization");
         return nullptr;
+    default:
+        break;
     }
 
     error("Unknown expression type");
@@ -264,7 +321,7 @@ llvm::Value *CodeGenerator::generateStringExpr(StringExpr *expr)
 
 llvm::Value *CodeGenerator::generateLValExpr(LValExpr *expr)
 {
-    SymbolInfo *sym = symbolTable.lookup(expr->getName());
+    SymbolInfo *sym = symbolTable.lookup(expr->getIdentifier());
     if (!sym)
     {
         error("Undeclared variable: " + expr->getName());
@@ -278,7 +335,14 @@ llvm::Value *CodeGenerator::generateLValExpr(LValExpr *expr)
         if (!elemPtr)
             return nullptr;
 
+        // 局部与全局数组按元素的实际类型加载（char 数组为 i8），数组参数的元素按 int 处理
         llvm::Type *elemType = llvm::Type::getInt32Ty(*context);
+        if (!sym->type->isPointerTy())
+        {
+            llvm::Type *indexedType = getArrayElementType(sym->type, expr->getIndices().size(), sym);
+            if (indexedType && !indexedType->isArrayTy())
+                elemType = indexedType;
+        }
 
         // 加载数组元素的值
         return builder->CreateLoad(elemType, elemPtr, "arrayelem");
@@ -291,7 +355,7 @@ llvm::Value *CodeGenerator::generateLValExpr(LValExpr *expr)
     }
     else if (auto *globalVar = llvm::dyn_cast<llvm::GlobalVariable>(sym->allocaInst))
     {
-        return builder->CreateLoad(globalVar->getValueType(), sym->allocaInst, expr->getName());
+        return builder->CreateLoad(sym->type, globalVar, expr->getName());
     }
 
     error("Cannot load value from: " + expr->getName());
@@ -300,13 +364,23 @@ llvm::Value *CodeGenerator::generateLValExpr(LValExpr *expr)
 
 llvm::Value *CodeGenerator::getArrayElementPtr(const LValExpr *lval)
 {
-    SymbolInfo *sym = symbolTable.lookup(lval->getName());
+    SymbolInfo *sym = symbolTable.lookup(lval->getIdentifier());
     if (!sym)
     {
         error("Undeclared variable: " + lval->getName());
         return nullptr;
     }
 
+    llvm::Value *elemPtr = computeArrayElementPtr(lval, sym);
+    if (elemPtr && runtimeChecks)
+    {
+        checkArrayElementPtr(sym, elemPtr);
+    }
+    return elemPtr;
+}
+
+llvm::Value *CodeGenerator::computeArrayElementPtr(const LValExpr *lval, const SymbolInfo *sym)
+{
     // 生成索引值
     std::vector<llvm::Value *> indices;
 
@@ -331,7 +405,7 @@ llvm::Value *CodeGenerator::getArrayElementPtr(const LValExpr *lval)
         }
 
         // 第一个索引：直接访问最外层
-        llvm::Value *firstIndex = generateExpr(const_cast<Expr *>(lval->getIndices()[0].get()));
+        llvm::Value *firstIndex = generateExpr(const_cast<Expr *>(lval->getIndices()[0]));
         if (!firstIndex)
             return nullptr;
 
@@ -363,11 +437,10 @@ llvm::Value *CodeGenerator::getArrayElementPtr(const LValExpr *lval)
         {
             // 多个索引：需要逐层访问
             llvm::Value *currentPtr = basePtr;
-            llvm::Type *currentType = sym->type;
 
             for (size_t i = 0; i < numIndices; ++i)
             {
-                llvm::Value *indexVal = generateExpr(const_cast<Expr *>(lval->getIndices()[i].get()));
+                llvm::Value *indexVal = generateExpr(const_cast<Expr *>(lval->getIndices()[i]));
                 if (!indexVal)
                     return nullptr;
 
@@ -405,7 +478,7 @@ llvm::Value *CodeGenerator::getArrayElementPtr(const LValExpr *lval)
 
         for (const auto &index : lval->getIndices())
         {
-            llvm::Value *indexVal = generateExpr(const_cast<Expr *>(index.get()));
+            llvm::Value *indexVal = generateExpr(const_cast<Expr *>(index));
             if (!indexVal)
                 return nullptr;
             indices.push_back(indexVal);
@@ -419,9 +492,9 @@ llvm::Value *CodeGenerator::getArrayElementPtr(const LValExpr *lval)
 llvm::Value *CodeGenerator::generateBinaryExpr(BinaryExpr *expr)
 {
     // 对于逻辑运算符 && 和 ||，需要短路求值
-    std::string op = expr->getOp();
+    BinaryOp op = expr->getOp();
 
-    if (op == "&&")
+    if (op == BinaryOp::LogicalAnd)
     {
         // 短路求值：左侧为 false 时不计算右侧
         llvm::Value *L = generateExpr(const_cast<Expr *>(expr->getLhs()));
@@ -457,7 +530,7 @@ llvm::Value *CodeGenerator::generateBinaryExpr(BinaryExpr *expr)
         return phi;
     }
 
-    if (op == "||")
+    if (op == BinaryOp::LogicalOr)
     {
         // 短路求值：左侧为 true 时不计算右侧
         llvm::Value *L = generateExpr(const_cast<Expr *>(expr->getLhs()));
@@ -500,45 +573,61 @@ llvm::Value *CodeGenerator::generateBinaryExpr(BinaryExpr *expr)
     if (!L || !R)
         return nullptr;
 
+    switch (op)
+    {
     // 算术运算
-    if (op == "+")
+    case BinaryOp::Add:
         return builder->CreateAdd(L, R, "addtmp");
-    if (op == "-")
+    case BinaryOp::Sub:
         return builder->CreateSub(L, R, "subtmp");
-    if (op == "*")
+    case BinaryOp::Mul:
         return builder->CreateMul(L, R, "multmp");
-    if (op == "/")
-        return builder->CreateSDiv(L, R, "divtmp");
-    if (op == "%")
-        return builder->CreateSRem(L, R, "modtmp");
+    case BinaryOp::Div:
+    case BinaryOp::Mod:
+        if (runtimeChecks)
+        {
+            // 与解释器一致：除数为零报错，INT_MIN / -1 回绕（除数换成 1，商为 INT_MIN、余数为 0）
+            llvm::Type *type = R->getType();
+            emitRuntimeCheck(builder->CreateICmpEQ(R, llvm::ConstantInt::get(type, 0)),
+                             RuntimeCheck::DivisionByZero, builder->getInt64(0));
+            llvm::Value *overflow = builder->CreateAnd(
+                builder->CreateICmpEQ(L, llvm::ConstantInt::get(type, llvm::APInt::getSignedMinValue(type->getIntegerBitWidth()))),
+                builder->CreateICmpEQ(R, llvm::ConstantInt::get(type, -1, true)));
+            R = builder->CreateSelect(overflow, llvm::ConstantInt::get(type, 1), R);
+        }
+        return op == BinaryOp::Div ? builder->CreateSDiv(L, R, "divtmp") : builder->CreateSRem(L, R, "modtmp");
 
     // 比较运算
-    if (op == "<")
+    case BinaryOp::Lt:
         return builder->CreateICmpSLT(L, R, "cmptmp");
-    if (op == ">")
+    case BinaryOp::Gt:
         return builder->CreateICmpSGT(L, R, "cmptmp");
-    if (op == "<=")
+    case BinaryOp::Le:
         return builder->CreateICmpSLE(L, R, "cmptmp");
-    if (op == ">=")
+    case BinaryOp::Ge:
         return builder->CreateICmpSGE(L, R, "cmptmp");
-    if (op == "==")
+    case BinaryOp::Eq:
         return builder->CreateICmpEQ(L, R, "eqtmp");
-    if (op == "!=")
+    case BinaryOp::Ne:
         return builder->CreateICmpNE(L, R, "netmp");
 
     // 位运算
-    if (op == "&")
+    case BinaryOp::BitAnd:
         return builder->CreateAnd(L, R, "bitand");
-    if (op == "|")
+    case BinaryOp::BitOr:
         return builder->CreateOr(L, R, "bitor");
-    if (op == "^")
+    case BinaryOp::BitXor:
         return builder->CreateXor(L, R, "xortmp");
-    if (op == "<<")
+    case BinaryOp::Shl:
         return builder->CreateShl(L, R, "shltmp");
-    if (op == ">>")
+    case BinaryOp::Shr:
         return builder->CreateAShr(L, R, "ashrtmp");
 
-    error("Unknown binary operator: " + op);
+    default:
+        break;
+    }
+
+    error(std::string("Unknown binary operator: ") + getOpSpelling(op));
     return nullptr;
 }
 
@@ -548,30 +637,30 @@ llvm::Value *CodeGenerator::generateUnaryExpr(UnaryExpr *expr)
     if (!operand)
         return nullptr;
 
-    std::string op = expr->getOp();
-
-    if (op == "-")
+    switch (expr->getOp())
+    {
+    case UnaryOp::Minus:
         return builder->CreateNeg(operand, "negtmp");
-    if (op == "!")
+    case UnaryOp::LogicalNot:
     {
         llvm::Value *boolVal = convertToBool(operand);
         if (!boolVal)
             return nullptr;
         return builder->CreateNot(boolVal, "nottmp");
     }
-    if (op == "~")
+    case UnaryOp::BitNot:
         return builder->CreateNot(operand, "bitnot");
-    if (op == "+")
+    case UnaryOp::Plus:
         return operand; // 一元加号不做任何操作
 
     // ++, -- 暂不支持（需要左值）
-    if (op == "++" || op == "--")
-    {
+    case UnaryOp::PreInc:
+    case UnaryOp::PreDec:
         error("Prefix increment/decrement not yet supported");
         return nullptr;
     }
 
-    error("Unknown unary operator: " + op);
+    error(std::string("Unknown unary operator: ") + getOpSpelling(expr->getOp()));
     return nullptr;
 }
 
@@ -642,7 +731,7 @@ llvm::Value *CodeGenerator::generateFuncCallExpr(FuncCallExpr *expr)
     std::vector<llvm::Value *> argsV;
     for (const auto &arg : expr->getArgs())
     {
-        llvm::Value *argVal = generateExpr(arg.get());
+        llvm::Value *argVal = generateExpr(arg);
         if (!argVal)
             return nullptr;
         argsV.push_back(argVal);
@@ -663,7 +752,7 @@ llvm::Value *CodeGenerator::generateInitListExpr(InitListExpr *expr, llvm::Type
     // 这里仅用于标量初始化列表（C99 允许）
     if (expr->getItems().size() == 1)
     {
-        return generateExpr(const_cast<Expr *>(expr->getItems()[0].get()));
+        return generateExpr(const_cast<Expr *>(expr->getItems()[0]));
     }
 
     error("InitList expression used in invalid context");
@@ -671,24 +760,99 @@ llvm::Value *CodeGenerator::generateInitListExpr(InitListExpr *expr, llvm::Type
 }
 
 /* ------------------ Array processing auxiliary functions ------------------ */
-void CodeGenerator::flattenInitList(InitListExpr *initList, std::vector<llvm::Value *> &values)
+// 全零尾部至少有这么多个元素时才拆分（与 clang 相同）
+static constexpr uint64_t ZERO_TAIL_SPLIT_THRESHOLD = 8;
+
+llvm::Constant *CodeGenerator::buildConstantAggregate(llvm::Type *type, const std::vector<llvm::Constant *> &image,
+                                                      size_t base, bool splitZeroTail)
+{
+    // 超出 image 的整段均为零
+    if (base >= image.size())
+    {
+        return llvm::Constant::getNullValue(type);
+    }
+
+    if (auto *arrayType = llvm::dyn_cast<llvm::ArrayType>(type))
+    {
+        llvm::Type *subType = arrayType->getElementType();
+        size_t subSize = 1;
+        for (llvm::Type *t = subType; t->isArrayTy(); t = t->getArrayElementType())
+        {
+            subSize *= t->getArrayNumElements();
+        }
+
+        // 含非零值的元素个数，其后均为零
+        uint64_t numElements = arrayType->getNumElements();
+        uint64_t used = std::min<uint64_t>(numElements, (image.size() - base + subSize - 1) / subSize);
+
+        std::vector<llvm::Constant *> elements;
+        elements.reserve(splitZeroTail ? used : numElements);
+        for (uint64_t i = 0; i < (splitZeroTail ? used : numElements); ++i)
+        {
+            elements.push_back(buildConstantAggregate(subType, image, base + i * subSize));
+        }
+
+        // 布局与原数组相同：前缀数组后紧跟同元素类型的零数组
+        if (splitZeroTail && numElements - used >= ZERO_TAIL_SPLIT_THRESHOLD)
+        {
+            llvm::Constant *head = llvm::ConstantArray::get(llvm::ArrayType::get(subType, used), elements);
+            llvm::Constant *tail = llvm::ConstantAggregateZero::get(llvm::ArrayType::get(subType, numElements - used));
+            return llvm::ConstantStruct::getAnon({head, tail});
+        }
+        while (elements.size() < numElements)
+        {
+            elements.push_back(llvm::Constant::getNullValue(subType));
+        }
+
+        // 元素均为整数常量时 ConstantArray::get 返回紧凑的 ConstantDataArray，全零时返回 zeroinitializer
+        return llvm::ConstantArray::get(arrayType, elements);
+    }
+
+    return image[base];
+}
+
+void CodeGenerator::flattenInitList(InitListExpr *initList, const std::vector<int> &dims, size_t dimIndex,
+                                    int base, std::vector<std::pair<int, llvm::Value *>> &values)
 {
+    int subSize = 1;
+    for (size_t d = dimIndex + 1; d < dims.size(); ++d)
+    {
+        subSize *= dims[d];
+    }
+    int total = dimIndex < dims.size() ? subSize * dims[dimIndex] : 1;
+
+    int cursor = 0;
     for (const auto &item : initList->getItems())
     {
-        if (auto *nestedList = dynamic_cast<InitListExpr *>(item.get()))
+        if (cursor >= total)
+            break;
+
+        Expr *scalar = item;
+        if (auto *nestedList = dyn_cast<InitListExpr>(item))
         {
-            // 递归处理嵌套初始化列表
-            flattenInitList(nestedList, values);
+            if (dimIndex + 1 < dims.size())
+            {
+                // 嵌套列表对齐到下一个子数组的起点
+                cursor = (cursor + subSize - 1) / subSize * subSize;
+                if (cursor >= total)
+                    break;
+                flattenInitList(nestedList, dims, dimIndex + 1, base + cursor, values);
+                cursor += subSize;
+                continue;
+            }
+
+            // 带花括号的标量：取第一个元素
+            scalar = nestedList->getItems().empty() ? nullptr : nestedList->getItems()[0];
         }
-        else
+
+        if (scalar)
         {
-            // 生成表达式值
-            llvm::Value *val = generateExpr(item.get());
-            if (val)
+            if (llvm::Value *val = generateExpr(scalar))
             {
-                values.push_back(val);
+                values.emplace_back(base + cursor, val);
             }
         }
+        cursor++;
     }
 }
 
@@ -698,72 +862,138 @@ void CodeGenerator::initializeArray(llvm::Value *arrayPtr, llvm::Type *arrayType
     if (!initExpr)
         return;
 
-    // 处理初始化列表
-    if (auto *initList = dynamic_cast<InitListExpr *>(initExpr))
+    // 计算数组总大小与最内层元素类型
+    int totalSize = 1;
+    for (int dim : dims)
+    {
+        totalSize *= dim;
+    }
+
+    llvm::Type *elemType = arrayType;
+    while (elemType->isArrayTy())
     {
-        // 展平初始化列表
-        std::vector<llvm::Value *> flatValues;
-        flattenInitList(initList, flatValues);
+        elemType = elemType->getArrayElementType();
+    }
 
-        // 计算数组总大小
-        int totalSize = 1;
-        for (int dim : dims)
-        {
-            totalSize *= dim;
-        }
+    const llvm::DataLayout &layout = module->getDataLayout();
+    uint64_t elemSize = layout.getTypeAllocSize(elemType);
+    llvm::Align elemAlign = layout.getABITypeAlign(elemType);
 
-        // 初始化数组元素
-        for (size_t i = 0; i < flatValues.size() && i < (size_t)totalSize; ++i)
+    // 从私有常量全局 memcpy 到数组开头
+    auto copyFromImage = [&](llvm::Constant *data, uint64_t size, llvm::Align align)
+    {
+        auto *imageVar = new llvm::GlobalVariable(
+            *module, data->getType(), true, llvm::GlobalValue::PrivateLinkage, data,
+            "__const." + currentFunction->getName().str() + "." + arrayPtr->getName().str());
+        imageVar->setUnnamedAddr(llvm::GlobalValue::UnnamedAddr::Global);
+        imageVar->setAlignment(align);
+        builder->CreateMemCpy(arrayPtr, elemAlign, imageVar, align, size);
+    };
+
+    // 把 [from, totalSize) 清零
+    auto zeroTail = [&](uint64_t from)
+    {
+        if (from >= (uint64_t)totalSize)
+            return;
+        llvm::Value *tail = from ? builder->CreateConstInBoundsGEP1_64(elemType, arrayPtr, from, "arrayinit")
+                                 : arrayPtr;
+        builder->CreateMemSet(tail, builder->getInt8(0), (totalSize - from) * elemSize, elemAlign);
+    };
+
+    // 处理初始化列表
+    if (auto *initList = dyn_cast<InitListExpr>(initExpr))
+    {
+        // 按花括号规则展开初始化列表
+        std::vector<std::pair<int, llvm::Value *>> flatValues;
+        flattenInitList(initList, dims, 0, 0, flatValues);
+
+        // 常量部分组成一份镜像（非常量位置先填 0），记录最后一个非零常量之后的位置
+        std::vector<llvm::Constant *> image;
+        size_t prefix = 0;
+        for (auto &[offset, val] : flatValues)
         {
-            // 计算多维索引
-            std::vector<llvm::Value *> indices;
-            indices.push_back(llvm::ConstantInt::get(*context, llvm::APInt(32, 0))); // 基址
+            if (val->getType()->isIntegerTy() && elemType->isIntegerTy())
+            {
+                val = builder->CreateIntCast(val, elemType, true);
+            }
 
-            int remainder = i;
-            for (int d = dims.size() - 1; d >= 0; --d)
+            auto *constVal = llvm::dyn_cast<llvm::Constant>(val);
+            if (constVal && !constVal->isNullValue())
             {
-                int index = remainder % dims[d];
-                remainder /= dims[d];
-                indices.insert(indices.begin() + 1,
-                               llvm::ConstantInt::get(*context, llvm::APInt(32, index)));
+                if (image.size() <= (size_t)offset)
+                {
+                    image.resize(offset + 1, llvm::Constant::getNullValue(elemType));
+                }
+                image[offset] = constVal;
+                prefix = std::max(prefix, (size_t)offset + 1);
             }
+        }
+
+        // 非零常量前缀：从私有常量全局 memcpy，其余部分清零
+        if (prefix > 0)
+        {
+            llvm::ArrayType *imageType = llvm::ArrayType::get(elemType, prefix);
+            copyFromImage(llvm::ConstantArray::get(imageType, image), prefix * elemSize, elemAlign);
+        }
+        zeroTail(prefix);
 
-            // 获取元素指针并存储值
-            llvm::Value *elemPtr = builder->CreateGEP(arrayType, arrayPtr, indices, "arrayinit");
-            builder->CreateStore(flatValues[i], elemPtr);
+        // 只为非常量元素生成 store
+        for (const auto &[offset, val] : flatValues)
+        {
+            if (llvm::isa<llvm::Constant>(val))
+                continue;
+
+            llvm::Value *elemPtr = builder->CreateConstInBoundsGEP1_64(elemType, arrayPtr, offset, "arrayinit");
+            builder->CreateStore(val, elemPtr);
         }
     }
+    else if (auto *str = dyn_cast<StringExpr>(initExpr); str && elemType->isIntegerTy(8))
+    {
+        // 字符数组的字符串初始化：从字符串常量 memcpy（按数组长度截断，放得下时连同结尾的 '\0'），其余部分清零
+        const std::string &value = str->getValue();
+        uint64_t copied = std::min<uint64_t>(value.size() + 1, totalSize);
+        llvm::Constant *data = llvm::ConstantDataArray::getString(
+            *context, llvm::StringRef(value).take_front(copied), copied > value.size());
+        copyFromImage(data, copied, llvm::Align(1));
+        zeroTail(copied);
+    }
     else
     {
-        // 单个值初始化（标量初始化所有元素）
+        // 单个值初始化所有元素
         llvm::Value *val = generateExpr(initExpr);
         if (!val)
             return;
-
-        // 计算数组总大小
-        int totalSize = 1;
-        for (int dim : dims)
+        if (val->getType()->isIntegerTy() && elemType->isIntegerTy())
         {
-            totalSize *= dim;
+            val = builder->CreateIntCast(val, elemType, true);
         }
-
-        // 用同一个值初始化所有元素
-        for (int i = 0; i < totalSize; ++i)
+        if (val->getType() != elemType)
         {
-            // 计算多维索引
-            std::vector<llvm::Value *> indices;
-            indices.push_back(llvm::ConstantInt::get(*context, llvm::APInt(32, 0)));
+            error("Array initializer must be an initializer list: " + arrayPtr->getName().str());
+            return;
+        }
 
-            int remainder = i;
-            for (int d = dims.size() - 1; d >= 0; --d)
+        if (auto *constVal = llvm::dyn_cast<llvm::Constant>(val))
+        {
+            // 零值与单字节元素直接 memset，其余从填满该值的常量镜像 memcpy
+            if (constVal->isNullValue() || elemSize == 1)
             {
-                int index = remainder % dims[d];
-                remainder /= dims[d];
-                indices.insert(indices.begin() + 1,
-                               llvm::ConstantInt::get(*context, llvm::APInt(32, index)));
+                llvm::Value *byte = constVal->isNullValue() ? builder->getInt8(0) : val;
+                builder->CreateMemSet(arrayPtr, byte, totalSize * elemSize, elemAlign);
             }
+            else
+            {
+                llvm::ArrayType *imageType = llvm::ArrayType::get(elemType, totalSize);
+                std::vector<llvm::Constant *> image(totalSize, constVal);
+                copyFromImage(llvm::ConstantArray::get(imageType, image), totalSize * elemSize, elemAlign);
+            }
+            return;
+        }
 
-            llvm::Value *elemPtr = builder->CreateGEP(arrayType, arrayPtr, indices, "arrayinit");
+        // 非常量值逐个元素写入
+        for (int i = 0; i < totalSize; ++i)
+        {
+            llvm::Value *elemPtr = builder->CreateConstInBoundsGEP1_64(elemType, arrayPtr, i, "arrayinit");
             builder->CreateStore(val, elemPtr);
         }
     }
@@ -775,24 +1005,29 @@ void CodeGenerator::generateStmt(Stmt *stmt)
     if (!stmt)
         return;
 
-    if (auto *exprStmt = dynamic_cast<ExprStmt *>(stmt))
-        return generateExprStmt(exprStmt);
-    if (auto *assignStmt = dynamic_cast<AssignStmt *>(stmt))
-        return generateAssignStmt(assignStmt);
-    if (auto *blockStmt = dynamic_cast<BlockStmt *>(stmt))
-        return generateBlockStmt(blockStmt);
-    if (auto *ifStmt = dynamic_cast<IfStmt *>(stmt))
-        return generateIfStmt(ifStmt);
-    if (auto *whileStmt = dynamic_cast<WhileStmt *>(stmt))
-        return generateWhileStmt(whileStmt);
-    if (auto *forStmt = dynamic_cast<ForStmt *>(stmt))
-        return generateForStmt(forStmt);
-    if (auto *retStmt = dynamic_cast<ReturnStmt *>(stmt))
-        return generateReturnStmt(retStmt);
-    if (auto *breakStmt = dynamic_cast<BreakStmt *>(stmt))
-        return generateBreakStmt(breakStmt);
-    if (auto *contStmt = dynamic_cast<ContinueStmt *>(stmt))
-        return generateContinueStmt(contStmt);
+    switch (stmt->getKind())
+    {
+    case NodeKind::ExprStmt:
+        return generateExprStmt(cast<ExprStmt>(stmt));
+    case NodeKind::AssignStmt:
+        return generateAssignStmt(cast<AssignStmt>(stmt));
+    case NodeKind::BlockStmt:
+        return generateBlockStmt(cast<BlockStmt>(stmt));
+    case NodeKind::IfStmt:
+        return generateIfStmt(cast<IfStmt>(stmt));
+    case NodeKind::WhileStmt:
+        return generateWhileStmt(cast<WhileStmt>(stmt));
+    case NodeKind::ForStmt:
+        return generateForStmt(cast<ForStmt>(stmt));
+    case NodeKind::ReturnStmt:
+        return generateReturnStmt(cast<ReturnStmt>(stmt));
+    case NodeKind::BreakStmt:
+        return generateBreakStmt(cast<BreakStmt>(stmt));
+    case NodeKind::ContinueStmt:
+        return generateContinueStmt(cast<ContinueStmt>(stmt));
+    default:
+        break;
+    }
 
     error("Unknown statement type");
 }
@@ -808,7 +1043,7 @@ void CodeGenerator::generateExprStmt(ExprStmt *stmt)
 void CodeGenerator::generateAssignStmt(AssignStmt *stmt)
 {
     const LValExpr *lval = stmt->getLhs();
-    SymbolInfo *sym = symbolTable.lookup(lval->getName());
+    SymbolInfo *sym = symbolTable.lookup(lval->getIdentifier());
     if (!sym)
     {
         error("Undeclared variable: " + lval->getName());
@@ -853,11 +1088,11 @@ void CodeGenerator::generateBlockStmt(BlockStmt *stmt)
             break; // 不再生成后续代码（dead code）
         }
 
-        if (auto *decl = dynamic_cast<Decl *>(item.get()))
+        if (auto *decl = dyn_cast<Decl>(item))
         {
             generateDecl(decl);
         }
-        else if (auto *s = dynamic_cast<Stmt *>(item.get()))
+        else if (auto *s = dyn_cast<Stmt>(item))
         {
             generateStmt(s);
         }
@@ -963,11 +1198,11 @@ void CodeGenerator::generateForStmt(ForStmt *stmt)
     // 初始化
     if (stmt->getInit())
     {
-        if (auto *decl = dynamic_cast<Decl *>(const_cast<ASTNode *>(stmt->getInit())))
+        if (auto *decl = dyn_cast<Decl>(const_cast<ASTNode *>(stmt->getInit())))
         {
             generateDecl(decl);
         }
-        else if (auto *s = dynamic_cast<Stmt *>(const_cast<ASTNode *>(stmt->getInit())))
+        else if (auto *s = dyn_cast<Stmt>(const_cast<ASTNode *>(stmt->getInit())))
         {
             generateStmt(s);
         }
@@ -1022,7 +1257,7 @@ void CodeGenerator::generateForStmt(ForStmt *stmt)
     builder->SetInsertPoint(stepBB);
     if (stmt->getStep())
     {
-        if (auto *s = dynamic_cast<Stmt *>(const_cast<ASTNode *>(stmt->getStep())))
+        if (auto *s = dyn_cast<Stmt>(const_cast<ASTNode *>(stmt->getStep())))
         {
             generateStmt(s);
         }
@@ -1083,7 +1318,7 @@ void CodeGenerator::generateContinueStmt(ContinueStmt * /*stmt*/)
 
 void CodeGenerator::generateDecl(Decl *decl)
 {
-    if (auto *varDecl = dynamic_cast<VarDecl *>(decl))
+    if (auto *varDecl = dyn_cast<VarDecl>(decl))
     {
         generateVarDecl(varDecl);
     }
@@ -1109,7 +1344,7 @@ void CodeGenerator::generateVarDecl(VarDecl *decl)
             // 提取维度值
             for (const auto &dim : varDef->getDims())
             {
-                if (auto *numExpr = dynamic_cast<NumberExpr *>(dim.get()))
+                if (auto *numExpr = dyn_cast<NumberExpr>(dim))
                 {
                     arrayDims.push_back(numExpr->getValue());
                 }
@@ -1123,11 +1358,11 @@ void CodeGenerator::generateVarDecl(VarDecl *decl)
 
         if (isGlobal)
         {
-            generateGlobalVar(decl, varDef.get(), type);
+            generateGlobalVar(decl, varDef, type);
         }
         else
         {
-            generateLocalVar(decl, varDef.get(), type);
+            generateLocalVar(decl, varDef, type);
         }
     }
 }
@@ -1137,8 +1372,12 @@ void CodeGenerator::generateGlobalVar(VarDecl *decl, VarDef *varDef, llvm::Type
     const std::string &name = varDef->getName();
     llvm::Constant *initVal = nullptr;
 
-    // 全局变量初始化
-    if (varDef->getInit())
+    // 全局变量初始化（外部声明没有初始值，存储由调用方或其他模块提供）
+    if (externalGlobals)
+    {
+        initVal = nullptr;
+    }
+    else if (varDef->getInit())
     {
         if (varDef->getDims().empty())
         {
@@ -1156,9 +1395,79 @@ void CodeGenerator::generateGlobalVar(VarDecl *decl, VarDef *varDef, llvm::Type
         }
         else
         {
-            // 数组全局变量初始化（简化处理：使用零初始化）
-            initVal = llvm::Constant::getNullValue(type);
-            // TODO: 支持全局数组的完整初始化列表
+            // 数组全局变量：初始化折叠为常量聚合，放入数据段而非运行时初始化
+            std::vector<int> arrayDims;
+            for (const auto &dim : varDef->getDims())
+            {
+                if (auto *numExpr = dyn_cast<NumberExpr>(dim))
+                {
+                    arrayDims.push_back(numExpr->getValue());
+                }
+            }
+
+            llvm::Type *elemType = type;
+            while (elemType->isArrayTy())
+            {
+                elemType = elemType->getArrayElementType();
+            }
+
+            std::vector<llvm::Constant *> image;
+            Expr *init = const_cast<Expr *>(varDef->getInit());
+            if (auto *initList = dyn_cast<InitListExpr>(init))
+            {
+                std::vector<std::pair<int, llvm::Value *>> flatValues;
+                flattenInitList(initList, arrayDims, 0, 0, flatValues);
+
+                for (const auto &[offset, val] : flatValues)
+                {
+                    auto *constVal = llvm::dyn_cast<llvm::Constant>(val);
+                    if (!constVal)
+                    {
+                        error("Global variable initializer must be constant: " + name);
+                        continue;
+                    }
+                    if (constVal->getType() != elemType && constVal->getType()->isIntegerTy() && elemType->isIntegerTy())
+                    {
+                        constVal = llvm::cast<llvm::Constant>(builder->CreateIntCast(constVal, elemType, true));
+                    }
+                    if (constVal->isNullValue())
+                        continue;
+
+                    if (image.size() <= (size_t)offset)
+                    {
+                        image.resize(offset + 1, llvm::Constant::getNullValue(elemType));
+                    }
+                    image[offset] = constVal;
+                }
+            }
+            else if (auto *str = dyn_cast<StringExpr>(init); str && elemType->isIntegerTy(8))
+            {
+                // 字符数组的字符串初始化：按声明长度截断，其后补零（与字节码编译器相同）
+                size_t totalSize = 1;
+                for (int dim : arrayDims)
+                {
+                    totalSize *= dim;
+                }
+                // 全为 '\0' 的字符串得到 zeroinitializer 而不是 ConstantDataArray
+                if (auto *data = llvm::dyn_cast<llvm::ConstantDataArray>(
+                        llvm::ConstantDataArray::getString(*context, str->getValue())))
+                {
+                    for (size_t i = 0; i < data->getNumElements() && i < totalSize; ++i)
+                    {
+                        image.push_back(data->getElementAsConstant(i));
+                    }
+                }
+                while (!image.empty() && image.back()->isNullValue())
+                {
+                    image.pop_back();
+                }
+            }
+            else
+            {
+                error("Array initializer must be an initializer list: " + name);
+            }
+
+            initVal = buildConstantAggregate(type, image, 0, true);
         }
     }
     else
@@ -1167,10 +1476,10 @@ void CodeGenerator::generateGlobalVar(VarDecl *decl, VarDef *varDef, llvm::Type
         initVal = llvm::Constant::getNullValue(type);
     }
 
-    // 创建全局变量
+    // 创建全局变量（拆分零尾部的初始值类型与声明类型不同，但内存布局一致）
     auto *globalVar = new llvm::GlobalVariable(
         *module,
-        type,
+        initVal ? initVal->getType() : type,
         decl->getType().isConst, // isConstant
         llvm::GlobalValue::ExternalLinkage,
         initVal,
@@ -1188,7 +1497,7 @@ void CodeGenerator::generateGlobalVar(VarDecl *decl, VarDef *varDef, llvm::Type
     // 保存数组维度信息
     for (const auto &dim : varDef->getDims())
     {
-        if (auto *numExpr = dynamic_cast<NumberExpr *>(dim.get()))
+        if (auto *numExpr = dyn_cast<NumberExpr>(dim))
         {
             info.arrayDims.push_back(numExpr->getValue());
         }
@@ -1198,7 +1507,7 @@ void CodeGenerator::generateGlobalVar(VarDecl *decl, VarDef *varDef, llvm::Type
         }
     }
 
-    if (!symbolTable.declare(name, info))
+    if (!symbolTable.declare(varDef->getIdentifier(), std::move(info)))
     {
         error("Redeclaration of variable: " + name);
     }
@@ -1208,8 +1517,8 @@ void CodeGenerator::generateLocalVar(VarDecl *decl, VarDef *varDef, llvm::Type *
 {
     const std::string &name = varDef->getName();
 
-    // 创建局部变量
-    llvm::AllocaInst *alloca = builder->CreateAlloca(type, nullptr, name);
+    // 创建局部变量（分配在入口块，初始化仍在声明处）
+    llvm::AllocaInst *alloca = createEntryBlockAlloca(type, name);
 
     // 变量初始化
     if (varDef->getInit())
@@ -1217,12 +1526,12 @@ void CodeGenerator::generateLocalVar(VarDecl *decl, VarDef *varDef, llvm::Type *
         if (varDef->getDims().empty())
         {
             // 标量变量初始化
-            if (auto *initList = dynamic_cast<InitListExpr *>(const_cast<Expr *>(varDef->getInit())))
+            if (auto *initList = dyn_cast_or_null<InitListExpr>(const_cast<Expr *>(varDef->getInit())))
             {
                 // 初始化列表（对标量变量，取第一个元素）
                 if (!initList->getItems().empty())
                 {
-                    llvm::Value *initVal = generateExpr(initList->getItems()[0].get());
+                    llvm::Value *initVal = generateExpr(initList->getItems()[0]);
                     if (initVal)
                     {
                         builder->CreateStore(initVal, alloca);
@@ -1245,7 +1554,7 @@ void CodeGenerator::generateLocalVar(VarDecl *decl, VarDef *varDef, llvm::Type *
             std::vector<int> arrayDims;
             for (const auto &dim : varDef->getDims())
             {
-                if (auto *numExpr = dynamic_cast<NumberExpr *>(dim.get()))
+                if (auto *numExpr = dyn_cast<NumberExpr>(dim))
                 {
                     arrayDims.push_back(numExpr->getValue());
                 }
@@ -1268,7 +1577,7 @@ void CodeGenerator::generateLocalVar(VarDecl *decl, VarDef *varDef, llvm::Type *
     // 保存数组维度信息
     for (const auto &dim : varDef->getDims())
     {
-        if (auto *numExpr = dynamic_cast<NumberExpr *>(dim.get()))
+        if (auto *numExpr = dyn_cast<NumberExpr>(dim))
         {
             info.arrayDims.push_back(numExpr->getValue());
         }
@@ -1278,7 +1587,7 @@ void CodeGenerator::generateLocalVar(VarDecl *decl, VarDef *varDef, llvm::Type *
         }
     }
 
-    if (!symbolTable.declare(name, info))
+    if (!symbolTable.declare(varDef->getIdentifier(), std::move(info)))
     {
         error("Redeclaration of variable: " + name);
     }
@@ -1286,8 +1595,14 @@ void CodeGenerator::generateLocalVar(VarDecl *decl, VarDef *varDef, llvm::Type *
 
 /* ------------------- Function definition code generation ------------------ */
 
-llvm::Function *CodeGenerator::generateFuncDef(FuncDef *funcDef)
+llvm::Function *CodeGenerator::declareFunction(FuncDef *funcDef)
 {
+    // 已声明（如并行生成时预先声明的原型）则直接复用
+    if (llvm::Function *existing = module->getFunction(funcDef->getName()))
+    {
+        return existing;
+    }
+
     // 函数返回类型
     llvm::Type *retType = getLLVMType(funcDef->getReturnType());
 
@@ -1321,7 +1636,7 @@ llvm::Function *CodeGenerator::generateFuncDef(FuncDef *funcDef)
     funcInfo.isConst = false;
     funcInfo.isGlobal = true;
     funcInfo.isFunction = true;
-    symbolTable.declare(funcDef->getName(), funcInfo);
+    symbolTable.declare(funcDef->getIdentifier(), std::move(funcInfo));
 
     // 设置参数名称
     size_t idx = 0;
@@ -1331,6 +1646,19 @@ llvm::Function *CodeGenerator::generateFuncDef(FuncDef *funcDef)
         idx++;
     }
 
+    return func;
+}
+
+llvm::Function *CodeGenerator::generateFuncDef(FuncDef *funcDef)
+{
+    llvm::Function *func = declareFunction(funcDef);
+    if (!func->empty())
+    {
+        error("Redefinition of function: " + funcDef->getName());
+        return nullptr;
+    }
+    llvm::Type *retType = func->getReturnType();
+
     // 创建函数入口基本块
     llvm::BasicBlock *BB = llvm::BasicBlock::Create(*context, "entry", func);
     builder->SetInsertPoint(BB);
@@ -1338,6 +1666,8 @@ llvm::Function *CodeGenerator::generateFuncDef(FuncDef *funcDef)
     // 进入新作用域
     symbolTable.enterScope();
     currentFunction = func;
+    lastEntryAlloca = nullptr;
+    currentFunctionName = nullptr;
 
     // 为参数创建 alloca 并存储
     generateFuncParams(func, funcDef->getParams());
@@ -1354,6 +1684,7 @@ llvm::Function *CodeGenerator::generateFuncDef(FuncDef *funcDef)
     // 退出作用域
     symbolTable.exitScope();
     currentFunction = nullptr;
+    lastEntryAlloca = nullptr;
 
     // 验证函数
     if (llvm::verifyFunction(*func, &llvm::errs()))
@@ -1367,12 +1698,12 @@ llvm::Function *CodeGenerator::generateFuncDef(FuncDef *funcDef)
 }
 
 void CodeGenerator::generateFuncParams(llvm::Function *func,
-                                       const std::vector<std::unique_ptr<FuncParam>> &params)
+                                       const ASTList<FuncParam *> &params)
 {
     size_t idx = 0;
     for (auto &arg : func->args())
     {
-        llvm::AllocaInst *alloca = builder->CreateAlloca(arg.getType(), nullptr, arg.getName());
+        llvm::AllocaInst *alloca = createEntryBlockAlloca(arg.getType(), std::string(arg.getName()));
         builder->CreateStore(&arg, alloca);
 
         // 注册到符号表
@@ -1385,7 +1716,7 @@ void CodeGenerator::generateFuncParams(llvm::Function *func,
         paramInfo.isFunction = false;
 
         // 保存数组参数的维度信息
-        const FuncParam *param = params[idx].get();
+        const FuncParam *param = params[idx];
         if (param->getIsArray())
         {
             const auto &arrayDims = param->getDims();
@@ -1399,7 +1730,7 @@ void CodeGenerator::generateFuncParams(llvm::Function *func,
                 if (dimExpr)
                 {
                     // 如果是常量表达式，计算其值
-                    if (auto *numExpr = dynamic_cast<NumberExpr *>(dimExpr.get()))
+                    if (auto *numExpr = dyn_cast<NumberExpr>(dimExpr))
                     {
                         paramInfo.arrayDims.push_back(numExpr->getValue());
                     }
@@ -1417,21 +1748,85 @@ void CodeGenerator::generateFuncParams(llvm::Function *func,
             }
         }
 
-        symbolTable.declare(std::string(arg.getName()), paramInfo);
+        symbolTable.declare(param->getIdentifier(), std::move(paramInfo));
         idx++;
     }
 }
 
+/* ----------------------------- Runtime checks ----------------------------- */
+void CodeGenerator::emitRuntimeCheck(llvm::Value *failed, RuntimeCheck kind, llvm::Value *value)
+{
+    llvm::Function *func = builder->GetInsertBlock()->getParent();
+    if (!currentFunctionName)
+    {
+        currentFunctionName = builder->CreateGlobalStringPtr(func->getName(), ".fname");
+    }
+
+    llvm::FunctionCallee handler = module->getOrInsertFunction(
+        "__cinterp_runtime_error",
+        llvm::FunctionType::get(builder->getVoidTy(),
+                                {builder->getInt32Ty(), currentFunctionName->getType(), builder->getInt64Ty()}, false));
+    if (auto *handlerFunc = llvm::dyn_cast<llvm::Function>(handler.getCallee()))
+    {
+        handlerFunc->setDoesNotReturn();
+        handlerFunc->addFnAttr(llvm::Attribute::Cold);
+    }
+
+    llvm::BasicBlock *failBB = llvm::BasicBlock::Create(*context, "check.fail", func);
+    llvm::BasicBlock *okBB = llvm::BasicBlock::Create(*context, "check.ok", func);
+    builder->CreateCondBr(failed, failBB, okBB);
+
+    builder->SetInsertPoint(failBB);
+    builder->CreateCall(handler, {builder->getInt32(static_cast<int32_t>(kind)), currentFunctionName, value});
+    builder->CreateUnreachable();
+
+    builder->SetInsertPoint(okBB);
+}
+
+void CodeGenerator::checkArrayElementPtr(const SymbolInfo *sym, llvm::Value *elemPtr)
+{
+    llvm::Type *int64Ty = builder->getInt64Ty();
+    llvm::Value *addr = builder->CreatePtrToInt(elemPtr, int64Ty);
+
+    // 局部数组在本地栈上，只能按自身大小检查
+    if (!sym->type->isPointerTy() && llvm::isa<llvm::AllocaInst>(sym->allocaInst))
+    {
+        llvm::Type *elemType = sym->type;
+        while (elemType->isArrayTy())
+            elemType = elemType->getArrayElementType();
+
+        const llvm::DataLayout &layout = module->getDataLayout();
+        llvm::Value *offset = builder->CreateSub(addr, builder->CreatePtrToInt(sym->allocaInst, int64Ty));
+        llvm::Value *size = builder->getInt64(layout.getTypeAllocSize(sym->type));
+        emitRuntimeCheck(builder->CreateICmpUGE(offset, size), RuntimeCheck::ArrayAccess,
+                         builder->CreateSDiv(offset, builder->getInt64(layout.getTypeAllocSize(elemType))));
+        return;
+    }
+
+    // 全局数组与数组参数位于调用方提供的内存中，与解释器一样按整块内存检查
+    llvm::Type *ptrTy = llvm::PointerType::get(*context, 0);
+    llvm::Value *begin = builder->CreatePtrToInt(
+        builder->CreateLoad(ptrTy, module->getOrInsertGlobal("__cinterp_memory_begin", ptrTy)), int64Ty);
+    llvm::Value *end = builder->CreatePtrToInt(
+        builder->CreateLoad(ptrTy, module->getOrInsertGlobal("__cinterp_memory_end", ptrTy)), int64Ty);
+    llvm::Value *offset = builder->CreateSub(addr, begin);
+    emitRuntimeCheck(builder->CreateICmpUGE(offset, builder->CreateSub(end, begin)), RuntimeCheck::MemoryAccess,
+                     builder->CreateAShr(offset, 2));
+}
+
 /* --------------------- Top-level generation functions --------------------- */
 bool CodeGenerator::generate(CompUnit *compUnit)
 {
+    // 先折叠常量：数组维度、全局初始化等需要字面量
+    foldConstants(compUnit);
+
     for (const auto &unit : compUnit->getUnits())
     {
-        if (auto *funcDef = dynamic_cast<FuncDef *>(unit.get()))
+        if (auto *funcDef = dyn_cast<FuncDef>(unit))
         {
             generateFuncDef(funcDef);
         }
-        else if (auto *decl = dynamic_cast<Decl *>(unit.get()))
+        else if (auto *decl = dyn_cast<Decl>(unit))
         {
             generateDecl(decl);
         }
@@ -1447,6 +1842,37 @@ bool CodeGenerator::generate(CompUnit *compUnit)
     return !hasErrors;
 }
 
+bool CodeGenerator::generateFunctions(CompUnit *compUnit, const std::set<const FuncDef *> &selected)
+{
+    externalGlobals = true;
+
+    for (const auto &unit : compUnit->getUnits())
+    {
+        if (auto *funcDef = dyn_cast<FuncDef>(unit))
+        {
+            if (selected.count(funcDef))
+            {
+                generateFuncDef(funcDef);
+            }
+        }
+        else if (auto *decl = dyn_cast<Decl>(unit))
+        {
+            generateDecl(decl);
+        }
+    }
+
+    externalGlobals = false;
+
+    // 验证模块
+    if (llvm::verifyModule(*module, &llvm::errs()))
+    {
+        error("Module verification failed");
+        return false;
+    }
+
+    return !hasErrors;
+}
+
 /* --------------------------- IR output function --------------------------- */
 std::string CodeGenerator::getIRString()
 {
@@ -1470,3 +1896,42 @@ bool CodeGenerator::writeIRToFile(const std::string &filename)
     module->print(file, nullptr);
     return true;
 }
+
+/* ------------------------- Bitcode input / output ------------------------- */
+bool CodeGenerator::writeBitcodeToFile(const std::string &filename)
+{
+    std::error_code EC;
+    llvm::raw_fd_ostream file(filename, EC, llvm::sys::fs::OF_None);
+
+    if (EC)
+    {
+        error("Cannot open file: " + filename);
+        return false;
+    }
+
+    llvm::WriteBitcodeToFile(*module, file);
+    return true;
+}
+
+bool CodeGenerator::loadBitcodeFile(const std::string &filename)
+{
+    auto buffer = llvm::MemoryBuffer::getFile(filename);
+    if (!buffer)
+    {
+        error("Cannot open file: " + filename);
+        return false;
+    }
+
+    auto loaded = llvm::parseBitcodeFile((*buffer)->getMemBufferRef(), *context);
+    if (!loaded)
+    {
+        error("Cannot read bitcode " + filename + ": " + llvm::toString(loaded.takeError()));
+        return false;
+    }
+
+    // 缓存按源码内容命中，模块名沿用本次编译的文件名
+    (*loaded)->setModuleIdentifier(module->getModuleIdentifier());
+    (*loaded)->setSourceFileName(module->getSourceFileName());
+    module = std::move(*loaded);
+    return true;
+}
@@ -0,0 +1,120 @@
+#include "semantic.h"
+#include <llvm/ADT/StringMap.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/MC/TargetRegistry.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Program.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/TargetParser/Host.h>
+
+/* -------------------------------------------------------------------------- */
+/*                               Native emission                              */
+/* -------------------------------------------------------------------------- */
+
+bool CodeGenerator::initializeTarget(const std::string &cpu)
+{
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+
+    std::string triple = llvm::sys::getDefaultTargetTriple();
+    std::string lookupError;
+    const llvm::Target *target = llvm::TargetRegistry::lookupTarget(triple, lookupError);
+    if (!target)
+    {
+        error("Cannot find target for " + triple + ": " + lookupError);
+        return false;
+    }
+
+    // -mcpu=native：本机 CPU 名称加上检测到的特性
+    std::string cpuName = cpu.empty() ? "generic" : cpu;
+    std::string features;
+    if (cpu == "native")
+    {
+        cpuName = llvm::sys::getHostCPUName().str();
+
+        llvm::StringMap<bool> hostFeatures;
+        if (llvm::sys::getHostCPUFeatures(hostFeatures))
+        {
+            for (const auto &feature : hostFeatures)
+            {
+                if (!features.empty())
+                    features += ",";
+                features += (feature.getValue() ? "+" : "-") + feature.getKey().str();
+            }
+        }
+    }
+
+    // 生成位置无关代码，以便与系统默认的 PIE 可执行文件链接
+    targetMachine.reset(target->createTargetMachine(triple, cpuName, features, llvm::TargetOptions(),
+                                                    llvm::Reloc::PIC_));
+    if (!targetMachine)
+    {
+        error("Cannot create target machine for " + triple + " (cpu " + cpuName + ")");
+        return false;
+    }
+
+    module->setTargetTriple(triple);
+    module->setDataLayout(targetMachine->createDataLayout());
+    return true;
+}
+
+bool CodeGenerator::emitObjectFile(const std::string &filename)
+{
+    if (!targetMachine && !initializeTarget())
+        return false;
+
+    std::error_code EC;
+    llvm::raw_fd_ostream file(filename, EC, llvm::sys::fs::OF_None);
+    if (EC)
+    {
+        error("Cannot open file: " + filename);
+        return false;
+    }
+
+    llvm::legacy::PassManager codegenPasses;
+    if (targetMachine->addPassesToEmitFile(codegenPasses, file, nullptr, llvm::CodeGenFileType::ObjectFile))
+    {
+        error("Target cannot emit object files");
+        return false;
+    }
+
+    codegenPasses.run(*module);
+    file.flush();
+    return true;
+}
+
+bool CodeGenerator::emitExecutable(const std::string &filename)
+{
+    // 目标文件写到临时文件，链接后删除
+    llvm::SmallString<128> objectPath;
+    if (llvm::sys::fs::createTemporaryFile("cinterp", "o", objectPath))
+    {
+        error("Cannot create temporary object file");
+        return false;
+    }
+
+    bool ok = emitObjectFile(objectPath.str().str()) && linkExecutable(objectPath.str().str(), filename);
+    llvm::sys::fs::remove(objectPath);
+    return ok;
+}
+
+bool CodeGenerator::linkExecutable(const std::string &objectFile, const std::string &filename)
+{
+    // 由 cc 提供启动代码（crt）与 libc，生成的 main 直接作为程序入口
+    auto linker = llvm::sys::findProgramByName("cc");
+    if (!linker)
+    {
+        error("Cannot find the system C compiler (cc) to link " + filename);
+        return false;
+    }
+
+    llvm::StringRef args[] = {*linker, objectFile, "-o", filename};
+    std::string linkError;
+    if (llvm::sys::ExecuteAndWait(*linker, args, {}, {}, 0, 0, &linkError) != 0)
+    {
+        error("Linking " + filename + " failed" + (linkError.empty() ? "" : ": " + linkError));
+        return false;
+    }
+    return true;
+}
@@ -1,9 +1,7 @@
-#include "semantic.h.old"
+#include "semantic.h"
 #include "parser.h"
 #include "lexer.h"
 #include <iostream>
-#include <fstream>
-#include <sstream>
 
 int main(int argc, char *argv[])
 {
@@ -16,7 +14,8 @@ int main(int argc, char *argv[])
         return 1;
     }
 
-    std::string source;
+    SourceManager sources;
+    std::string_view source;
     std::string filename;
 
     if (std::string(argv[1]) == "--test")
@@ -24,6 +23,10 @@ int main(int argc, char *argv[])
         // 内置测试代码
         filename = "test.c";
         source = R"(
+const int N = 4;
+const int SIZE = N * 2;
+int table[SIZE] = {1, 2, 3};
+
 int add(int a, int b) {
     return a + b;
 }
@@ -40,6 +43,8 @@ int main() {
     int y = 10;
     int sum = add(x, y);
     int fact = factorial(5);
+    int buf[N];
+    buf[N - 1] = table[SIZE - 6];
     
     return 0;
 }
@@ -49,16 +54,13 @@ int main() {
     {
         // 从文件读取
         filename = argv[1];
-        std::ifstream file(filename);
-        if (!file)
+        const SourceBuffer *buffer = sources.load(filename);
+        if (!buffer)
         {
-            std::cerr << "Error: Cannot open file '" << filename << "'" << std::endl;
+            std::cerr << "Error: " << sources.getError() << std::endl;
             return 1;
         }
-
-        std::stringstream buffer;
-        buffer << file.rdbuf();
-        source = buffer.str();
+        source = buffer->text();
     }
 
     std::cout << "=== Parsing " << filename << " ===" << std::endl;
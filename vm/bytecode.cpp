@@ -0,0 +1,1145 @@
+#include "bytecode.h"
+#include "const_fold.h"
+#include <iostream>
+#include <sstream>
+
+/* -------------------------------------------------------------------------- */
+/*                              Instruction set                               */
+/* -------------------------------------------------------------------------- */
+
+static const char *const opcodeNames[] = {
+    "MOV", "LOADI", "GETG", "SETG", "LEA", "LOAD", "STORE", "FILL",
+    "ADD", "SUB", "MUL", "DIV", "MOD", "AND", "OR", "XOR", "SHL", "SHR", "ADDI",
+    "EQ", "NE", "LT", "LE", "GT", "GE",
+    "NEG", "NOT", "BNOT", "BOOL", "SEXT8",
+    "JMP", "JMPF", "JMPT", "CALL", "RET", "RETV"};
+
+static_assert(sizeof(opcodeNames) / sizeof(opcodeNames[0]) == static_cast<size_t>(OpCode::NUM_OPCODES),
+              "opcodeNames must match OpCode");
+static_assert(sizeof(Instruction) == 8, "Instruction must stay 8 bytes");
+
+const char *opcodeName(OpCode op)
+{
+    if (op >= OpCode::NUM_OPCODES)
+        return "???";
+    return opcodeNames[static_cast<size_t>(op)];
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                  Program                                   */
+/* -------------------------------------------------------------------------- */
+
+int Program::findFunction(const std::string &name) const
+{
+    for (size_t i = 0; i < functions.size(); ++i)
+    {
+        if (functions[i].name == name)
+            return static_cast<int>(i);
+    }
+    return -1;
+}
+
+std::string Program::disassemble() const
+{
+    std::ostringstream os;
+    os << "globals: " << globals.size() << " cells\n";
+
+    for (const auto &func : functions)
+    {
+        os << "\nfunction " << func.name << " (params=" << func.numParams
+           << ", regs=" << func.numRegs << ", frame=" << func.frameSize << ")\n";
+
+        for (size_t pc = 0; pc < func.code.size(); ++pc)
+        {
+            const Instruction &ins = func.code[pc];
+            os << "  " << pc << "\t" << opcodeName(ins.op) << "\t";
+
+            switch (ins.op)
+            {
+            case OpCode::LOADI:
+            case OpCode::GETG:
+            case OpCode::SETG:
+            case OpCode::LEA:
+                os << "r" << ins.a << ", " << ins.imm();
+                break;
+            case OpCode::ADDI:
+                os << "r" << ins.a << ", r" << ins.b << ", " << ins.sc();
+                break;
+            case OpCode::JMP:
+                os << "-> " << static_cast<long>(pc) + 1 + ins.imm();
+                break;
+            case OpCode::JMPF:
+            case OpCode::JMPT:
+                os << "r" << ins.a << " -> " << static_cast<long>(pc) + 1 + ins.imm();
+                break;
+            case OpCode::CALL:
+                os << "r" << ins.a << ", r" << ins.b << ", "
+                   << (ins.c < functions.size() ? functions[ins.c].name : "?");
+                break;
+            case OpCode::RET:
+                os << "r" << ins.a;
+                break;
+            case OpCode::RETV:
+                break;
+            case OpCode::MOV:
+            case OpCode::NEG:
+            case OpCode::NOT:
+            case OpCode::BNOT:
+            case OpCode::BOOL:
+            case OpCode::SEXT8:
+                os << "r" << ins.a << ", r" << ins.b;
+                break;
+            default:
+                os << "r" << ins.a << ", r" << ins.b << ", r" << ins.c;
+                break;
+            }
+            os << "\n";
+        }
+    }
+
+    return os.str();
+}
+
+/* -------------------------------------------------------------------------- */
+/*                           Constant auxiliaries                             */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * 按 C 的花括号规则展开初始化列表：嵌套列表对齐到下一个子数组，
+ * 标量按行优先顺序依次填充。输出 (线性偏移, 初始化表达式) 对。
+ */
+static void layoutInitList(const InitListExpr *list, const std::vector<int> &dims, size_t dimIndex,
+                           int base, std::vector<std::pair<int, const Expr *>> &out)
+{
+    int subSize = 1;
+    for (size_t d = dimIndex + 1; d < dims.size(); ++d)
+        subSize *= dims[d];
+    int total = subSize * dims[dimIndex];
+
+    int cursor = 0;
+    for (const auto &item : list->getItems())
+    {
+        if (cursor >= total)
+            break;
+
+        if (auto *nested = dyn_cast<InitListExpr>(item))
+        {
+            if (dimIndex + 1 < dims.size())
+            {
+                // 对齐到下一个子数组的起点
+                cursor = (cursor + subSize - 1) / subSize * subSize;
+                if (cursor >= total)
+                    break;
+                layoutInitList(nested, dims, dimIndex + 1, base + cursor, out);
+                cursor += subSize;
+            }
+            else
+            {
+                // 带花括号的标量：取第一个元素
+                if (!nested->getItems().empty())
+                    out.emplace_back(base + cursor, nested->getItems()[0]);
+                cursor++;
+            }
+        }
+        else
+        {
+            out.emplace_back(base + cursor, item);
+            cursor++;
+        }
+    }
+}
+
+static int arraySize(const std::vector<int> &dims)
+{
+    int size = 1;
+    for (int dim : dims)
+        size *= dim;
+    return size;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                             Bytecode Compiler                              */
+/* -------------------------------------------------------------------------- */
+
+BytecodeCompiler::BytecodeCompiler()
+    : current(nullptr), freeReg(0), frameTop(0), hasErrors(false)
+{
+    enterScope(); // 全局作用域
+}
+
+void BytecodeCompiler::error(const std::string &message)
+{
+    hasErrors = true;
+    errors.push_back(message);
+    std::cerr << "Bytecode Error: " << message << std::endl;
+}
+
+/* ---------------------------- Scope management ---------------------------- */
+void BytecodeCompiler::enterScope()
+{
+    scopes.emplace_back();
+}
+
+void BytecodeCompiler::exitScope()
+{
+    if (scopes.size() > 1)
+    {
+        scopes.pop_back();
+    }
+}
+
+bool BytecodeCompiler::declare(const std::string &name, const VarInfo &info)
+{
+    return scopes.back().emplace(name, info).second;
+}
+
+const BytecodeCompiler::VarInfo *BytecodeCompiler::lookup(const std::string &name) const
+{
+    // 从内向外查找
+    for (auto it = scopes.rbegin(); it != scopes.rend(); ++it)
+    {
+        auto found = it->find(name);
+        if (found != it->end())
+        {
+            return &found->second;
+        }
+    }
+    return nullptr;
+}
+
+/* ---------------------------- Emit auxiliaries ---------------------------- */
+size_t BytecodeCompiler::emit(OpCode op, int a, int b, int c)
+{
+    current->code.emplace_back(op, static_cast<uint16_t>(a), static_cast<uint16_t>(b),
+                               static_cast<uint16_t>(c));
+    return current->code.size() - 1;
+}
+
+size_t BytecodeCompiler::emitImm(OpCode op, int a, int32_t imm)
+{
+    size_t at = emit(op, a);
+    current->code[at].setImm(imm);
+    return at;
+}
+
+size_t BytecodeCompiler::emitJump(OpCode op, int a)
+{
+    return emitImm(op, a, 0); // 目标稍后回填
+}
+
+void BytecodeCompiler::patchJump(size_t at, size_t target)
+{
+    current->code[at].setImm(static_cast<int32_t>(target) - static_cast<int32_t>(at + 1));
+}
+
+void BytecodeCompiler::emitJumpTo(OpCode op, int a, size_t target)
+{
+    size_t at = emitJump(op, a);
+    patchJump(at, target);
+}
+
+int BytecodeCompiler::allocReg()
+{
+    if (freeReg > UINT16_MAX)
+    {
+        error("Too many registers required in function: " + current->name);
+        return 0;
+    }
+    int reg = freeReg++;
+    if (freeReg > current->numRegs)
+        current->numRegs = freeReg;
+    return reg;
+}
+
+int BytecodeCompiler::addString(const std::string &value)
+{
+    auto it = stringLiterals.find(value);
+    if (it != stringLiterals.end())
+        return it->second;
+
+    int addr = static_cast<int>(program.globals.size());
+    for (char c : value)
+        program.globals.push_back(static_cast<signed char>(c));
+    program.globals.push_back(0);
+
+    stringLiterals.emplace(value, addr);
+    return addr;
+}
+
+/* ------------------------------ Declarations ------------------------------ */
+
+void BytecodeCompiler::declareFunctions(CompUnit *compUnit)
+{
+    // 预先登记所有函数，调用指令可直接引用函数编号
+    for (const auto &unit : compUnit->getUnits())
+    {
+        auto *funcDef = dyn_cast<FuncDef>(unit);
+        if (!funcDef)
+            continue;
+
+        if (functionIndex.count(funcDef->getName()))
+        {
+            error("Redefinition of function: " + funcDef->getName());
+            continue;
+        }
+
+        BytecodeFunction func;
+        func.name = funcDef->getName();
+        func.numParams = static_cast<int>(funcDef->getParams().size());
+        func.returnsVoid = funcDef->getReturnType().kind == TypeSpec::VOID;
+        func.source = funcDef;
+
+        functionIndex[func.name] = static_cast<int>(program.functions.size());
+        program.functions.push_back(std::move(func));
+    }
+}
+
+std::vector<int> BytecodeCompiler::evalDims(const ASTList<Expr *> &dims,
+                                            const std::string &name)
+{
+    std::vector<int> result;
+    for (const auto &dim : dims)
+    {
+        int32_t size = 0;
+        if (!ConstantFolder::getLiteralValue(dim, size) || size <= 0)
+        {
+            error("Array size must be a positive constant: " + name);
+            size = 1;
+        }
+        result.push_back(size);
+    }
+    return result;
+}
+
+void BytecodeCompiler::compileGlobalDecl(const VarDecl *decl)
+{
+    bool isChar = decl->getType().kind == TypeSpec::CHAR;
+
+    for (const auto &varDef : decl->getVars())
+    {
+        const std::string &name = varDef->getName();
+
+        VarInfo info;
+        info.storage = VarInfo::GLOBAL;
+        info.dims = evalDims(varDef->getDims(), name);
+        info.isArray = !info.dims.empty();
+        info.isChar = isChar;
+        info.isConst = decl->getType().isConst;
+
+        int size = arraySize(info.dims);
+        int addr = static_cast<int>(program.globals.size());
+        info.location = addr;
+        program.globals.resize(program.globals.size() + size, 0);
+
+        // 全局初始化在编译期完成，写入初始内存映像
+        const Expr *init = varDef->getInit();
+        std::vector<std::pair<int, const Expr *>> items;
+        if (auto *initList = dyn_cast_or_null<InitListExpr>(init))
+        {
+            if (info.isArray)
+                layoutInitList(initList, info.dims, 0, 0, items);
+            else if (!initList->getItems().empty())
+                items.emplace_back(0, initList->getItems()[0]);
+        }
+        else if (auto *str = dyn_cast_or_null<StringExpr>(init); str && info.isArray && isChar)
+        {
+            const std::string &value = str->getValue();
+            for (size_t i = 0; i < value.size() && i < static_cast<size_t>(size); ++i)
+                program.globals[addr + i] = static_cast<signed char>(value[i]);
+        }
+        else if (init)
+        {
+            // 标量初始化所有元素
+            for (int i = 0; i < size; ++i)
+                items.emplace_back(i, init);
+        }
+
+        for (const auto &item : items)
+        {
+            int32_t value;
+            if (!ConstantFolder::getLiteralValue(item.second, value))
+            {
+                error("Global variable initializer must be constant: " + name);
+                break;
+            }
+            program.globals[addr + item.first] = isChar ? static_cast<signed char>(value) : value;
+        }
+
+        if (!declare(name, info))
+        {
+            error("Redeclaration of variable: " + name);
+            continue;
+        }
+        program.globalSymbols.push_back({name, addr, size, isChar});
+    }
+}
+
+void BytecodeCompiler::compileLocalDecl(const VarDecl *decl)
+{
+    bool isChar = decl->getType().kind == TypeSpec::CHAR;
+
+    for (const auto &varDef : decl->getVars())
+    {
+        const std::string &name = varDef->getName();
+
+        VarInfo info;
+        info.storage = VarInfo::REGISTER;
+        info.dims = evalDims(varDef->getDims(), name);
+        info.isArray = !info.dims.empty();
+        info.isChar = isChar;
+        info.isConst = decl->getType().isConst;
+        info.location = allocReg();
+
+        const Expr *init = varDef->getInit();
+        if (info.isArray)
+        {
+            // 局部数组位于栈帧数组区，块结束后空间可复用
+            emitImm(OpCode::LEA, info.location, frameTop);
+            frameTop += arraySize(info.dims);
+            if (frameTop > current->frameSize)
+                current->frameSize = frameTop;
+
+            if (init)
+                compileArrayInit(info, info.location, init);
+        }
+        else if (init)
+        {
+            // 初始化列表（对标量变量，取第一个元素）
+            if (auto *initList = dyn_cast<InitListExpr>(init))
+                init = initList->getItems().empty() ? nullptr : initList->getItems()[0];
+
+            if (init)
+            {
+                int mark = freeReg;
+                compileExprTo(init, info.location);
+                if (isChar)
+                    emit(OpCode::SEXT8, info.location, info.location);
+                freeReg = mark;
+            }
+        }
+
+        // 与 CodeGenerator 一致：初始化表达式求值后才进入作用域
+        if (!declare(name, info))
+        {
+            error("Redeclaration of variable: " + name);
+        }
+    }
+}
+
+void BytecodeCompiler::compileArrayInit(const VarInfo &var, int baseReg, const Expr *init)
+{
+    int size = arraySize(var.dims);
+    int mark = freeReg;
+
+    if (auto *initList = dyn_cast<InitListExpr>(init))
+    {
+        std::vector<std::pair<int, const Expr *>> items;
+        layoutInitList(initList, var.dims, 0, 0, items);
+
+        // 未显式初始化的元素清零
+        if (items.size() < static_cast<size_t>(size))
+        {
+            int zero = allocReg();
+            int count = allocReg();
+            emitImm(OpCode::LOADI, zero, 0);
+            emitImm(OpCode::LOADI, count, size);
+            emit(OpCode::FILL, baseReg, zero, count);
+        }
+
+        int itemMark = freeReg;
+        for (const auto &item : items)
+        {
+            int value = compileExprAny(item.second);
+            if (var.isChar)
+            {
+                int truncated = allocReg();
+                emit(OpCode::SEXT8, truncated, value);
+                value = truncated;
+            }
+            int offset = allocReg();
+            emitImm(OpCode::LOADI, offset, item.first);
+            emit(OpCode::STORE, value, baseReg, offset);
+            freeReg = itemMark;
+        }
+    }
+    else if (auto *str = dyn_cast<StringExpr>(init); str && var.isChar)
+    {
+        // char 数组用字符串初始化：逐字符拷贝，剩余部分清零
+        int zero = allocReg();
+        int count = allocReg();
+        emitImm(OpCode::LOADI, zero, 0);
+        emitImm(OpCode::LOADI, count, size);
+        emit(OpCode::FILL, baseReg, zero, count);
+
+        const std::string &value = str->getValue();
+        int ch = allocReg();
+        int offset = allocReg();
+        for (size_t i = 0; i < value.size() && i < static_cast<size_t>(size); ++i)
+        {
+            emitImm(OpCode::LOADI, ch, static_cast<signed char>(value[i]));
+            emitImm(OpCode::LOADI, offset, static_cast<int32_t>(i));
+            emit(OpCode::STORE, ch, baseReg, offset);
+        }
+    }
+    else
+    {
+        // 单个值初始化（标量初始化所有元素）
+        int value = compileExprAny(init);
+        if (var.isChar)
+        {
+            int truncated = allocReg();
+            emit(OpCode::SEXT8, truncated, value);
+            value = truncated;
+        }
+        int count = allocReg();
+        emitImm(OpCode::LOADI, count, size);
+        emit(OpCode::FILL, baseReg, value, count);
+    }
+
+    freeReg = mark;
+}
+
+void BytecodeCompiler::compileFuncDef(FuncDef *funcDef)
+{
+    auto it = functionIndex.find(funcDef->getName());
+    if (it == functionIndex.end() || program.functions[it->second].source != funcDef)
+        return; // 重复定义，已报告
+
+    current = &program.functions[it->second];
+    freeReg = 0;
+    frameTop = 0;
+
+    // 参数依次占据 R[0..numParams)
+    enterScope();
+    for (const auto &param : funcDef->getParams())
+    {
+        VarInfo info;
+        info.storage = VarInfo::REGISTER;
+        info.location = allocReg();
+        info.isArray = param->getIsArray();
+        info.isChar = param->getType().kind == TypeSpec::CHAR;
+        info.isConst = param->getType().isConst;
+
+        if (info.isArray)
+        {
+            // 第一维是 []，大小未指定（用 0 表示）
+            info.dims.push_back(0);
+            for (const auto &dimExpr : param->getDims())
+            {
+                int32_t size = 0;
+                info.dims.push_back(ConstantFolder::getLiteralValue(dimExpr, size) ? size : 0);
+            }
+        }
+
+        if (!declare(param->getName(), info))
+        {
+            error("Redeclaration of parameter: " + param->getName());
+        }
+    }
+
+    compileBlock(funcDef->getBody());
+
+    // 函数末尾的隐式返回
+    if (current->returnsVoid)
+    {
+        emit(OpCode::RETV);
+    }
+    else
+    {
+        int zero = allocReg();
+        emitImm(OpCode::LOADI, zero, 0);
+        emit(OpCode::RET, zero);
+    }
+
+    exitScope();
+    current = nullptr;
+}
+
+/* ------------------------------- Statements ------------------------------- */
+
+void BytecodeCompiler::compileStmt(const Stmt *stmt)
+{
+    if (!stmt)
+        return;
+
+    switch (stmt->getKind())
+    {
+    case NodeKind::ExprStmt:
+        if (auto *expr = cast<ExprStmt>(stmt)->getExpr())
+        {
+            int mark = freeReg;
+            compileExprAny(expr);
+            freeReg = mark;
+        }
+        return;
+    case NodeKind::AssignStmt:
+        return compileAssign(cast<AssignStmt>(stmt));
+    case NodeKind::BlockStmt:
+        return compileBlock(cast<BlockStmt>(stmt));
+    case NodeKind::IfStmt:
+        return compileIf(cast<IfStmt>(stmt));
+    case NodeKind::WhileStmt:
+        return compileWhile(cast<WhileStmt>(stmt));
+    case NodeKind::ForStmt:
+        return compileFor(cast<ForStmt>(stmt));
+    case NodeKind::ReturnStmt:
+        return compileReturn(cast<ReturnStmt>(stmt));
+    case NodeKind::BreakStmt:
+        if (loops.empty())
+        {
+            error("Break statement outside loop");
+            return;
+        }
+        loops.back().breakJumps.push_back(emitJump(OpCode::JMP));
+        return;
+    case NodeKind::ContinueStmt:
+        if (loops.empty())
+        {
+            error("Continue statement outside loop");
+            return;
+        }
+        loops.back().continueJumps.push_back(emitJump(OpCode::JMP));
+        return;
+    default:
+        break;
+    }
+
+    error("Unknown statement type");
+}
+
+void BytecodeCompiler::compileBlock(const BlockStmt *block)
+{
+    if (!block)
+        return;
+
+    enterScope();
+    int regMark = freeReg;
+    int frameMark = frameTop;
+
+    for (const auto &item : block->getItems())
+    {
+        if (auto *decl = dyn_cast<VarDecl>(item))
+        {
+            compileLocalDecl(decl);
+        }
+        else if (auto *s = dyn_cast<Stmt>(item))
+        {
+            compileStmt(s);
+        }
+    }
+
+    // 块内局部变量的寄存器与数组空间在块结束后释放
+    freeReg = regMark;
+    frameTop = frameMark;
+    exitScope();
+}
+
+void BytecodeCompiler::compileAssign(const AssignStmt *stmt)
+{
+    const LValExpr *lval = stmt->getLhs();
+    const VarInfo *var = lookup(lval->getName());
+    if (!var)
+    {
+        error("Undeclared variable: " + lval->getName());
+        return;
+    }
+
+    if (var->isConst)
+    {
+        error("Cannot assign to const variable: " + lval->getName());
+        return;
+    }
+
+    int mark = freeReg;
+
+    if (lval->getIndices().empty())
+    {
+        if (var->isArray)
+        {
+            error("Cannot assign to array: " + lval->getName());
+            return;
+        }
+
+        if (var->storage == VarInfo::REGISTER)
+        {
+            // 局部标量：直接求值到变量寄存器
+            compileExprTo(stmt->getRhs(), var->location);
+            if (var->isChar)
+                emit(OpCode::SEXT8, var->location, var->location);
+        }
+        else
+        {
+            int value = compileExprAny(stmt->getRhs());
+            if (var->isChar)
+            {
+                int truncated = allocReg();
+                emit(OpCode::SEXT8, truncated, value);
+                value = truncated;
+            }
+            emitImm(OpCode::SETG, value, var->location);
+        }
+    }
+    else
+    {
+        if (!var->isArray || lval->getIndices().size() != var->dims.size())
+        {
+            error("Assignment target is not an array element: " + lval->getName());
+            return;
+        }
+
+        int value = compileExprAny(stmt->getRhs());
+        if (var->isChar)
+        {
+            int truncated = allocReg();
+            emit(OpCode::SEXT8, truncated, value);
+            value = truncated;
+        }
+        int base = compileArrayBase(*var);
+        int offset = compileElementOffset(lval, *var);
+        emit(OpCode::STORE, value, base, offset);
+    }
+
+    freeReg = mark;
+}
+
+void BytecodeCompiler::compileIf(const IfStmt *stmt)
+{
+    int mark = freeReg;
+    int cond = compileExprAny(stmt->getCond());
+    size_t jumpElse = emitJump(OpCode::JMPF, cond);
+    freeReg = mark;
+
+    compileStmt(stmt->getThenStmt());
+
+    if (stmt->getElseStmt())
+    {
+        size_t jumpEnd = emitJump(OpCode::JMP);
+        patchJump(jumpElse, current->code.size());
+        compileStmt(stmt->getElseStmt());
+        patchJump(jumpEnd, current->code.size());
+    }
+    else
+    {
+        patchJump(jumpElse, current->code.size());
+    }
+}
+
+void BytecodeCompiler::finishLoop(size_t continueTarget)
+{
+    LoopInfo &loop = loops.back();
+    for (size_t at : loop.continueJumps)
+        patchJump(at, continueTarget);
+    for (size_t at : loop.breakJumps)
+        patchJump(at, current->code.size());
+    loops.pop_back();
+}
+
+// 条件置于循环底部：每次迭代只执行一条条件跳转
+//     JMP cond
+// body:
+//     <body>
+// cond:
+//     JMPT <cond>, body
+void BytecodeCompiler::compileWhile(const WhileStmt *stmt)
+{
+    size_t jumpCond = emitJump(OpCode::JMP);
+    size_t bodyStart = current->code.size();
+
+    loops.emplace_back();
+    compileStmt(stmt->getBody());
+
+    size_t condStart = current->code.size();
+    patchJump(jumpCond, condStart);
+
+    int mark = freeReg;
+    int cond = compileExprAny(stmt->getCond());
+    emitJumpTo(OpCode::JMPT, cond, bodyStart);
+    freeReg = mark;
+
+    finishLoop(condStart);
+}
+
+void BytecodeCompiler::compileFor(const ForStmt *stmt)
+{
+    // For 循环：for (init; cond; step) body
+    enterScope();
+    int regMark = freeReg;
+    int frameMark = frameTop;
+
+    // 初始化
+    if (stmt->getInit())
+    {
+        if (auto *decl = dyn_cast<VarDecl>(stmt->getInit()))
+        {
+            compileLocalDecl(decl);
+        }
+        else if (auto *s = dyn_cast<Stmt>(stmt->getInit()))
+        {
+            compileStmt(s);
+        }
+    }
+
+    size_t jumpCond = stmt->getCond() ? emitJump(OpCode::JMP) : 0;
+    size_t bodyStart = current->code.size();
+
+    loops.emplace_back();
+    compileStmt(stmt->getBody());
+
+    // 步进（continue 跳转目标）
+    size_t stepStart = current->code.size();
+    if (auto *s = dyn_cast_or_null<Stmt>(stmt->getStep()))
+    {
+        compileStmt(s);
+    }
+
+    // 条件
+    if (stmt->getCond())
+    {
+        patchJump(jumpCond, current->code.size());
+        int mark = freeReg;
+        int cond = compileExprAny(stmt->getCond());
+        emitJumpTo(OpCode::JMPT, cond, bodyStart);
+        freeReg = mark;
+    }
+    else
+    {
+        emitJumpTo(OpCode::JMP, 0, bodyStart); // 无条件，无限循环
+    }
+
+    finishLoop(stepStart);
+
+    freeReg = regMark;
+    frameTop = frameMark;
+    exitScope();
+}
+
+void BytecodeCompiler::compileReturn(const ReturnStmt *stmt)
+{
+    if (stmt->getValue())
+    {
+        if (current->returnsVoid)
+        {
+            error("Void function should not return a value: " + current->name);
+            return;
+        }
+        int mark = freeReg;
+        int value = compileExprAny(stmt->getValue());
+        emit(OpCode::RET, value);
+        freeReg = mark;
+    }
+    else
+    {
+        if (!current->returnsVoid)
+        {
+            error("Non-void function should return a value: " + current->name);
+            return;
+        }
+        emit(OpCode::RETV);
+    }
+}
+
+/* ------------------------------- Expressions ------------------------------ */
+
+int BytecodeCompiler::compileExprAny(const Expr *expr)
+{
+    // 局部标量可直接作为操作数，无需拷贝
+    if (auto *lval = dyn_cast_or_null<LValExpr>(expr))
+    {
+        const VarInfo *var = lookup(lval->getName());
+        if (var && var->storage == VarInfo::REGISTER && !var->isArray && lval->getIndices().empty())
+            return var->location;
+    }
+
+    int reg = allocReg();
+    compileExprTo(expr, reg);
+    return reg;
+}
+
+void BytecodeCompiler::compileExprTo(const Expr *expr, int dst)
+{
+    if (!expr)
+        return;
+
+    switch (expr->getKind())
+    {
+    case NodeKind::NumberExpr:
+        emitImm(OpCode::LOADI, dst, cast<NumberExpr>(expr)->getValue());
+        return;
+    case NodeKind::CharExpr:
+        emitImm(OpCode::LOADI, dst, static_cast<signed char>(cast<CharExpr>(expr)->getValue()));
+        return;
+    case NodeKind::StringExpr:
+        emitImm(OpCode::LOADI, dst, addString(cast<StringExpr>(expr)->getValue()));
+        return;
+    case NodeKind::LValExpr:
+        return compileLVal(cast<LValExpr>(expr), dst);
+    case NodeKind::BinaryExpr:
+        return compileBinary(cast<BinaryExpr>(expr), dst);
+    case NodeKind::UnaryExpr:
+        return compileUnary(cast<UnaryExpr>(expr), dst);
+    case NodeKind::TernaryExpr:
+    {
+        auto *tern = cast<TernaryExpr>(expr);
+        int mark = freeReg;
+        int cond = compileExprAny(tern->getCond());
+        size_t jumpElse = emitJump(OpCode::JMPF, cond);
+        freeReg = mark;
+
+        compileExprTo(tern->getTrueExpr(), dst);
+        size_t jumpEnd = emitJump(OpCode::JMP);
+        patchJump(jumpElse, current->code.size());
+        compileExprTo(tern->getFalseExpr(), dst);
+        patchJump(jumpEnd, current->code.size());
+        return;
+    }
+    case NodeKind::FuncCallExpr:
+        return compileCall(cast<FuncCallExpr>(expr), dst);
+    case NodeKind::InitListExpr:
+        error("InitList expression can only be used in variable initialization");
+        return;
+    default:
+        break;
+    }
+
+    error("Unknown expression type");
+}
+
+void BytecodeCompiler::compileLVal(const LValExpr *lval, int dst)
+{
+    const VarInfo *var = lookup(lval->getName());
+    if (!var)
+    {
+        error("Undeclared variable: " + lval->getName());
+        return;
+    }
+
+    if (lval->getIndices().empty())
+    {
+        if (var->storage == VarInfo::REGISTER)
+        {
+            // 标量取值或数组取基址
+            if (var->location != dst)
+                emit(OpCode::MOV, dst, var->location);
+        }
+        else if (var->isArray)
+        {
+            emitImm(OpCode::LOADI, dst, var->location);
+        }
+        else
+        {
+            emitImm(OpCode::GETG, dst, var->location);
+        }
+        return;
+    }
+
+    if (!var->isArray || lval->getIndices().size() > var->dims.size())
+    {
+        error("Too many indices for variable: " + lval->getName());
+        return;
+    }
+
+    int mark = freeReg;
+    int base = compileArrayBase(*var);
+    int offset = compileElementOffset(lval, *var);
+
+    if (lval->getIndices().size() == var->dims.size())
+        emit(OpCode::LOAD, dst, base, offset); // 数组元素
+    else
+        emit(OpCode::ADD, dst, base, offset); // 子数组地址（如传递给函数的数组参数）
+
+    freeReg = mark;
+}
+
+int BytecodeCompiler::compileArrayBase(const VarInfo &var)
+{
+    if (var.storage == VarInfo::REGISTER)
+        return var.location;
+
+    int reg = allocReg();
+    emitImm(OpCode::LOADI, reg, var.location);
+    return reg;
+}
+
+int BytecodeCompiler::compileElementOffset(const LValExpr *lval, const VarInfo &var)
+{
+    const auto &indices = lval->getIndices();
+
+    // 行优先：offset = sum(index[k] * stride[k])，stride[k] 为后续各维度之积
+    auto strideOf = [&var](size_t k)
+    {
+        int stride = 1;
+        for (size_t d = k + 1; d < var.dims.size(); ++d)
+            stride *= var.dims[d];
+        return stride;
+    };
+
+    if (indices.size() == 1 && strideOf(0) == 1)
+        return compileExprAny(indices[0]);
+
+    int offset = allocReg();
+    for (size_t k = 0; k < indices.size(); ++k)
+    {
+        int mark = freeReg;
+        int index = compileExprAny(indices[k]);
+        int stride = strideOf(k);
+
+        int term = index;
+        if (stride != 1)
+        {
+            int strideReg = allocReg();
+            emitImm(OpCode::LOADI, strideReg, stride);
+            term = k == 0 ? offset : allocReg();
+            emit(OpCode::MUL, term, index, strideReg);
+        }
+
+        if (k == 0)
+        {
+            if (term != offset)
+                emit(OpCode::MOV, offset, term);
+        }
+        else
+        {
+            emit(OpCode::ADD, offset, offset, term);
+        }
+        freeReg = mark;
+    }
+    return offset;
+}
+
+void BytecodeCompiler::compileBinary(const BinaryExpr *expr, int dst)
+{
+    BinaryOp op = expr->getOp();
+    int mark = freeReg;
+
+    // 逻辑运算符短路求值，结果为 0/1
+    if (op == BinaryOp::LogicalAnd || op == BinaryOp::LogicalOr)
+    {
+        bool isAnd = op == BinaryOp::LogicalAnd;
+        int lhs = compileExprAny(expr->getLhs());
+        size_t jumpShort = emitJump(isAnd ? OpCode::JMPF : OpCode::JMPT, lhs);
+        int rhs = compileExprAny(expr->getRhs());
+        emit(OpCode::BOOL, dst, rhs);
+        size_t jumpEnd = emitJump(OpCode::JMP);
+        patchJump(jumpShort, current->code.size());
+        emitImm(OpCode::LOADI, dst, isAnd ? 0 : 1);
+        patchJump(jumpEnd, current->code.size());
+        freeReg = mark;
+        return;
+    }
+
+    int lhs = compileExprAny(expr->getLhs());
+
+    // 加减小常量使用立即数形式
+    if (auto *num = dyn_cast<NumberExpr>(expr->getRhs()); num && (op == BinaryOp::Add || op == BinaryOp::Sub))
+    {
+        long long imm = op == BinaryOp::Add ? num->getValue() : -static_cast<long long>(num->getValue());
+        if (imm >= INT16_MIN && imm <= INT16_MAX)
+        {
+            emit(OpCode::ADDI, dst, lhs, static_cast<uint16_t>(static_cast<int16_t>(imm)));
+            freeReg = mark;
+            return;
+        }
+    }
+
+    int rhs = compileExprAny(expr->getRhs());
+
+    // 按 BinaryOp 顺序排列的指令表（逻辑运算已在上面处理）
+    static const OpCode binaryOps[] = {
+        OpCode::ADD, OpCode::SUB, OpCode::MUL, OpCode::DIV, OpCode::MOD,
+        OpCode::LT, OpCode::GT, OpCode::LE, OpCode::GE, OpCode::EQ, OpCode::NE,
+        OpCode::AND, OpCode::OR, OpCode::XOR, OpCode::SHL, OpCode::SHR};
+    static_assert(sizeof(binaryOps) / sizeof(binaryOps[0]) == static_cast<size_t>(BinaryOp::Shr) + 1,
+                  "binaryOps must cover every non-logical BinaryOp");
+
+    emit(binaryOps[static_cast<size_t>(op)], dst, lhs, rhs);
+    freeReg = mark;
+}
+
+void BytecodeCompiler::compileUnary(const UnaryExpr *expr, int dst)
+{
+    OpCode code;
+    switch (expr->getOp())
+    {
+    case UnaryOp::Plus:
+        return compileExprTo(expr->getRhs(), dst); // 一元加号不做任何操作
+    case UnaryOp::Minus:
+        code = OpCode::NEG;
+        break;
+    case UnaryOp::LogicalNot:
+        code = OpCode::NOT;
+        break;
+    case UnaryOp::BitNot:
+        code = OpCode::BNOT;
+        break;
+    default:
+        // ++, -- 暂不支持（需要左值）
+        error("Prefix increment/decrement not yet supported");
+        return;
+    }
+
+    int mark = freeReg;
+    int operand = compileExprAny(expr->getRhs());
+    emit(code, dst, operand);
+    freeReg = mark;
+}
+
+void BytecodeCompiler::compileCall(const FuncCallExpr *expr, int dst)
+{
+    auto it = functionIndex.find(expr->getName());
+    if (it == functionIndex.end())
+    {
+        error("Unknown function: " + expr->getName());
+        return;
+    }
+
+    const BytecodeFunction &callee = program.functions[it->second];
+    if (static_cast<size_t>(callee.numParams) != expr->getArgs().size())
+    {
+        error("Incorrect number of arguments for function: " + expr->getName() +
+              " (expected " + std::to_string(callee.numParams) +
+              ", got " + std::to_string(expr->getArgs().size()) + ")");
+        return;
+    }
+
+    if (it->second > UINT16_MAX)
+    {
+        error("Too many functions in program");
+        return;
+    }
+
+    // 实参放在连续的寄存器中，作为被调者寄存器窗口的起点
+    int mark = freeReg;
+    int argBase = freeReg;
+    for (size_t i = 0; i < expr->getArgs().size(); ++i)
+    {
+        freeReg = argBase + static_cast<int>(i);
+        int reg = allocReg();
+        compileExprTo(expr->getArgs()[i], reg);
+    }
+
+    emit(OpCode::CALL, dst, argBase, it->second);
+    freeReg = mark;
+}
+
+/* --------------------------- Top-level compilation ------------------------ */
+bool BytecodeCompiler::compile(CompUnit *compUnit)
+{
+    // 与 LLVM 后端共用同一遍 AST 常量折叠（const 维度、const 标量传播）
+    foldConstants(compUnit);
+
+    declareFunctions(compUnit);
+
+    for (const auto &unit : compUnit->getUnits())
+    {
+        if (auto *funcDef = dyn_cast<FuncDef>(unit))
+        {
+            compileFuncDef(funcDef);
+        }
+        else if (auto *decl = dyn_cast<VarDecl>(unit))
+        {
+            compileGlobalDecl(decl);
+        }
+    }
+
+    return !hasErrors;
+}
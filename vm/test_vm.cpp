@@ -0,0 +1,159 @@
+#include "vm.h"
+#include "parser.h"
+#include "lexer.h"
+#include <chrono>
+#include <iostream>
+
+static double elapsedUs(std::chrono::steady_clock::time_point start)
+{
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count();
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        std::cout << "Usage: " << argv[0] << " <source_file|--test> [--disasm]" << std::endl;
+        std::cout << "\nExample: " << argv[0] << " test.c" << std::endl;
+        std::cout << "\nOr run with inline test:" << std::endl;
+        std::cout << "  " << argv[0] << " --test" << std::endl;
+        return 1;
+    }
+
+    SourceManager sources;
+    std::string_view source;
+    std::string filename;
+    bool builtinTest = false;
+    bool disasm = argc > 2 && std::string(argv[2]) == "--disasm";
+
+    if (std::string(argv[1]) == "--test")
+    {
+        // 内置测试代码：覆盖递归调用、数组参数、全局数组、循环控制与短路求值
+        // main 返回 add(3, 4) + factorial(5) + sum(a, 5) + count = 7 + 120 + 15 + 6 = 148
+        filename = "test.c";
+        builtinTest = true;
+        source = R"(
+int g[2][3] = {{1, 2, 3}, {4, 5, 6}};
+const int K = 2;
+
+int add(int a, int b) {
+    return a + b;
+}
+
+int factorial(int n) {
+    if (n <= 1) {
+        return 1;
+    }
+    return n * factorial(n - 1);
+}
+
+int sum(int arr[], int n) {
+    int s = 0;
+    for (int i = 0; i < n; i = i + 1) {
+        s = s + arr[i];
+    }
+    return s;
+}
+
+int main() {
+    int a[5] = {1, 2, 3, 4, 5};
+    int count = 0;
+    int i = 0;
+    while (1) {
+        i = i + 1;
+        if (i > 10) {
+            break;
+        }
+        if (i % K == 0 && g[1][i % 3] != 0) {
+            continue;
+        }
+        count = count + 1;
+    }
+    count = count + (g[K - 1][2] == 6 || factorial(100) == 0);
+    return add(3, 4) + factorial(5) + sum(a, 5) + count;
+}
+)";
+    }
+    else
+    {
+        // 从文件读取
+        filename = argv[1];
+        const SourceBuffer *buffer = sources.load(filename);
+        if (!buffer)
+        {
+            std::cerr << "Error: " << sources.getError() << std::endl;
+            return 1;
+        }
+        source = buffer->text();
+    }
+
+    std::cout << "=== VM running " << filename << " ===" << std::endl;
+
+    // 词法分析
+    Lexer lexer(filename, source);
+
+    // 语法分析
+    Parser parser(lexer);
+    auto ast = parser.parse();
+
+    // 检查解析错误
+    if (parser.hasErrors())
+    {
+        std::cerr << "\n=== Parse Errors ===" << std::endl;
+        for (const auto &error : parser.getErrors())
+        {
+            std::cerr << error << std::endl;
+        }
+        return 1;
+    }
+
+    // 编译为字节码
+    auto start = std::chrono::steady_clock::now();
+    BytecodeCompiler compiler;
+    if (!compiler.compile(ast.get()))
+    {
+        std::cerr << "\n=== Bytecode Errors ===" << std::endl;
+        for (const auto &error : compiler.getErrors())
+        {
+            std::cerr << error << std::endl;
+        }
+        return 1;
+    }
+    double compileUs = elapsedUs(start);
+
+    const Program &program = compiler.getProgram();
+    if (disasm)
+    {
+        std::cout << "\n=== Bytecode ===" << std::endl;
+        std::cout << program.disassemble() << std::endl;
+    }
+
+    // 执行 main（计时包含 VM 构造）
+    start = std::chrono::steady_clock::now();
+    VM vm(program);
+    int result = 0;
+    if (!vm.run(result))
+    {
+        std::cerr << "\n=== VM Errors ===" << std::endl;
+        for (const auto &error : vm.getErrors())
+        {
+            std::cerr << error << std::endl;
+        }
+        return 1;
+    }
+    double runUs = elapsedUs(start);
+
+    std::cout << "main() returned " << result << std::endl;
+    std::cout << "Compile time: " << compileUs << " us" << std::endl;
+    std::cout << "Run time:     " << runUs << " us" << std::endl;
+
+    if (builtinTest && result != 148)
+    {
+        std::cerr << "Unexpected result: expected 148" << std::endl;
+        return 1;
+    }
+
+    std::cout << "\n=== VM execution completed successfully ===" << std::endl;
+    return 0;
+}
@@ -0,0 +1,404 @@
+#include "vm.h"
+#include <algorithm>
+#include <iostream>
+
+/* -------------------------------------------------------------------------- */
+/*                              Virtual Machine                               */
+/* -------------------------------------------------------------------------- */
+
+VM::VM(const Program &program, size_t registerCount, size_t memorySize)
+    : program(program),
+      registers(static_cast<int32_t *>(std::calloc(registerCount, sizeof(int32_t)))),
+      memory(static_cast<int32_t *>(std::calloc(memorySize, sizeof(int32_t)))),
+      registerCount(registers ? registerCount : 0), memorySize(memory ? memorySize : 0),
+      maxCallDepth(1 << 16), memoryUsed(0),
+      nativeCode(program.functions.size(), nullptr),
+      hotness(program.functions.size(), INT32_MAX), hasErrors(false)
+{
+}
+
+void VM::setTierUpHook(TierUpHook hook, int32_t threshold)
+{
+    tierUpHook = std::move(hook);
+    std::fill(hotness.begin(), hotness.end(), threshold > 0 ? threshold : 1);
+}
+
+void VM::tierUp(int functionIndex)
+{
+    // 无论成功与否只尝试一次
+    hotness[functionIndex] = INT32_MAX;
+    if (tierUpHook && !nativeCode[functionIndex])
+    {
+        nativeCode[functionIndex] = tierUpHook(functionIndex);
+    }
+}
+
+void VM::error(const std::string &message)
+{
+    hasErrors = true;
+    errors.push_back(message);
+    std::cerr << "VM Error: " << message << std::endl;
+}
+
+bool VM::run(int &result, const std::string &entry)
+{
+    result = 0;
+
+    int index = program.findFunction(entry);
+    if (index < 0)
+    {
+        error("Entry function not found: " + entry);
+        return false;
+    }
+
+    const BytecodeFunction &func = program.functions[index];
+    if (func.numParams != 0)
+    {
+        error("Entry function takes parameters: " + entry);
+        return false;
+    }
+
+    // 装载全局内存映像
+    if (!registers || !memory)
+    {
+        error("Cannot allocate VM memory");
+        return false;
+    }
+    if (program.globals.size() > memorySize)
+    {
+        error("Global data exceeds VM memory");
+        return false;
+    }
+    std::fill(memory.get(), memory.get() + memoryUsed, 0);
+    std::copy(program.globals.begin(), program.globals.end(), memory.get());
+    memoryUsed = static_cast<int32_t>(program.globals.size());
+
+    frames.clear();
+    return execute(index, result);
+}
+
+/**
+ * 分派宏：同一份处理程序代码在两种分派方式下展开
+ *   VM_CASE(op)   处理程序入口
+ *   VM_NEXT()     取下一条指令并跳转到其处理程序
+ */
+#if VM_USE_COMPUTED_GOTO
+#define VM_CASE(name) L_##name:
+#define VM_NEXT()              \
+    do                         \
+    {                          \
+        ins = &pc->ins;        \
+        goto *(pc++)->handler; \
+    } while (0)
+#else
+#define VM_CASE(name) case OpCode::name:
+#define VM_NEXT() break
+#endif
+
+// 二元运算处理程序：R[a] = R[b] op R[c]
+#define VM_BINARY(name, expr)       \
+    VM_CASE(name)                   \
+    {                               \
+        int32_t lhs = regs[ins->b]; \
+        int32_t rhs = regs[ins->c]; \
+        regs[ins->a] = (expr);      \
+        VM_NEXT();                  \
+    }
+
+// 循环回边（向后跳转）计入当前函数热度
+#define VM_JUMP(offset)                                 \
+    do                                                  \
+    {                                                   \
+        int32_t jumpOffset = (offset);                  \
+        pc += jumpOffset;                               \
+        if (jumpOffset < 0 && --*counter == 0)          \
+            tierUp(static_cast<int>(func - functions)); \
+    } while (0)
+
+// 32 位补码回绕运算
+#define VM_WRAP(op) static_cast<int32_t>(static_cast<uint32_t>(lhs) op static_cast<uint32_t>(rhs))
+
+bool VM::execute(int entryIndex, int &result)
+{
+#if VM_USE_COMPUTED_GOTO
+    // 处理程序地址表，顺序必须与 OpCode 一致
+    static const void *const handlers[] = {
+        &&L_MOV, &&L_LOADI, &&L_GETG, &&L_SETG, &&L_LEA, &&L_LOAD, &&L_STORE, &&L_FILL,
+        &&L_ADD, &&L_SUB, &&L_MUL, &&L_DIV, &&L_MOD, &&L_AND, &&L_OR, &&L_XOR, &&L_SHL, &&L_SHR, &&L_ADDI,
+        &&L_EQ, &&L_NE, &&L_LT, &&L_LE, &&L_GT, &&L_GE,
+        &&L_NEG, &&L_NOT, &&L_BNOT, &&L_BOOL, &&L_SEXT8,
+        &&L_JMP, &&L_JMPF, &&L_JMPT, &&L_CALL, &&L_RET, &&L_RETV};
+    static_assert(sizeof(handlers) / sizeof(handlers[0]) == static_cast<size_t>(OpCode::NUM_OPCODES),
+                  "handlers must match OpCode");
+
+    // 首次执行时将所有函数翻译为线索化代码
+    if (threadedCode.size() != program.functions.size())
+    {
+        threadedCode.clear();
+        threadedCode.reserve(program.functions.size());
+        for (const auto &function : program.functions)
+        {
+            std::vector<ThreadedInstruction> code;
+            code.reserve(function.code.size());
+            for (const auto &instruction : function.code)
+            {
+                if (instruction.op >= OpCode::NUM_OPCODES)
+                {
+                    error("Invalid opcode in function: " + function.name);
+                    threadedCode.clear();
+                    return false;
+                }
+                code.push_back({handlers[static_cast<size_t>(instruction.op)], instruction});
+            }
+            threadedCode.push_back(std::move(code));
+        }
+    }
+    auto codeOf = [this](int index) { return threadedCode[index].data(); };
+#else
+    auto codeOf = [this](int index) { return program.functions[index].code.data(); };
+#endif
+
+    const int32_t memSize = static_cast<int32_t>(memorySize);
+    int32_t *mem = memory.get();
+    int32_t *const regsEnd = registers.get() + registerCount;
+
+    const BytecodeFunction *const functions = program.functions.data();
+    const BytecodeFunction *func = &functions[entryIndex];
+    const CodeUnit *pc = codeOf(entryIndex);
+    int32_t *counter = &hotness[entryIndex];
+    const Instruction *ins = nullptr;
+    int32_t *regs = registers.get();
+    int32_t memBase = static_cast<int32_t>(program.globals.size());
+
+    if (regs + func->numRegs > regsEnd || memBase + func->frameSize > memSize)
+    {
+        error("Stack overflow in function: " + func->name);
+        return false;
+    }
+    memoryUsed = memBase + func->frameSize;
+
+    // 内存访问越界检查
+    auto checkAddress = [&](int64_t addr) -> bool
+    {
+        if (addr < 0 || addr >= memSize)
+        {
+            error("Memory access out of bounds in function " + func->name +
+                  ": address " + std::to_string(addr));
+            return false;
+        }
+        return true;
+    };
+
+#if VM_USE_COMPUTED_GOTO
+    VM_NEXT();
+    {
+#else
+    for (;;)
+    {
+        ins = pc++;
+        switch (ins->op)
+        {
+#endif
+        VM_CASE(MOV)
+        {
+            regs[ins->a] = regs[ins->b];
+            VM_NEXT();
+        }
+        VM_CASE(LOADI)
+        {
+            regs[ins->a] = ins->imm();
+            VM_NEXT();
+        }
+        VM_CASE(GETG)
+        {
+            regs[ins->a] = mem[ins->imm()];
+            VM_NEXT();
+        }
+        VM_CASE(SETG)
+        {
+            mem[ins->imm()] = regs[ins->a];
+            VM_NEXT();
+        }
+        VM_CASE(LEA)
+        {
+            regs[ins->a] = memBase + ins->imm();
+            VM_NEXT();
+        }
+        VM_CASE(LOAD)
+        {
+            int64_t addr = static_cast<int64_t>(regs[ins->b]) + regs[ins->c];
+            if (!checkAddress(addr))
+                return false;
+            regs[ins->a] = mem[addr];
+            VM_NEXT();
+        }
+        VM_CASE(STORE)
+        {
+            int64_t addr = static_cast<int64_t>(regs[ins->b]) + regs[ins->c];
+            if (!checkAddress(addr))
+                return false;
+            mem[addr] = regs[ins->a];
+            VM_NEXT();
+        }
+        VM_CASE(FILL)
+        {
+            int64_t begin = regs[ins->a];
+            int64_t count = regs[ins->c];
+            if (count > 0)
+            {
+                if (!checkAddress(begin) || !checkAddress(begin + count - 1))
+                    return false;
+                std::fill(mem + begin, mem + begin + count, regs[ins->b]);
+            }
+            VM_NEXT();
+        }
+
+        // 算术运算按 32 位补码回绕
+        VM_BINARY(ADD, VM_WRAP(+))
+        VM_BINARY(SUB, VM_WRAP(-))
+        VM_BINARY(MUL, VM_WRAP(*))
+        VM_CASE(DIV)
+        VM_CASE(MOD)
+        {
+            int32_t lhs = regs[ins->b], rhs = regs[ins->c];
+            if (rhs == 0)
+            {
+                error("Division by zero in function: " + func->name);
+                return false;
+            }
+            if (lhs == INT32_MIN && rhs == -1)
+                regs[ins->a] = ins->op == OpCode::DIV ? INT32_MIN : 0;
+            else
+                regs[ins->a] = ins->op == OpCode::DIV ? lhs / rhs : lhs % rhs;
+            VM_NEXT();
+        }
+        VM_BINARY(AND, lhs & rhs)
+        VM_BINARY(OR, lhs | rhs)
+        VM_BINARY(XOR, lhs ^ rhs)
+        VM_BINARY(SHL, static_cast<int32_t>(static_cast<uint32_t>(lhs) << (rhs & 31)))
+        VM_BINARY(SHR, lhs >> (rhs & 31))
+        VM_CASE(ADDI)
+        {
+            regs[ins->a] = static_cast<int32_t>(static_cast<uint32_t>(regs[ins->b]) + static_cast<uint32_t>(ins->sc()));
+            VM_NEXT();
+        }
+
+        VM_BINARY(EQ, lhs == rhs)
+        VM_BINARY(NE, lhs != rhs)
+        VM_BINARY(LT, lhs < rhs)
+        VM_BINARY(LE, lhs <= rhs)
+        VM_BINARY(GT, lhs > rhs)
+        VM_BINARY(GE, lhs >= rhs)
+
+        VM_CASE(NEG)
+        {
+            regs[ins->a] = static_cast<int32_t>(0u - static_cast<uint32_t>(regs[ins->b]));
+            VM_NEXT();
+        }
+        VM_CASE(NOT)
+        {
+            regs[ins->a] = !regs[ins->b];
+            VM_NEXT();
+        }
+        VM_CASE(BNOT)
+        {
+            regs[ins->a] = ~regs[ins->b];
+            VM_NEXT();
+        }
+        VM_CASE(BOOL)
+        {
+            regs[ins->a] = regs[ins->b] != 0;
+            VM_NEXT();
+        }
+        VM_CASE(SEXT8)
+        {
+            regs[ins->a] = static_cast<signed char>(regs[ins->b]);
+            VM_NEXT();
+        }
+
+        VM_CASE(JMP)
+        {
+            VM_JUMP(ins->imm());
+            VM_NEXT();
+        }
+        VM_CASE(JMPF)
+        {
+            if (regs[ins->a] == 0)
+                VM_JUMP(ins->imm());
+            VM_NEXT();
+        }
+        VM_CASE(JMPT)
+        {
+            if (regs[ins->a] != 0)
+                VM_JUMP(ins->imm());
+            VM_NEXT();
+        }
+
+        VM_CASE(CALL)
+        {
+            if (--hotness[ins->c] == 0)
+                tierUp(ins->c);
+
+            // 已编译为本地代码：直接调用，不建立解释器栈帧
+            if (NativeFunction native = nativeCode[ins->c])
+            {
+                regs[ins->a] = native(regs + ins->b, mem);
+                VM_NEXT();
+            }
+
+            const BytecodeFunction *callee = &functions[ins->c];
+            int32_t *calleeRegs = regs + ins->b;
+            int32_t calleeMemBase = memBase + func->frameSize;
+
+            if (frames.size() >= maxCallDepth || calleeRegs + callee->numRegs > regsEnd ||
+                calleeMemBase + callee->frameSize > memSize)
+            {
+                error("Stack overflow when calling function: " + callee->name);
+                return false;
+            }
+            if (calleeMemBase + callee->frameSize > memoryUsed)
+                memoryUsed = calleeMemBase + callee->frameSize;
+
+            frames.push_back({func, pc, regs, memBase, ins->a});
+            func = callee;
+            pc = codeOf(ins->c);
+            counter = &hotness[ins->c];
+            regs = calleeRegs;
+            memBase = calleeMemBase;
+            VM_NEXT();
+        }
+        VM_CASE(RET)
+        VM_CASE(RETV)
+        {
+            int32_t value = ins->op == OpCode::RET ? regs[ins->a] : 0;
+            if (frames.empty())
+            {
+                result = value;
+                return true;
+            }
+
+            const Frame &frame = frames.back();
+            func = frame.func;
+            pc = frame.returnPc;
+            counter = &hotness[func - functions];
+            regs = frame.regs;
+            memBase = frame.memBase;
+            regs[frame.dst] = value;
+            frames.pop_back();
+            VM_NEXT();
+        }
+
+#if !VM_USE_COMPUTED_GOTO
+        default:
+            error("Invalid opcode in function: " + func->name);
+            return false;
+        }
+#endif
+    }
+}
+
+#undef VM_WRAP
+#undef VM_JUMP
+#undef VM_BINARY
+#undef VM_NEXT
+#undef VM_CASE